@@ -88,7 +88,7 @@ uint8_t state;
 	// issue master reset pulse: set port low
 	set_1wire_low (hw_channel);
 	if (device==1) {	// DHT11
-		NutSleep (18);	// Min Low 18ms
+		xram_sleep (18);	// Min Low 18ms, keep bank of the cyclic element
 		return 0;
 	}
 	else if (device==2) {	// DHT2x
@@ -41,6 +41,10 @@ uint8_t al_get_mem (uint16_t maddr) {
 	if (maddr == MADDR_MANUF_BYTE) 
 		return 0xFF;
 
+	// stack and heap usage
+	if ((maddr >= MADDR_SYSMON) && (maddr < MADDR_SYSMON + SYSMON_MEM_SIZE))
+		return sysmon_get_mem (maddr - MADDR_SYSMON);
+
 	// no emulated memory location
 	return 0xff;
 }
@@ -429,8 +433,15 @@ void eib_set_route_counter (uint8_t new_counter)
 
 /**
 * @brief copies message into transmission buffer. Returns 1, if ok; returns 0, if buffer was full
+*
+* The TX thread is started by an event, other threads may select other XRAM
+* banks meanwhile. The bank of the calling thread is kept.
 */
 char eib_N_DATA_request(t_eib_frame* msg) {
+
+char	result;
+uint8_t	save_xram_page;
+
 	// insert the routing counter
 
 	((t_eib_message *)&(msg->frame))->NPCI |= eib_default_route_counter;
@@ -440,7 +451,10 @@ char eib_N_DATA_request(t_eib_frame* msg) {
 		printf_P(PSTR("%2.2X "), msg->frame[i]);
 	printf_P(PSTR("\n"));
 */
-	return eib_L_DATA_request(msg, EIB_DEVICE_CHANNEL);
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	result = eib_L_DATA_request(msg, EIB_DEVICE_CHANNEL);
+	XRAM_SELECT_BLOCK(save_xram_page);
+	return result;
 }
 
 /**
@@ -468,6 +482,10 @@ char eib_G_DATA_request(uint16_t address, uint8_t *data, uint8_t len) {
 
 t_eib_frame msg;
 
+	// object without send address
+	if (!address)
+		return 0;
+
 #ifdef EIB_VIRTUAL_MSG_SUPPORT
 	// virtual messages are queued internally
 	if (((address >> 3) & 0x1f) > MAX_EIB_MAIN_GROUP) {
@@ -494,6 +512,37 @@ t_eib_frame msg;
 	return eib_N_DATA_request (&msg);
 }
 
+/**
+* @brief request EIB group value read
+*
+* The response is processed like a write to the objects of the group address.
+* Returns 1, if the read request was queued or is not needed.
+*/
+char eib_G_READ_request(uint16_t address) {
+
+t_eib_frame msg;
+
+	// object without send address
+	if (!address)
+		return 0;
+
+#ifdef EIB_VIRTUAL_MSG_SUPPORT
+	// virtual objects are not on the bus
+	if (((address >> 3) & 0x1f) > MAX_EIB_MAIN_GROUP)
+		return 1;
+#endif
+
+	((t_eib_message*)&(msg.frame))->ctrl = 0xBC;
+	((t_eib_message*)&(msg.frame))->destination = address;
+	((t_eib_message*)&(msg.frame))->NPCI = 0x80 | 0x01;
+	((t_eib_message*)&(msg.frame))->TPCI = 0x00;
+	((t_eib_message*)&(msg.frame))->TSDU = (APCI_VALUE_READ & 0x03) << 6;
+
+	//set message length
+	msg.len = 8;
+	return eib_N_DATA_request (&msg);
+}
+
 /********************************/
 /* Layer 2 (Link Layer) support */
 /********************************/
@@ -524,8 +573,14 @@ uint8_t		*data;
 //														((t_eib_message*)&(msg.frame[0]))->destination,
 //														msg.len);
 		source = ((t_eib_message*)&(msg.frame))->source;
+		// measure bus load for the startup read of objects
+		read_sweep_bus_telegram ();
 		// show message to busmon (if active)
 		busmon_show (&msg);
+#ifdef EIBNET_SUPPORT
+		// forward message to the KNXnet/IP tunnel
+		eibnet_L_DATA_indication (&msg);
+#endif
 
 		// check, if frame is a group message
 		if (msg.frame[5] & 0x80) {
@@ -545,9 +600,9 @@ uint8_t		*data;
 			// forward message to object layer functions
 			if (eib_objects_process_msg (dest, data, len, apci)) {
 				// forward message to lcd functions
-				lcd_listen_process_msg (dest);
-				lcd_page_process_msg (dest);
-				lcd_listen_process_msg (dest);
+				lcd_listen_process_msg ();
+				lcd_page_process_msg ();
+				lcd_listen_process_msg ();
 			}
 /*
 			dest = ((t_eib_message*)&(msg.frame))->destination;
@@ -581,15 +636,19 @@ void init_eib_layers (void)
 {
 	eib_tl_state = CLOSED;
 	// register thread to dispatch messages from Link Layer
-	NutThreadCreate("EIBNLsrv", EIB_NL_Service, 0, NUT_THREAD_EIBSERVICE_STACK);
+	sysmon_thread_create("EIBNLsrv", EIB_NL_Service, 0, NUT_THREAD_EIBSERVICE_STACK);
 	// register thread for TL state machine
-	NutThreadCreate("EIBTLsrv", EIB_TL_Service, 0, NUT_THREAD_EIBSERVICE_STACK);
+	sysmon_thread_create("EIBTLsrv", EIB_TL_Service, 0, NUT_THREAD_EIBSERVICE_STACK);
 	// init the TPUART Link Layer driver
 	eib_control (EIB_INIT_CMD);
 	// init the physical address
 	init_physical_address_from_Flash ();
 	// init routing counter
 	eib_set_route_counter (EIB_DEFAULT_ROUTING_COUNTER);
+#ifdef EIBNET_SUPPORT
+	// start the KNXnet/IP tunneling server on the EIBNet/IP channel
+	eibnet_init ();
+#endif
 }
 
 /**
@@ -607,3 +666,17 @@ unsigned char eib_check_group_address (uint16_t addr) {
 	return 1;
 }
 
+/**
+* @brief function for LL driver to confirm a sent message
+*
+* channel = virtual device channel of the message
+* ok = 1: positive confirm of the TPUART, 0: negative or missing confirm
+*/
+void eib_L_DATA_confirm (uint8_t channel, uint8_t ok) {
+
+#ifdef EIBNET_SUPPORT
+	if (channel == EIB_EIBNET_CHANNEL)
+		eibnet_L_DATA_confirm (ok);
+#endif
+}
+
@@ -115,6 +115,7 @@ uint8_t		TSDU;
 #define MADDR_BCU_DATA_BYTE_1	0x102	
 #define MADDR_BCU_DATA_BYTE_2	0x103	
 #define MADDR_MANUF_BYTE		0x104	
+#define MADDR_SYSMON			0x400	// stack and heap usage, see sysmon.h
 
 // AL constants
 #define APCI_VALUE_READ			0x00
@@ -139,5 +140,7 @@ void eib_N_DATA_indication_wait (t_eib_frame*);
 unsigned char eib_check_group_address (uint16_t);
 // request EIB group message
 char eib_G_DATA_request(uint16_t, uint8_t*, uint8_t);
+// request EIB group value read
+char eib_G_READ_request(uint16_t);
 
 #endif // EIB_LAYERS_H_
@@ -0,0 +1,550 @@
+/** \file EIBNet.c
+ *  \brief KNXnet/IP tunneling server
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- KNXnet/IP tunneling server for one client on UDP port 3671
+ *	- bridge between the tunnel and the virtual device channel EIB_EIBNET_CHANNEL
+ *	- sequence counter and TUNNELLING_ACK handling in both directions
+ *	- heartbeat supervision of the client
+ *
+ *	The module is compiled only, if EIBNET_SUPPORT is defined. It requires an
+ *	Ethernet interface registered as DEV_ETHER.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "System.h"
+
+#ifdef EIBNET_SUPPORT
+
+#include <sys/socket.h>
+#include <net/if_var.h>
+#include <pro/dhcp.h>
+
+// timeout for DHCP configuration of the Ethernet interface
+#define EIBNET_DHCP_TIMEOUT		60000
+
+// message forwarded from the bus or confirmation for the tunnel client
+typedef struct {
+uint8_t		code;		// cEMI message code
+uint8_t		flags;		// cEMI ctrl1 flags added to the frame ctrl byte
+t_eib_frame	msg;
+} _EIBNET_QUEUE_ENTRY_t;
+
+static UDPSOCKET	*eibnet_sock;
+
+// state of the tunnel connection
+static uint8_t		eibnet_connected;
+static uint32_t		eibnet_ctrl_addr;		// control endpoint of the client
+static uint16_t		eibnet_ctrl_port;
+static uint32_t		eibnet_data_addr;		// data endpoint of the client
+static uint16_t		eibnet_data_port;
+static uint8_t		eibnet_rx_sequence;		// next expected sequence counter from the client
+static uint8_t		eibnet_tx_sequence;		// sequence counter of the server
+static uint32_t		eibnet_heartbeat_time;	// time of the last sign of life from the client
+static uint8_t		eibnet_ack_pending;
+static uint8_t		eibnet_ack_received;
+static HANDLE		eibnet_ack_event;
+
+// queue of messages for the tunnel client
+static _EIBNET_QUEUE_ENTRY_t eibnet_queue[EIBNET_IND_BUFFERS];
+static uint8_t		eibnet_queue_in, eibnet_queue_out;
+static HANDLE		eibnet_queue_event;
+
+// frames of the client sent to the bus, waiting for the L_Data.confirm of the TPUART
+typedef struct {
+uint8_t		connection;	// connection which sent the frame
+t_eib_frame	msg;
+} _EIBNET_CON_ENTRY_t;
+
+static _EIBNET_CON_ENTRY_t eibnet_con[EIBNET_CON_BUFFERS];
+static uint8_t		eibnet_con_in, eibnet_con_out;
+static uint8_t		eibnet_connection;		// counts the connections of clients
+
+// frame buffers of the server and the tunnel thread
+static uint8_t		eibnet_rx_frame[EIBNET_FRAME_SIZE];
+static uint8_t		eibnet_tx_frame[EIBNET_FRAME_SIZE];
+static uint8_t		eibnet_tunnel_frame[EIBNET_FRAME_SIZE];
+
+
+// fills the KNXnet/IP header
+static void eibnet_set_header (uint8_t *p, uint16_t service, uint16_t len) {
+
+	p[0] = EIBNET_HEADER_SIZE;
+	p[1] = EIBNET_PROTOCOL_VERSION;
+	p[2] = service >> 8;
+	p[3] = service & 0xff;
+	p[4] = len >> 8;
+	p[5] = len & 0xff;
+}
+
+// fills the host protocol address information of this server
+static void eibnet_set_hpai (uint8_t *p) {
+
+	p[0] = EIBNET_HPAI_SIZE;
+	p[1] = EIBNET_HPAI_UDP;
+	memcpy (&p[2], &((IFNET*) DEV_ETHER.dev_icb)->if_local_ip, 4);
+	p[6] = EIBNET_PORT >> 8;
+	p[7] = EIBNET_PORT & 0xff;
+}
+
+// gets the endpoint of a host protocol address information.
+// An empty HPAI (NAT mode) selects the sender of the request.
+static void eibnet_get_hpai (uint8_t *p, uint32_t src_addr, uint16_t src_port, uint32_t *addr, uint16_t *port) {
+
+	memcpy (addr, &p[2], 4);
+	*port = (p[6] << 8) | p[7];
+	if ((*addr == 0) || (*port == 0)) {
+		*addr = src_addr;
+		*port = src_port;
+	}
+}
+
+// puts a message into the queue for the tunnel client
+static void eibnet_queue_msg (uint8_t code, uint8_t flags, t_eib_frame *msg) {
+
+uint8_t	i;
+
+	i = eibnet_queue_in +1;
+	if (i >= EIBNET_IND_BUFFERS)
+		i = 0;
+	// client is too slow, drop the message
+	if (i == eibnet_queue_out)
+		return;
+
+	eibnet_queue[eibnet_queue_in].code = code;
+	eibnet_queue[eibnet_queue_in].flags = flags;
+	memcpy (&eibnet_queue[eibnet_queue_in].msg, msg, sizeof (t_eib_frame));
+	eibnet_queue_in = i;
+	NutEventPost (&eibnet_queue_event);
+}
+
+// sends a disconnect request to the client and closes the tunnel
+static void eibnet_disconnect (void) {
+
+uint8_t	p[EIBNET_HEADER_SIZE + 2 + EIBNET_HPAI_SIZE];
+
+	eibnet_connected = 0;
+	eibnet_set_header (p, EIBNET_DISCONNECT_REQUEST, sizeof (p));
+	p[6] = EIBNET_CHANNEL_ID;
+	p[7] = 0;
+	eibnet_set_hpai (&p[8]);
+	NutUdpSendTo (eibnet_sock, eibnet_ctrl_addr, eibnet_ctrl_port, p, sizeof (p));
+}
+
+// sends a response consisting of channel ID and status only
+static void eibnet_send_status (uint16_t service, uint8_t channel, uint8_t status, uint32_t addr, uint16_t port) {
+
+	eibnet_set_header (eibnet_tx_frame, service, EIBNET_HEADER_SIZE + 2);
+	eibnet_tx_frame[6] = channel;
+	eibnet_tx_frame[7] = status;
+	NutUdpSendTo (eibnet_sock, addr, port, eibnet_tx_frame, EIBNET_HEADER_SIZE + 2);
+}
+
+// sends a TUNNELLING_ACK for a request of the client
+static void eibnet_send_ack (uint8_t sequence, uint8_t status) {
+
+	eibnet_set_header (eibnet_tx_frame, EIBNET_TUNNELLING_ACK, EIBNET_HEADER_SIZE + EIBNET_CONNECTION_HEADER_SIZE);
+	eibnet_tx_frame[6] = EIBNET_CONNECTION_HEADER_SIZE;
+	eibnet_tx_frame[7] = EIBNET_CHANNEL_ID;
+	eibnet_tx_frame[8] = sequence;
+	eibnet_tx_frame[9] = status;
+	NutUdpSendTo (eibnet_sock, eibnet_data_addr, eibnet_data_port, eibnet_tx_frame, EIBNET_HEADER_SIZE + EIBNET_CONNECTION_HEADER_SIZE);
+}
+
+// process CONNECT_REQUEST
+// body: HPAI control endpoint, HPAI data endpoint, CRI
+static void eibnet_connect (uint8_t *p, int len, uint32_t addr, uint16_t port) {
+
+uint8_t		status;
+uint16_t	tunnel_address;
+uint32_t	ctrl_addr;
+uint16_t	ctrl_port;
+
+	if (len < EIBNET_HEADER_SIZE + 2*EIBNET_HPAI_SIZE + 4)
+		return;
+
+	eibnet_get_hpai (&p[6], addr, port, &ctrl_addr, &ctrl_port);
+
+	status = EIBNET_E_NO_ERROR;
+	if (p[23] != EIBNET_TUNNEL_CONNECTION)
+		status = EIBNET_E_CONNECTION_TYPE;
+	else if (p[24] != EIBNET_TUNNEL_LINKLAYER)
+		status = EIBNET_E_TUNNELLING_LAYER;
+	else if (eibnet_connected)
+		status = EIBNET_E_NO_MORE_CONNECTIONS;
+
+	if (status != EIBNET_E_NO_ERROR) {
+		eibnet_send_status (EIBNET_CONNECT_RESPONSE, 0, status, ctrl_addr, ctrl_port);
+		return;
+	}
+
+	// open the tunnel
+	eibnet_ctrl_addr = ctrl_addr;
+	eibnet_ctrl_port = ctrl_port;
+	eibnet_get_hpai (&p[14], addr, port, &eibnet_data_addr, &eibnet_data_port);
+	eibnet_rx_sequence = 0;
+	eibnet_tx_sequence = 0;
+	eibnet_heartbeat_time = NutGetSeconds ();
+	// drop messages of a previous connection
+	eibnet_queue_out = eibnet_queue_in;
+	eibnet_connection++;
+	eibnet_connected = 1;
+
+	// response: channel, status, HPAI data endpoint, CRD
+	eibnet_set_header (eibnet_tx_frame, EIBNET_CONNECT_RESPONSE, EIBNET_HEADER_SIZE + 2 + EIBNET_HPAI_SIZE + 4);
+	eibnet_tx_frame[6] = EIBNET_CHANNEL_ID;
+	eibnet_tx_frame[7] = EIBNET_E_NO_ERROR;
+	eibnet_set_hpai (&eibnet_tx_frame[8]);
+	tunnel_address = eib_get_device_address (EIB_EIBNET_CHANNEL);
+	eibnet_tx_frame[16] = 4;
+	eibnet_tx_frame[17] = EIBNET_TUNNEL_CONNECTION;
+	eibnet_tx_frame[18] = tunnel_address & 0xff;
+	eibnet_tx_frame[19] = tunnel_address >> 8;
+	NutUdpSendTo (eibnet_sock, eibnet_ctrl_addr, eibnet_ctrl_port, eibnet_tx_frame, EIBNET_HEADER_SIZE + 2 + EIBNET_HPAI_SIZE + 4);
+}
+
+// converts a cEMI L_Data.req into a TPUART frame and sends it to the bus.
+// The client receives the L_Data.con, when the TPUART has confirmed the frame.
+// A frame which can not be queued is confirmed negative at once.
+static void eibnet_cemi_request (uint8_t *p, int len) {
+
+t_eib_frame	msg;
+uint8_t		i, l;
+
+	if ((len < 2) || (p[0] != CEMI_L_DATA_REQ))
+		return;
+	// skip additional info
+	i = 2 + p[1];
+	if (len < i + 8)
+		return;
+	// length of APDU without TPCI
+	l = p[i+6];
+	if ((l > FRAME_LEN - 8) || (len < i + 8 + l))
+		return;
+
+	// std. frame, not repeated, priority of the client
+	msg.frame[0] = 0xB0 | (p[i] & CEMI_CTRL1_PRIORITY_MASK);
+	// source address is inserted by the Link Layer
+	msg.frame[EIB_DEST_ADDRESS_HIGH] = p[i+4];
+	msg.frame[EIB_DEST_ADDRESS_LOW] = p[i+5];
+	// address type, routing counter and length
+	msg.frame[5] = (p[i+1] & 0xF0) | l;
+	memcpy (&msg.frame[TPDU_POSITION], &p[i+7], l+1);
+	msg.len = l + 7;
+	// the confirmation shows the source address inserted by the Link Layer
+	msg.frame[EIB_SRC_ADDRESS_HIGH] = eib_get_device_address (EIB_EIBNET_CHANNEL) & 0xff;
+	msg.frame[EIB_SRC_ADDRESS_LOW] = eib_get_device_address (EIB_EIBNET_CHANNEL) >> 8;
+
+	// the TPUART confirms the frames of the channel in the order of the requests.
+	// The buffer holds more frames than the TX queue of the channel, so it is never
+	// full after a successful request.
+	i = eibnet_con_in +1;
+	if (i >= EIBNET_CON_BUFFERS)
+		i = 0;
+	if ((i != eibnet_con_out) && (eib_L_DATA_request (&msg, EIB_EIBNET_CHANNEL) == 1)) {
+		eibnet_con[eibnet_con_in].connection = eibnet_connection;
+		memcpy (&eibnet_con[eibnet_con_in].msg, &msg, sizeof (t_eib_frame));
+		eibnet_con_in = i;
+		return;
+	}
+
+	eibnet_queue_msg (CEMI_L_DATA_CON, CEMI_CTRL1_CONFIRM_ERROR, &msg);
+}
+
+// converts a queued TPUART frame into a cEMI message. Returns the cEMI length.
+static uint8_t eibnet_build_cemi (uint8_t *p, _EIBNET_QUEUE_ENTRY_t *e) {
+
+uint8_t	l;
+
+	l = e->msg.frame[5] & 0x0f;
+	p[0] = e->code;
+	// no additional info
+	p[1] = 0;
+	p[2] = (e->msg.frame[0] & 0xBC) | e->flags;
+	p[3] = e->msg.frame[5] & 0xF0;
+	memcpy (&p[4], &e->msg.frame[EIB_SRC_ADDRESS_HIGH], 4);
+	p[8] = l;
+	memcpy (&p[9], &e->msg.frame[TPDU_POSITION], l+1);
+
+	return 10 + l;
+}
+
+// process TUNNELLING_REQUEST from the client
+static void eibnet_tunnelling_request (uint8_t *p, int len) {
+
+uint8_t	sequence;
+
+	if (len < EIBNET_HEADER_SIZE + EIBNET_CONNECTION_HEADER_SIZE + 2)
+		return;
+	if ((!eibnet_connected) || (p[7] != EIBNET_CHANNEL_ID))
+		return;
+
+	sequence = p[8];
+	// repeated request: our ACK got lost, acknowledge again but do not forward
+	if (sequence == (uint8_t)(eibnet_rx_sequence -1)) {
+		eibnet_send_ack (sequence, EIBNET_E_NO_ERROR);
+		return;
+	}
+	// out of sequence, discard without ACK
+	if (sequence != eibnet_rx_sequence)
+		return;
+
+	eibnet_send_ack (sequence, EIBNET_E_NO_ERROR);
+	eibnet_rx_sequence++;
+	eibnet_heartbeat_time = NutGetSeconds ();
+
+	eibnet_cemi_request (&p[EIBNET_HEADER_SIZE + EIBNET_CONNECTION_HEADER_SIZE], len - EIBNET_HEADER_SIZE - EIBNET_CONNECTION_HEADER_SIZE);
+}
+
+// process TUNNELLING_ACK from the client
+static void eibnet_tunnelling_ack (uint8_t *p, int len) {
+
+	if (len < EIBNET_HEADER_SIZE + EIBNET_CONNECTION_HEADER_SIZE)
+		return;
+	if ((!eibnet_connected) || (p[7] != EIBNET_CHANNEL_ID) || (!eibnet_ack_pending))
+		return;
+	if (p[8] != eibnet_tx_sequence)
+		return;
+
+	eibnet_ack_pending = 0;
+	eibnet_ack_received = (p[9] == EIBNET_E_NO_ERROR);
+	NutEventPost (&eibnet_ack_event);
+}
+
+
+// process a frame received from the client, len <= 0 after a receive timeout
+static void eibnet_process_frame (uint8_t *p, int len, uint32_t addr, uint16_t port) {
+
+uint16_t	service;
+
+	// check the heartbeat of the client
+	if (eibnet_connected && (NutGetSeconds () - eibnet_heartbeat_time > EIBNET_HEARTBEAT_TIMEOUT))
+		eibnet_disconnect ();
+
+	// check header
+	if (len < EIBNET_HEADER_SIZE)
+		return;
+	if ((p[0] != EIBNET_HEADER_SIZE) || (p[1] != EIBNET_PROTOCOL_VERSION) || (((p[4] << 8) | p[5]) != len))
+		return;
+
+	service = (p[2] << 8) | p[3];
+	switch (service) {
+		case EIBNET_CONNECT_REQUEST:
+			eibnet_connect (p, len, addr, port);
+		break;
+		case EIBNET_CONNECTIONSTATE_REQUEST:
+			if (len < EIBNET_HEADER_SIZE + 2 + EIBNET_HPAI_SIZE)
+				break;
+			eibnet_get_hpai (&p[8], addr, port, &addr, &port);
+			if (eibnet_connected && (p[6] == EIBNET_CHANNEL_ID)) {
+				eibnet_heartbeat_time = NutGetSeconds ();
+				eibnet_send_status (EIBNET_CONNECTIONSTATE_RESPONSE, p[6], EIBNET_E_NO_ERROR, addr, port);
+			}
+			else eibnet_send_status (EIBNET_CONNECTIONSTATE_RESPONSE, p[6], EIBNET_E_CONNECTION_ID, addr, port);
+		break;
+		case EIBNET_DISCONNECT_REQUEST:
+			if (len < EIBNET_HEADER_SIZE + 2 + EIBNET_HPAI_SIZE)
+				break;
+			eibnet_get_hpai (&p[8], addr, port, &addr, &port);
+			if (eibnet_connected && (p[6] == EIBNET_CHANNEL_ID)) {
+				eibnet_connected = 0;
+				eibnet_send_status (EIBNET_DISCONNECT_RESPONSE, p[6], EIBNET_E_NO_ERROR, addr, port);
+			}
+			else eibnet_send_status (EIBNET_DISCONNECT_RESPONSE, p[6], EIBNET_E_CONNECTION_ID, addr, port);
+		break;
+		case EIBNET_TUNNELLING_REQUEST:
+			eibnet_tunnelling_request (p, len);
+		break;
+		case EIBNET_TUNNELLING_ACK:
+			eibnet_tunnelling_ack (p, len);
+		break;
+	}
+}
+
+
+/**
+ * @brief KNXnet/IP server thread
+ *
+ * This thread configures the Ethernet interface and processes all requests
+ * of the tunnel client. The receive timeout is used to supervise the heartbeat
+ * of the client.
+ *
+ */
+THREAD(EIBNet_Server, arg)
+{
+
+int			len;
+uint32_t	addr;
+uint16_t	port;
+uint8_t		*p;
+
+	NutThreadSetPriority(NUT_THREAD_PRIORITY_EIBNET);
+
+	// configure the Ethernet interface
+	if (NutRegisterDevice (&DEV_ETHER, 0, 0) || NutDhcpIfConfig (DEV_ETHER_NAME, 0, EIBNET_DHCP_TIMEOUT)) {
+#ifdef LCD_DEBUG
+		printf_P (PSTR("EIBnet: no network\n"));
+#endif
+		NutThreadExit ();
+	}
+	eibnet_sock = NutUdpCreateSocket (EIBNET_PORT);
+	if (!eibnet_sock)
+		NutThreadExit ();
+
+	p = eibnet_rx_frame;
+	for (;;) {
+		len = NutUdpReceiveFrom (eibnet_sock, &addr, &port, p, EIBNET_FRAME_SIZE, EIBNET_RX_TIMEOUT);
+		eibnet_process_frame (p, len, addr, port);
+	}
+}
+
+
+// sends the next queued message to the client and waits for its ACK
+static void eibnet_send_queued (void) {
+
+_EIBNET_QUEUE_ENTRY_t	*e;
+uint8_t		len;
+uint8_t		tries;
+
+	e = &eibnet_queue[eibnet_queue_out];
+	if (eibnet_connected) {
+
+		len = EIBNET_HEADER_SIZE + EIBNET_CONNECTION_HEADER_SIZE;
+		len += eibnet_build_cemi (&eibnet_tunnel_frame[len], e);
+		eibnet_set_header (eibnet_tunnel_frame, EIBNET_TUNNELLING_REQUEST, len);
+		eibnet_tunnel_frame[6] = EIBNET_CONNECTION_HEADER_SIZE;
+		eibnet_tunnel_frame[7] = EIBNET_CHANNEL_ID;
+		eibnet_tunnel_frame[8] = eibnet_tx_sequence;
+		eibnet_tunnel_frame[9] = 0;
+
+		eibnet_ack_received = 0;
+		for (tries = 0; (tries < 2) && (!eibnet_ack_received) && eibnet_connected; tries++) {
+			eibnet_ack_pending = 1;
+			NutUdpSendTo (eibnet_sock, eibnet_data_addr, eibnet_data_port, eibnet_tunnel_frame, len);
+			NutEventWait (&eibnet_ack_event, EIBNET_ACK_TIMEOUT);
+		}
+		eibnet_ack_pending = 0;
+
+		if (eibnet_ack_received)
+			eibnet_tx_sequence++;
+		else if (eibnet_connected)
+			eibnet_disconnect ();
+	}
+
+	// next message
+	if (++eibnet_queue_out >= EIBNET_IND_BUFFERS)
+		eibnet_queue_out = 0;
+}
+
+
+/**
+ * @brief KNXnet/IP tunnel thread
+ *
+ * This thread forwards the queued bus messages and confirmations to the client.
+ * Each TUNNELLING_REQUEST is repeated once, if the client does not acknowledge
+ * it in time. A second missing ACK closes the tunnel.
+ *
+ */
+THREAD(EIBNet_Tunnel, arg)
+{
+
+	NutThreadSetPriority(NUT_THREAD_PRIORITY_EIBNET);
+
+	for (;;) {
+
+		if (eibnet_queue_in == eibnet_queue_out) {
+			NutEventWait (&eibnet_queue_event, NUT_WAIT_INFINITE);
+			continue;
+		}
+		eibnet_send_queued ();
+	}
+}
+
+
+/**
+* @brief forward the L_Data.confirm of the TPUART to the tunnel client
+*
+* The TPUART confirms the frames of the EIBNet/IP channel in the order they
+* were requested, so the oldest pending frame is confirmed. Frames of a closed
+* connection are not confirmed to a new client.
+*/
+void eibnet_L_DATA_confirm (uint8_t ok) {
+
+_EIBNET_CON_ENTRY_t	*e;
+
+	if (eibnet_con_in == eibnet_con_out)
+		return;
+
+	e = &eibnet_con[eibnet_con_out];
+	if (eibnet_connected && (e->connection == eibnet_connection))
+		eibnet_queue_msg (CEMI_L_DATA_CON, ok ? 0 : CEMI_CTRL1_CONFIRM_ERROR, &e->msg);
+	if (++eibnet_con_out >= EIBNET_CON_BUFFERS)
+		eibnet_con_out = 0;
+}
+
+/**
+* @brief forward a message received from the bus to the tunnel client
+*
+* Messages sent by the tunnel itself are confirmed to the client by
+* eibnet_L_DATA_confirm(), so they are not indicated again.
+*/
+void eibnet_L_DATA_indication (t_eib_frame* msg) {
+
+	if (!eibnet_connected)
+		return;
+
+	if ((msg->frame[EIB_SRC_ADDRESS_HIGH] | (msg->frame[EIB_SRC_ADDRESS_LOW] << 8)) == eib_get_device_address (EIB_EIBNET_CHANNEL))
+		return;
+
+	eibnet_queue_msg (CEMI_L_DATA_IND, 0, msg);
+}
+
+/**
+* @brief individual address of the tunnel
+*
+* The tunnel uses its own individual address on the virtual device channel
+* EIB_EIBNET_CHANNEL. It is a device of the line of the panel: the device
+* number EIBNET_TUNNEL_DEVICE, if defined, or the next device number of the
+* panel. Device number 0 is skipped, it is reserved for the line coupler.
+*/
+uint16_t eibnet_tunnel_address (uint16_t device_address) {
+
+uint8_t	device;
+
+#ifdef EIBNET_TUNNEL_DEVICE
+	device = EIBNET_TUNNEL_DEVICE;
+#else
+	device = (device_address >> 8) +1;
+	if (!device)
+		device = 1;
+#endif
+	// area and line are stored in the low byte
+	return (device_address & 0x00ff) | ((uint16_t) device << 8);
+}
+
+/**
+* @brief start the KNXnet/IP tunneling server
+*
+* It must be called after the physical address of the device channel has
+* been set by init_physical_address_from_Flash(), which sets the tunnel
+* address as well.
+*/
+void eibnet_init (void) {
+
+	eibnet_connected = 0;
+	eibnet_queue_in = 0;
+	eibnet_queue_out = 0;
+	eibnet_con_in = 0;
+	eibnet_con_out = 0;
+
+	sysmon_thread_create ("EIBNETsrv", EIBNet_Server, 0, NUT_THREAD_EIBNET_STACK);
+	sysmon_thread_create ("EIBNETtun", EIBNet_Tunnel, 0, NUT_THREAD_EIBNET_STACK);
+}
+
+#endif // EIBNET_SUPPORT
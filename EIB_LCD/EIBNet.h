@@ -0,0 +1,86 @@
+/** \file EIBNet.h
+ *  \brief Constants and definitions for the KNXnet/IP tunneling server
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _EIBNET_H_
+#define _EIBNET_H_
+
+#include "System.h"
+
+// UDP port of the KNXnet/IP server
+#define EIBNET_PORT					3671
+
+// KNXnet/IP header
+#define EIBNET_HEADER_SIZE			6
+#define EIBNET_PROTOCOL_VERSION		0x10
+#define EIBNET_HPAI_SIZE			8
+#define EIBNET_HPAI_UDP				0x01
+#define EIBNET_CONNECTION_HEADER_SIZE	4
+
+// KNXnet/IP service types
+#define EIBNET_CONNECT_REQUEST			0x0205
+#define EIBNET_CONNECT_RESPONSE			0x0206
+#define EIBNET_CONNECTIONSTATE_REQUEST	0x0207
+#define EIBNET_CONNECTIONSTATE_RESPONSE	0x0208
+#define EIBNET_DISCONNECT_REQUEST		0x0209
+#define EIBNET_DISCONNECT_RESPONSE		0x020A
+#define EIBNET_TUNNELLING_REQUEST		0x0420
+#define EIBNET_TUNNELLING_ACK			0x0421
+
+// connection request information
+#define EIBNET_TUNNEL_CONNECTION		0x04
+#define EIBNET_TUNNEL_LINKLAYER			0x02
+
+// KNXnet/IP status codes
+#define EIBNET_E_NO_ERROR				0x00
+#define EIBNET_E_SEQUENCE_NUMBER		0x04
+#define EIBNET_E_CONNECTION_ID			0x21
+#define EIBNET_E_CONNECTION_TYPE		0x22
+#define EIBNET_E_CONNECTION_OPTION		0x23
+#define EIBNET_E_NO_MORE_CONNECTIONS	0x24
+#define EIBNET_E_TUNNELLING_LAYER		0x29
+
+// cEMI message codes
+#define CEMI_L_DATA_REQ					0x11
+#define CEMI_L_DATA_CON					0x2E
+#define CEMI_L_DATA_IND					0x29
+// cEMI ctrl1 flags
+#define CEMI_CTRL1_CONFIRM_ERROR		0x01
+#define CEMI_CTRL1_PRIORITY_MASK		0x0C
+
+// the one and only tunnel uses this channel ID
+#define EIBNET_CHANNEL_ID				1
+// max. size of a KNXnet/IP frame exchanged with the client
+#define EIBNET_FRAME_SIZE				(EIBNET_HEADER_SIZE + EIBNET_CONNECTION_HEADER_SIZE + 2 + FRAME_LEN)
+// number of bus messages buffered for the tunnel client
+#define EIBNET_IND_BUFFERS				4
+// frames waiting for the L_Data.confirm: the TX queue of the channel and the frame
+// in transmission, +1 for the unused entry of the ring buffer
+#define EIBNET_CON_BUFFERS				(EIB_TX_BUFFERS +1)
+
+// timeouts
+#define EIBNET_RX_TIMEOUT				1000	// 1s housekeeping interval of the receiver
+#define EIBNET_ACK_TIMEOUT				1000	// 1s for the TUNNELLING_ACK of the client
+#define EIBNET_HEARTBEAT_TIMEOUT		120		// 120s without CONNECTIONSTATE_REQUEST
+
+// the tunnel uses the device number of the panel +1 as individual address,
+// define EIBNET_TUNNEL_DEVICE to select a fixed device number in the line of the panel
+//#define EIBNET_TUNNEL_DEVICE			250
+
+// start the KNXnet/IP tunneling server
+void eibnet_init (void);
+// individual address of the tunnel in the line of the device address
+uint16_t eibnet_tunnel_address (uint16_t);
+// forward a message received from the bus to the tunnel client
+void eibnet_L_DATA_indication (t_eib_frame*);
+// forward the L_Data.confirm of a frame of the tunnel client, 1: positive confirm
+void eibnet_L_DATA_confirm (uint8_t);
+
+#endif // _EIBNET_H_
@@ -4,7 +4,11 @@
  *
  *	Implemented functions:
  *	- EIB object value treatment
- *		max. object length is 4 bytes
+ *		object values are packed into the object arena in XRAM,
+ *		the size of each object is defined by the object size table
+ *	- consistent reads of multi byte values
+ *		the sequence counter of an object is odd, while its value is written.
+ *		Readers copy the value and retry, if the counter was odd or has changed.
  *
  *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
  *
@@ -14,146 +18,328 @@
  *
  */
 #include "EIBObjects.h"
-#include "math.h"
 
-// clear all eib objject values
+// objects addressed by the last group message
+uint16_t eib_msg_objects[EIB_MAX_MSG_OBJECTS];
+uint8_t eib_msg_object_count;
+// objects, whose value has been changed by the last group message
+uint8_t eib_object_dirty[EIB_MAX_OBJECTS/8];
+
+// number of entries in the object size table
+uint16_t object_size_count;
+// number of objects located in the arena
+uint16_t eib_object_count;
+// used size of the arena
+uint16_t eib_object_arena_used;
+
+// moves object size table from Flash into RAM.
+// flash offset: start address in Flash
+// size: size of object size table in Byte
+uint8_t move_object_sizes (uint32_t flash_offset, uint32_t size) {
+
+uint32_t	crc;
+
+	object_size_count = 0;
+
+	// one byte per object
+	if (size > EIB_MAX_OBJECTS)
+		return 2;
+
+	crc = CRC32_INIT;
+	copy_Flash_to_XRAM_check ((flash_offset >> 16) & 0xff, flash_offset & 0xffff, XRAM_OBJECT_SIZE_ADDR, size, &crc, NULL);
+	if (crc_verify (flash_offset, size, crc, flash_offset + size) == CRC_ERROR)
+		return 1;
+	object_size_count = size;
+
+	return 0;
+}
+
+// forget object size table of previous project
+void eib_object_clear_sizes (void) {
+
+	object_size_count = 0;
+}
+
+// build object arena and clear all eib objject values
 void eib_object_init () {
 
-	// set object value bank
+uint16_t	*po;
+uint8_t		*ps;
+uint16_t	offset;
+uint16_t	i;
+uint8_t		size;
+
+	// set object table bank
 	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
+	po = (uint16_t*) (XRAM_BASE_ADDRESS + EIB_OBJECT_OFFSET_TABLE);
+	ps = (uint8_t*) (XRAM_BASE_ADDRESS + EIB_OBJECT_SIZE_TABLE);
+
+	// pack all objects into the arena, an object never crosses a bank boundary
+	offset = 0;
+	eib_object_count = 0;
+	for (i = 0; i < get_object_count (); i++) {
+		// projects without size table use 4 bytes per object
+		size = EIB_OBJECT_DATA_SIZE;
+		if (i < object_size_count) {
+			// 1 bit and 4 bit objects need 1 byte
+			size = max (ps[i], 1);
+			size = min (size, EIB_OBJECT_MAX_SIZE);
+		}
+		if ((offset % XRAM_BANK_SIZE) + size > XRAM_BANK_SIZE)
+			offset += XRAM_BANK_SIZE - (offset % XRAM_BANK_SIZE);
+		if (offset + size > EIB_OBJECT_ARENA_SIZE)
+			break;
+		ps[i] = size;
+		po[i] = offset;
+		offset += size;
+		eib_object_count++;
+	}
+
+	eib_object_arena_used = offset;
+
+	// no value is written
+	memset ((void*) (XRAM_BASE_ADDRESS + EIB_OBJECT_SEQ_TABLE), 0x00, EIB_MAX_OBJECTS);
+
 	// clear all object values
-	memset((void*) XRAM_BASE_ADDRESS, 0x00, EIB_OBJECT_DATA_SIZE * get_address_tab_length());
+	for (i = 0; i * XRAM_BANK_SIZE < offset; i++) {
+		XRAM_SELECT_BLOCK(XRAM_OBJECT_ARENA_PAGE + i);
+		memset((void*) XRAM_BASE_ADDRESS, 0x00, XRAM_BANK_SIZE);
+	}
+
+	eib_msg_object_count = 0;
+	memset (eib_object_dirty, 0x00, sizeof (eib_object_dirty));
+}
+
+// get used size of the object arena
+uint16_t eib_object_arena_size (void) {
+
+	return eib_object_arena_used;
+}
+
+// selects the arena bank of an object
+// returns pointer to the object data, NULL if the object does not exist
+static uint8_t* eib_object_data_ptr (uint16_t object, uint8_t *size) {
+
+uint16_t	offset;
 
+	if (object >= eib_object_count)
+		return NULL;
+
+	// set object table bank
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
+	offset = ((uint16_t*) (XRAM_BASE_ADDRESS + EIB_OBJECT_OFFSET_TABLE))[object];
+	*size = ((uint8_t*) (XRAM_BASE_ADDRESS + EIB_OBJECT_SIZE_TABLE))[object];
+
+	// set object value bank
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_ARENA_PAGE + offset / XRAM_BANK_SIZE);
+	return (uint8_t*) (XRAM_BASE_ADDRESS + offset % XRAM_BANK_SIZE);
+}
+
+// get sequence counter of an object
+static uint8_t eib_object_seq_get (uint16_t object) {
+
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
+	return ((volatile uint8_t*) (XRAM_BASE_ADDRESS + EIB_OBJECT_SEQ_TABLE))[object];
 }
 
+// increment sequence counter of an object before and after writing its value
+static void eib_object_seq_inc (uint16_t object) {
 
-// update object values
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
+	((volatile uint8_t*) (XRAM_BASE_ADDRESS + EIB_OBJECT_SEQ_TABLE))[object]++;
+}
+
+// update values of all objects associated with the group address
 // 0: no object updated
+// n: number of updated objects
 uint8_t eib_objects_process_msg (uint16_t address, uint8_t *data, uint8_t len, uint8_t apci) {
 
-int object;
-_EIB_OBJECT_DATA_t*	p;
+uint8_t	i, j;
+uint8_t	*p;
+uint8_t	size;
+uint8_t	b;
+uint8_t	changed;
 
-	// get object #
-	object = get_group_adress_index (address);
-	// check object #
-	if ((object < 0) || (object >= get_address_tab_length()))
-		return 0;
+	// the previous message has been processed
+	for (i = 0; i < eib_msg_object_count; i++)
+		eib_object_dirty[eib_msg_objects[i] >> 3] &= ~(1 << (eib_msg_objects[i] & 0x07));
+
+	eib_msg_object_count = 0;
 	if (!( (apci == APCI_VALUE_RESPONSE) || (apci == APCI_VALUE_WRITE) ))
 		return 0;
 
-	// copy new data to object
-	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
-	p = (_EIB_OBJECT_DATA_t*) XRAM_BASE_ADDRESS;
-	p += object;
-	p->d0 = *data++;
-	
-	// FIXME: evaluate length
-	p->d1 = *data++;
-	p->d2 = *data++;
-	p->d3 = *data;
+	// get object #s
+	eib_msg_object_count = get_associated_objects (address, eib_msg_objects, EIB_MAX_MSG_OBJECTS);
+
+	// 1 bit and 4 bit values are part of the APCI
+	if (!len)
+		len = 1;
+
+	// copy new data to objects
+	for (i = 0; i < eib_msg_object_count; i++) {
+		// object has a value now, no need to read it
+		read_sweep_object_received (eib_msg_objects[i]);
+		// readers retry, while the value is written
+		eib_object_seq_inc (eib_msg_objects[i]);
+		p = eib_object_data_ptr (eib_msg_objects[i], &size);
+		if (!p)
+			size = 0;
+		// copy exact length, clear the rest of a short message
+		changed = 0;
+		for (j = 0; j < size; j++) {
+			b = (j < len) ? data[j] : 0x00;
+			if (p[j] != b) {
+				p[j] = b;
+				changed = 1;
+			}
+		}
+		eib_object_seq_inc (eib_msg_objects[i]);
+		// mark object as dirty, if the value has changed
+		if (changed) {
+			eib_object_dirty[eib_msg_objects[i] >> 3] |= 1 << (eib_msg_objects[i] & 0x07);
+			snapshot_object_changed ();
+		}
+	}
 
-	return 1;
+	return eib_msg_object_count;
 }
 
+// check, if object has been addressed by the last group message
+// 0: object not addressed
+uint8_t eib_object_addressed (uint16_t object) {
 
+uint8_t	i;
 
-// returns value of 8 bit objects
-uint8_t eib_get_object_8_value (uint8_t object) {
+	for (i = 0; i < eib_msg_object_count; i++)
+		if (eib_msg_objects[i] == object)
+			return 1;
 
-_EIB_OBJECT_DATA_t*	p;
+	return 0;
+}
 
-	p = (_EIB_OBJECT_DATA_t*) XRAM_BASE_ADDRESS;
-	p += object;
+// get objects addressed by the last group message
+// returns the number of objects
+uint8_t eib_get_msg_objects (uint16_t **objects) {
 
-	// set object value bank
-	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
+	*objects = eib_msg_objects;
+	return eib_msg_object_count;
+}
+
+// check, if the value of the object has been changed by the last group message
+// 0: object not changed
+uint8_t eib_object_changed (uint16_t object) {
 
-	return p->d0;
+	return (eib_object_dirty[object >> 3] & (1 << (object & 0x07))) != 0;
+}
+
+// check, if element must be updated
+// force: element reacts to every write of the object
+uint8_t eib_object_updated (uint16_t object, uint8_t force) {
 
+	if (force)
+		return eib_object_addressed (object);
+	return eib_object_changed (object);
+}
+
+// returns value of 8 bit objects
+// the bank of the caller is kept
+uint8_t eib_get_object_8_value (uint16_t object) {
+
+uint8_t	*p;
+uint8_t	size;
+uint8_t	value;
+uint8_t	save_xram_page;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	p = eib_object_data_ptr (object, &size);
+	value = p ? *p : 0;
+	XRAM_SELECT_BLOCK(save_xram_page);
+
+	return value;
 }
 
 // returns value of 2 byte objects
-uint16_t eib_get_object_16_value (uint8_t object) {
+uint16_t eib_get_object_16_value (uint16_t object) {
 
-_EIB_OBJECT_DATA_t*	p;
+uint8_t		data[2];
 uint16_t	result;
 
-	p = (_EIB_OBJECT_DATA_t*) XRAM_BASE_ADDRESS;
-	p += object;
+	eib_get_object_data (object, data, 2);
 
-	// set object value bank
-	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
-
-	result = p->d0;
-	result = p->d1 | (result << 8);
+	result = data[0];
+	result = data[1] | (result << 8);
 
 	return result;
-
 }
 
 // returns value of 32 byte objects
-uint32_t eib_get_object_32_value (uint8_t object) {
+uint32_t eib_get_object_32_value (uint16_t object) {
 
-_EIB_OBJECT_DATA_t*	p;
+uint8_t		data[4];
 uint32_t	result;
 
-	p = (_EIB_OBJECT_DATA_t*) XRAM_BASE_ADDRESS;
-	p += object;
+	eib_get_object_data (object, data, 4);
 
-	// set object value bank
-	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
-
-	result = p->d0;
-	result = p->d1 | (result << 8);
-	result = p->d2 | (result << 8);
-	result = p->d3 | (result << 8);
+	result = data[0];
+	result = data[1] | (result << 8);
+	result = data[2] | (result << 8);
+	result = data[3] | (result << 8);
 
 	return result;
-
 }
 
-float eib_get_object_EIS5_value (uint8_t object) {
+// copies data of object
+// max: size of the buffer, bytes beyond the object size are set to 0
+// returns the size of the object, the bank of the caller is kept
+uint8_t eib_get_object_data (uint16_t object, uint8_t *data, uint8_t max) {
+
+uint8_t	*p;
+uint8_t	size;
+uint8_t	seq;
+uint8_t	save_xram_page;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	memset (data, 0x00, max);
+	for (;;) {
+		seq = eib_object_seq_get (object);
+		// let the writer finish
+		if (seq & 0x01) {
+			xram_yield ();
+			continue;
+		}
+		p = eib_object_data_ptr (object, &size);
+		if (!p) {
+			size = 0;
+			break;
+		}
+
+		memcpy (data, p, min (size, max));
+		// value has not been written while copying
+		if (eib_object_seq_get (object) == seq)
+			break;
+	}
+	XRAM_SELECT_BLOCK(save_xram_page);
+	return size;
+}
 
-uint16_t val;
-float fval;
-int16_t	x;
-uint8_t	exp;
+// returns value of object decoded as DPT
+int32_t eib_get_object_value (uint16_t object, uint8_t dpt) {
 
-	val = eib_get_object_16_value (object);
-	x = val & 0x7ff;
-	if (val & 0x8000) {
-		x |= 0xf800;
-	}
-	exp = (val >> 11) & 0x0f;
-	fval = ldexp (x, exp) / 100;			
+uint8_t	data[DPT_MAX_SIZE];
 
-	return fval;
+	eib_get_object_data (object, data, DPT_MAX_SIZE);
+	return dpt_decode (dpt, data);
 }
 
-// sends value of EIS5 float objects
-void eib_set_object_EIS5_value (uint16_t address, float fval) {
-										
-uint8_t	eib_value[2];
-uint8_t	exp;
-int16_t ival;
+// sends value encoded as DPT
+char eib_set_object_value (uint16_t address, uint8_t dpt, int32_t value) {
 
-	// process sign
-	if (fval >= 0)
-		eib_value [0] = 0x00;
-	else eib_value [0] = 0x80;
+uint8_t	eib_value[DPT_MAX_SIZE];
+uint8_t	len;
 
-	exp = 0;
-	while ((fval > MAX_EIS5_MANTISSA) || (fval < MIN_EIS5_MANTISSA)) {
-		exp++;
-		fval /= 2;
-	}
-	eib_value[0] |= (exp << 3) & 0x78;
-	ival = round (100*fval);
-	eib_value[1] = ival & 0xff;
-	eib_value[0] |= (ival >> 8) & 0x07;
+	len = dpt_encode (dpt, value, eib_value);
 
 	// send value to EIB object
-	eib_G_DATA_request (address, eib_value, 2);
+	return eib_G_DATA_request (address, eib_value, len);
 }
 
@@ -14,35 +14,58 @@
 
 #include "System.h"
 
-/**
-* @brief EIB objects description
-*/
-typedef struct __attribute__ ((packed)) {
-uint8_t		d0;	// object data 0
-uint8_t		d1;	// object data 1
-uint8_t		d2;	// object data 2
-uint8_t		d3;	// object data 3
-} _EIB_OBJECT_DATA_t;
-
-// EIB objects allocate 4 bytes data
+// max. number of objects
+#define EIB_MAX_OBJECTS			1024
+
+// EIB objects allocate 4 bytes data, if the project has no object size table
 #define EIB_OBJECT_DATA_SIZE	4
+// max. size of an object
+#define EIB_OBJECT_MAX_SIZE		DPT_MAX_SIZE
+
+// object tables in the object value bank
+#define EIB_OBJECT_OFFSET_TABLE	0x0000	// uint16_t arena offset of each object
+#define EIB_OBJECT_SIZE_TABLE	(EIB_OBJECT_OFFSET_TABLE + 2*EIB_MAX_OBJECTS)	// uint8_t size of each object
+#define XRAM_OBJECT_SIZE_ADDR	XRAM_OBJECT_VALUE_PAGE,EIB_OBJECT_SIZE_TABLE
+#define EIB_OBJECT_SEQ_TABLE	(EIB_OBJECT_SIZE_TABLE + EIB_MAX_OBJECTS)	// uint8_t sequence counter of each object
+
+// the object values are packed into the arena banks
+#define EIB_OBJECT_ARENA_SIZE	((uint16_t) XRAM_OBJECT_ARENA_BANKS * XRAM_BANK_SIZE)
 
-#define MAX_EIS5_MANTISSA 20.47
-#define MIN_EIS5_MANTISSA -20.48
+// max. number of objects updated by one group message
+#define EIB_MAX_MSG_OBJECTS		16
 
+// moves the object size table from Flash into RAM
+// returns 0 if ok
+// returns 2 if the table is too large
+uint8_t move_object_sizes (uint32_t, uint32_t);
+// forget object size table of previous project
+void eib_object_clear_sizes (void);
+// build object arena and clear all object values
 void eib_object_init (void);
-uint8_t eib_get_object_8_value (uint8_t);
+// get used size of the object arena
+uint16_t eib_object_arena_size (void);
+uint8_t eib_get_object_8_value (uint16_t);
 // returns value of 2 byte float objects
-uint16_t eib_get_object_16_value (uint8_t);
+uint16_t eib_get_object_16_value (uint16_t);
 // returns value of 4 byte float objects
-uint32_t eib_get_object_32_value (uint8_t);
-// returns value of EIS5 float objects
-float eib_get_object_EIS5_value (uint8_t);
+uint32_t eib_get_object_32_value (uint16_t);
+// copies data of object, returns the object size
+uint8_t eib_get_object_data (uint16_t, uint8_t*, uint8_t);
+// returns value of object decoded as DPT
+int32_t eib_get_object_value (uint16_t, uint8_t);
 
-// sends value of EIS5 float objects
-void eib_set_object_EIS5_value (uint16_t, float);
+// sends value encoded as DPT
+char eib_set_object_value (uint16_t, uint8_t, int32_t);
 // handle EIB group message
 uint8_t eib_objects_process_msg (uint16_t, uint8_t*, uint8_t, uint8_t);
+// check, if object has been addressed by the last group message
+uint8_t eib_object_addressed (uint16_t);
+// get objects addressed by the last group message, returns their number
+uint8_t eib_get_msg_objects (uint16_t**);
+// check, if the value of the object has been changed by the last group message
+uint8_t eib_object_changed (uint16_t);
+// check, if an element must be updated, force: react to every write
+uint8_t eib_object_updated (uint16_t, uint8_t);
 
 
 #endif // _EIB_OBJECTS_H_
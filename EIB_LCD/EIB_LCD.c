@@ -32,6 +32,10 @@
 */
 uint8_t	flash_content_bad;
 
+/*! structure version of the project data in the external Flash memory
+*/
+uint8_t	lcd_file_version;
+
 /*!
 	Definition to obtain the version of the firmware image
 */
@@ -77,6 +81,9 @@ uint32_t baud = 115200;
 	XMCRA |= (1<<SRL2) ; // divide memory at 0x8000
 	MCUCR &= 0xff ^ ( (1<<SRW10) ); // no wait
 
+	/* paint the stacks of the running threads to find their high-water marks */
+	sysmon_init ();
+
 	/* init tft controller */
 	tft_init();
 #ifdef LCD_DEBUG
@@ -88,8 +95,12 @@ uint32_t baud = 115200;
 	/* setup the external Flash memory device */
 	printf_tft_P( TFT_COLOR_GREEN, TFT_COLOR_WHITE, PSTR("Init NAND Flash"));
 	init_nand_flash();
+	/* select the active project slot */
+	flash_slot_init ();
 	/* read project information from external NAND Flash and configure the system accordingly. */
-	init_system_from_flash ();
+	/* roll back to the project of the other slot, if the active slot holds none */
+	if (init_system_from_flash () && !flash_slot_rollback ())
+		init_system_from_flash ();
 	/* start the EIB communication */
 	init_eib_layers ();
 	/* init sound functions */
@@ -107,6 +118,8 @@ uint32_t baud = 115200;
 	else 
 		/* show 1st page */
 		set_page (0);
+	/* check pictures and sounds, while the system is idle */
+	crc_check_start ();
 
     /*
      * This is the main thread running with lowest priority
@@ -115,8 +128,10 @@ uint32_t baud = 115200;
     for (;;) {
         NutSleep(MAIN_TIME_LOOP_SLEEP); // currently 30ms
 
-		/* check TPUART status */
-		eib_get_status();
+		/* check TPUART status, save object values on bus power down */
+		snapshot_process (eib_get_status());
+		/* read objects of pages and listening elements from the bus */
+		read_sweep_process (eib_get_status());
 		/* Caution against TX deadlocks */
 		eib_check_tx_deadlock();
 
@@ -130,6 +145,11 @@ uint32_t baud = 115200;
 		/* process page elements for cyclic functions on pages */
 		process_cyclic_page_events ();
 
+		/* count XRAM bank writes per second */
+		xram_statistics ();
+		/* track the free heap */
+		sysmon_tick ();
+
     }
 	/* GCC likes to see a return here. Of course it has no meaning an is never executed. */
     return 0;
@@ -23,7 +23,11 @@
 //*********************************
 // 0x0 : Mode control register
 #define MODE_CTRL_ADDR 		0x00
+// a read of Flash word w writes its low byte to offset (2*w & 0x1fff) and its
+// high byte to the next offset of the selected bank, see copy_Flash_to_XRAM_test()
 #define		RAM_WRITE_ON_FLASH_READ		3
+// a read at offset o of the selected bank b writes the pixel
+// (b+1:o) << 8 | (b:o) to the TFT, see tft_put_xram_image()
 #define		TFT_WRITE_ON_RAM_BANK_READ	2
 #define		TFT_WRITE_ON_RAM_READ		1
 #define		TFT_WRITE_ON_FLASH_READ		0
@@ -44,15 +48,18 @@
 #define XRAM_BANK_SIZE				0x2000
 #define XRAM_TOC_PAGE				2
 #define	XRAM_TOC_ADDR				XRAM_TOC_PAGE,0x0000
-#define XRAM_PAGE_PAGE				3
-#define XRAM_PAGE_ADDR				XRAM_PAGE_PAGE,0x0000
-#define XRAM_GROUP_PAGE				4
-#define XRAM_GROUP_ADDR				XRAM_GROUP_PAGE,0x0000
-#define XRAM_OBJECT_VALUE_PAGE		5
-#define XRAM_LISTEN_ELEMENTS_PAGE	6
-#define XRAM_LISTEN_ELEMENTS_ADDR	XRAM_LISTEN_ELEMENTS_PAGE,0x0000
-#define XRAM_CYCLIC_ELEMENTS_PAGE	7
-#define XRAM_CYCLIC_ELEMENTS_ADDR	XRAM_CYCLIC_ELEMENTS_PAGE,0x0000
+#define XRAM_OBJECT_VALUE_PAGE		3
+#define XRAM_ASSOC_PAGE				4
+#define XRAM_ASSOC_ADDR				XRAM_ASSOC_PAGE,0x0000
+#define XRAM_OBJECT_ARENA_PAGE		5
+#define XRAM_OBJECT_ARENA_BANKS		2
+#define XRAM_LISTEN_REGISTRY_PAGE	7
+#define XRAM_HISTORY_PAGE			8
+#define XRAM_HISTORY_BANKS			2
+// banks for page, group address, listen and cyclic descriptions, caches and buffers
+// are allocated by xram_alloc()
+#define XRAM_DYNAMIC_FIRST_PAGE		10
+#define XRAM_DYNAMIC_LAST_PAGE		61
 
 
 #define	FLASH_BASE_ADDRESS		0x8000
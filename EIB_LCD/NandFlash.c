@@ -17,12 +17,277 @@
  *
  */
 
+#include <sys/mutex.h>
+
 #include "NandFlash.h"
 #include "FATSingleOpt/dos.h"
 
 
 // Global Variable
 static uint8_t flash_qfi_mode;
+// words of the Flash write buffer, 0: program single words in unlock bypass mode
+static uint8_t flash_buffer_words;
+// Flash is erased or programmed, nesting counter of flash_program_begin()
+volatile uint8_t flash_busy;
+// owner of the Flash while it is erased, programmed or read by a thread
+static MUTEX flash_mutex;
+// the owner sleeps while a sector is erased, readers may suspend the erase
+static uint8_t flash_erase_suspendable;
+static volatile uint8_t flash_erase_sleeping;
+// nesting counter of the readers of a suspended sector erase
+static volatile uint8_t flash_erase_readers;
+
+/**
+ * \brief Waits for the ready signal of the Flash.
+ * \param timeout max. time to wait in ms
+ * \return 0=ready, 1=timeout
+ *
+ * Commands with a timeout up to FLASH_SPIN_TIMEOUT are polled without giving up
+ * the CPU, so the selected sector stays valid for the next command. Erase
+ * commands sleep between the polls and let the other threads run meanwhile.
+ */
+static uint8_t flash_wait_ready (uint32_t timeout)
+{
+uint32_t start;
+uint32_t suspended;
+uint8_t	sector_setting_save;
+uint8_t	dma_setting_save;
+
+	// most commands complete within some us
+	if (FLASH_READY_STATE)
+		return 0;
+
+	start = NutGetMillis ();
+	while (!FLASH_READY_STATE) {
+		if (NutGetMillis () - start > timeout) {
+#ifdef LCD_DEBUG
+			printf_P(PSTR("\nFlash timeout\n"));
+#endif
+			return 1;
+		}
+		if (timeout > FLASH_SPIN_TIMEOUT) {
+			// other threads may select another sector or DMA mode
+			sector_setting_save = INB (CPLD_BASE_ADDR + FLASH_BANK_ADDR);
+			dma_setting_save = INB (CPLD_BASE_ADDR + MODE_CTRL_ADDR);
+			flash_erase_sleeping = flash_erase_suspendable;
+			xram_sleep (FLASH_POLL_INTERVAL);
+			// the Flash is ready while the erase is suspended by readers,
+			// the last one resumes it, the suspended time is not counted
+			suspended = NutGetMillis ();
+			while (flash_erase_readers)
+				xram_sleep (FLASH_POLL_INTERVAL);
+			start += NutGetMillis () - suspended;
+			flash_erase_sleeping = 0;
+			OUTB (CPLD_BASE_ADDR + MODE_CTRL_ADDR, dma_setting_save);
+			FLASH_SELECT_SECTOR_ABS (sector_setting_save);
+		}
+	}
+	return 0;
+}
+
+/**
+ * \brief Suspends the sector erase of another thread for reading.
+ * \sa flash_erase_resume()
+ *
+ * The erased sector returns status bits, the other sectors can be read after
+ * the suspend latency.
+ */
+static void flash_erase_suspend (void)
+{
+uint8_t	sector_setting_save;
+
+	sector_setting_save = INB (CPLD_BASE_ADDR + FLASH_BANK_ADDR);
+	OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
+	OUTB(FLASH_BASE_ADDRESS, 0xB0);
+	flash_wait_ready (FLASH_SUSPEND_TIMEOUT);
+	FLASH_SELECT_SECTOR_ABS (sector_setting_save);
+}
+
+/**
+ * \brief Resumes the sector erase suspended by flash_erase_suspend().
+ */
+static void flash_erase_resume (void)
+{
+	OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
+	OUTB(FLASH_BASE_ADDRESS, 0x30);
+}
+
+/**
+ * \brief Prepares the Flash for erasing and programming.
+ * \sa flash_program_end()
+ *
+ * Waits, until no other thread uses the Flash, and locks it for the calling
+ * thread. Enables the wait states required for Flash commands. Other threads
+ * must not read the Flash, until flash_program_end() has been called: they wait
+ * in flash_read_begin() or suspend a sector erase there, sound clips are muted
+ * and the background CRC check pauses. The selected XRAM bank is kept.
+ */
+void flash_program_begin (void)
+{
+uint8_t	bank;
+
+	// other threads may select another bank meanwhile, see xram_yield()
+	bank = XRAM_GET_SELECTED_BLOCK;
+	NutMutexLock (&flash_mutex);
+	XRAM_SELECT_BLOCK(bank);
+	if (!flash_busy++) {
+		/* enable Flash wait */
+		XMCRA |= (1<<SRW11); // wait
+		MCUCR |= (1<<SRW10); // wait
+	}
+}
+
+/**
+ * \brief Returns the Flash to normal reading.
+ * \sa flash_program_begin()
+ */
+void flash_program_end (void)
+{
+	if (!--flash_busy) {
+		/* disable Flash wait */
+		XMCRA &= 0xff ^ (1<<SRW11); // no wait
+		MCUCR &= 0xff ^ (1<<SRW10); // no wait
+	}
+	NutMutexUnlock (&flash_mutex);
+}
+
+/**
+ * \brief Locks the Flash for reading.
+ * \sa flash_read_end()
+ *
+ * A thread erasing a sector lets the other threads run, while the Flash returns
+ * status bits instead of data. Readers suspend a sector erase and read the
+ * other sectors meanwhile, the erase is resumed by flash_read_end() of the last
+ * reader. Readers wait here for program sequences and chip erases. Calls may be
+ * nested, also within flash_program_begin() and flash_program_end(). Must not
+ * be called from an interrupt, see read_flash_int().
+ */
+void flash_read_begin (void)
+{
+uint8_t	bank;
+
+	if (flash_erase_sleeping) {
+		if (!flash_erase_readers++)
+			flash_erase_suspend ();
+		return;
+	}
+	// other threads may select another bank meanwhile, see xram_yield()
+	bank = XRAM_GET_SELECTED_BLOCK;
+	NutMutexLock (&flash_mutex);
+	XRAM_SELECT_BLOCK(bank);
+}
+
+/**
+ * \brief Unlocks the Flash after reading.
+ * \sa flash_read_begin()
+ */
+void flash_read_end (void)
+{
+	if (flash_erase_readers) {
+		if (!--flash_erase_readers)
+			flash_erase_resume ();
+		return;
+	}
+	NutMutexUnlock (&flash_mutex);
+}
+
+/**
+ * \brief Returns the Flash to read mode after a failed command.
+ *
+ * The three cycle reset also leaves the write buffer abort state.
+ */
+static void flash_recover (void)
+{
+	FLASH_SELECT_SECTOR_ABS (0);
+	OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
+	OUTB((FLASH_BASE_ADDRESS + 0x555), 0xAA);
+	OUTB((FLASH_BASE_ADDRESS + 0x2AA), 0x55);
+	OUTB((FLASH_BASE_ADDRESS + 0x555), 0xF0);
+	flash_wait_ready (FLASH_RESET_TIMEOUT);
+}
+
+/**
+ * \brief Programs words in unlock bypass mode.
+ * \sa write_nand_flash()
+ *
+ * The unlock sequence is sent once, each word needs two bus cycles only.
+ */
+static int write_flash_bypass (uint8_t sector, uint16_t offset, uint16_t size, uint8_t* data)
+{
+uint16_t	i;
+
+	/* enter unlock bypass mode */
+	FLASH_SELECT_SECTOR_ABS (0);
+	OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
+	OUTB((FLASH_BASE_ADDRESS + 0x555), 0xAA);
+	OUTB((FLASH_BASE_ADDRESS + 0x2AA), 0x55);
+	OUTB((FLASH_BASE_ADDRESS + 0x555), 0x20);
+
+	FLASH_SELECT_SECTOR_ABS (sector);
+	for (i = 0; i < size; i++) {
+		/* program command */
+		OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
+		OUTB(FLASH_BASE_ADDRESS + offset, 0xA0);
+		// write data (lb/hb)
+		OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, (*data++));
+		OUTB(FLASH_BASE_ADDRESS + offset++, (*data++));
+
+		if (flash_wait_ready (FLASH_WORD_TIMEOUT)) {
+			flash_recover ();
+			return -1;
+		}
+	}
+
+	/* leave unlock bypass mode */
+	OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
+	OUTB(FLASH_BASE_ADDRESS, 0x90);
+	OUTB(FLASH_BASE_ADDRESS, 0x00);
+
+	return i;
+}
+
+/**
+ * \brief Programs words by the write buffer of the Flash.
+ * \sa write_nand_flash()
+ *
+ * A buffer is programmed at once, but must not cross a write buffer page.
+ */
+static int write_flash_buffered (uint8_t sector, uint16_t offset, uint16_t size, uint8_t* data)
+{
+uint16_t	i;
+uint8_t		n, k;
+
+	for (i = 0; i < size; i += n) {
+		n = flash_buffer_words - (offset & (flash_buffer_words -1));
+		if (n > size - i)
+			n = size - i;
+
+		/* write to buffer command, word count */
+		FLASH_SELECT_SECTOR_ABS (0);
+		OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
+		OUTB((FLASH_BASE_ADDRESS + 0x555), 0xAA);
+		OUTB((FLASH_BASE_ADDRESS + 0x2AA), 0x55);
+		FLASH_SELECT_SECTOR_ABS (sector);
+		OUTB(FLASH_BASE_ADDRESS + offset, 0x25);
+		OUTB(FLASH_BASE_ADDRESS + offset, n -1);
+
+		// write data (lb/hb)
+		for (k = n; k; k--) {
+			OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, (*data++));
+			OUTB(FLASH_BASE_ADDRESS + offset++, (*data++));
+		}
+
+		/* program buffer to Flash */
+		OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
+		OUTB(FLASH_BASE_ADDRESS + offset -1, 0x29);
+
+		if (flash_wait_ready (FLASH_BUFFER_TIMEOUT)) {
+			flash_recover ();
+			return -1;
+		}
+	}
+	return i;
+}
 
 /**
  * \brief Writes data into external NAND Flash memory.
@@ -31,71 +296,101 @@ static uint8_t flash_qfi_mode;
  * \param start start offset address in sector
  * \param size amount of WORD to write into Flash
  * \param data pointer to data array
- * \return Number of Flash sectors written
+ * \return Number of words written, -1 if the Flash did not get ready
  *
+ * Uses the write buffer, if the Flash reports one in its CFI information,
+ * otherwise single words are programmed in unlock bypass mode.
  */
 int write_nand_flash (uint8_t sector, uint16_t offset, uint16_t size, uint8_t* data)
 {
-uint16_t	ws, i;
+uint16_t	ws;
+int			result;
 
 	if (offset+size <= FLASH_SECTOR_SIZE)
 		ws = size;
 	else
 		ws = FLASH_SECTOR_SIZE - offset;
 
-	/* write data from buffer into Flash memory */
-	i = 0;
-	while (ws) {
-		/* enable write permission */
-		FLASH_SELECT_SECTOR (0);
-		OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
-		OUTB((FLASH_BASE_ADDRESS + 0x555), 0xAA);
-		OUTB((FLASH_BASE_ADDRESS + 0x2AA), 0x55);
-		OUTB((FLASH_BASE_ADDRESS + 0x555), 0xA0);
+	if (!ws)
+		return 0;
 
-		// write data (lb/hb)
-		FLASH_SELECT_SECTOR (sector);
-		OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, (*data++));
-		OUTB(FLASH_BASE_ADDRESS + offset++, (*data++));
-
-		/* poll for ready signal from Flash */
-		//FIXME: should allow escape path on timeout
-		while (!FLASH_READY_STATE);
-		ws--; i++;
-	}
-	return i;
+	/* write data from buffer into Flash memory */
+	flash_program_begin ();
+	if (flash_buffer_words)
+		result = write_flash_buffered (sector, offset, ws, data);
+	else result = write_flash_bypass (sector, offset, ws, data);
+	flash_program_end ();
+	return result;
 }
 
 /**
- * \brief Erases one sector of the external Flash memory.
+ * \brief Starts erasing one sector of the external Flash memory.
+ * \sa flash_erase_wait()
  * \param sector Flash sector number
+ *
+ * The Flash must not be accessed, until flash_erase_wait() returns.
  */
-void erase_flash_sector (uint8_t sector)
+static void flash_erase_start (uint8_t sector)
 {
 	/* issue erase command */
-	FLASH_SELECT_SECTOR (0);
+	FLASH_SELECT_SECTOR_ABS (0);
 	OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
 	OUTB((FLASH_BASE_ADDRESS + 0x555), 0xAA);
 	OUTB((FLASH_BASE_ADDRESS + 0x2AA), 0x55);
 	OUTB((FLASH_BASE_ADDRESS + 0x555), 0x80);
 	OUTB((FLASH_BASE_ADDRESS + 0x555), 0xAA);
 	OUTB((FLASH_BASE_ADDRESS + 0x2AA), 0x55);
-	FLASH_SELECT_SECTOR (sector);
+	FLASH_SELECT_SECTOR_ABS (sector);
 	OUTB(FLASH_BASE_ADDRESS, 0x30);
+}
 
-	/* poll for ready signal from Flash */
-	//FIXME: should allow escape path on timeout
-	while (!FLASH_READY_STATE);
+/**
+ * \brief Waits until the sector erase started by flash_erase_start() is completed.
+ * \return 0=ok, 1=timeout
+ */
+static uint8_t flash_erase_wait (void)
+{
+uint8_t	result;
+
+	/* poll for ready signal from Flash, readers may suspend the erase */
+	flash_erase_suspendable = 1;
+	result = flash_wait_ready (FLASH_SECTOR_ERASE_TIMEOUT);
+	flash_erase_suspendable = 0;
+	if (result) {
+		flash_recover ();
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * \brief Erases one sector of the external Flash memory.
+ * \param sector Flash sector number
+ * \return 0=ok, 1=timeout
+ */
+uint8_t erase_flash_sector (uint8_t sector)
+{
+uint8_t	result;
+
+	flash_program_begin ();
+	flash_erase_start (sector);
+	result = flash_erase_wait ();
+	flash_program_end ();
+	return result;
 }
 
 /**
  * \brief Erases the external Flash Chip memory.
  *  takes approx 64-128sec. for a S29GL064N
+ * \return 0=ok, 1=timeout
  */
-void erase_flash_chip (void)
+uint8_t erase_flash_chip (void)
 {
+uint8_t	result;
+
+	flash_program_begin ();
 	/* issue erase command */
-	FLASH_SELECT_SECTOR (0);
+	FLASH_SELECT_SECTOR_ABS (0);
 	OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
 	OUTB((FLASH_BASE_ADDRESS + 0x555), 0xAA);
 	OUTB((FLASH_BASE_ADDRESS + 0x2AA), 0x55);
@@ -105,8 +400,13 @@ void erase_flash_chip (void)
 	OUTB((FLASH_BASE_ADDRESS + 0x555), 0x10);
 
 	/* poll for ready signal from Flash */
-	//FIXME: should allow escape path on timeout
-	while (!FLASH_READY_STATE);
+	result = 0;
+	if (flash_wait_ready (FLASH_CHIP_ERASE_TIMEOUT)) {
+		flash_recover ();
+		result = 1;
+	}
+	flash_program_end ();
+	return result;
 }
 
 
@@ -116,14 +416,15 @@ void erase_flash_chip (void)
 void reset_flash_chip (void)
 {
 	flash_qfi_mode = 0;
+	flash_program_begin ();
 	/* issue erase command */
-	FLASH_SELECT_SECTOR (0);
+	FLASH_SELECT_SECTOR_ABS (0);
 	OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
 	OUTB((FLASH_BASE_ADDRESS + 0x555), 0xF0);
 
 	/* poll for ready signal from Flash */
-	//FIXME: should allow escape path on timeout
-	while (!FLASH_READY_STATE);
+	flash_wait_ready (FLASH_RESET_TIMEOUT);
+	flash_program_end ();
 }
 
 
@@ -139,13 +440,12 @@ uint8_t read_flash_qfi_info (uint8_t address)
 	if(!flash_qfi_mode) {
 		// enter QFI Query mode
 		flash_qfi_mode = 1;
-		FLASH_SELECT_SECTOR (0);
+		FLASH_SELECT_SECTOR_ABS (0);
 		OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, 0x00);
 		OUTB((FLASH_BASE_ADDRESS + 0x55), 0x98);
 
 		// poll for ready signal from Flash
-		//FIXME: should allow escape path on timeout
-		while (!FLASH_READY_STATE);
+		flash_wait_ready (FLASH_RESET_TIMEOUT);
 	}
 
 	NutEnterCritical();	// TODO: Do we need this for a single byte reading??
@@ -156,6 +456,34 @@ uint8_t read_flash_qfi_info (uint8_t address)
 	return hb;
 }
 
+/**
+ * \brief Selects the programming method from the CFI Query Information.
+ * \sa write_nand_flash()
+ */
+static void flash_detect_write_buffer (void)
+{
+uint8_t	n;
+
+	flash_buffer_words = 0;
+	n = 0;
+	if ((read_flash_qfi_info (FLASH_QFI_QRY+0) == 'Q') &&
+		(read_flash_qfi_info (FLASH_QFI_QRY+1) == 'R') &&
+		(read_flash_qfi_info (FLASH_QFI_QRY+2) == 'Y') &&
+		read_flash_qfi_info (FLASH_QFI_T_MIN_BUF_W))
+		// 2^n Bytes
+		n = read_flash_qfi_info (FLASH_QFI_MAX_BUF_SIZE);
+	reset_flash_chip ();
+
+	if (n > 1) {
+		if (n > FLASH_MAX_BUFFER_SHIFT)
+			n = FLASH_MAX_BUFFER_SHIFT;
+		flash_buffer_words = (1 << n) >> 1;
+	}
+#ifdef LCD_DEBUG
+	printf_P(PSTR("\nFlash write buffer %d words\n"), flash_buffer_words);
+#endif
+}
+
 
  /* \brief Erase amount of blocks in external flash memory
  *         The flash can be erased in blocks of 64K
@@ -163,6 +491,7 @@ uint8_t read_flash_qfi_info (uint8_t address)
  * \sa erase_flash_sector()
  * \param blocks Amount of Flash blocks to erase
  * \param start_block First block to erase
+ * \return 0=ok, 1=out of range, 2=Flash did not get ready
  */
 uint8_t erase_complete_flash(uint8_t blocks, uint8_t start_block)
 {
@@ -179,9 +508,7 @@ uint8_t erase_complete_flash(uint8_t blocks, uint8_t start_block)
 	/* invalidate Flash content to prevent any function accessing inconsistent Flash data */
 	set_flash_content_invalid();
 
-	/* enable Flash wait */
-	XMCRA |= (1<<SRW11); // wait
-	MCUCR |= (1<<SRW10); // wait
+	flash_program_begin ();
 
 	init_download_progress(blocks);
 
@@ -189,38 +516,115 @@ uint8_t erase_complete_flash(uint8_t blocks, uint8_t start_block)
 	{
 		show_erase_progress(erased_blocks);
 		// Zap Block
-		erase_flash_sector (start_block+erased_blocks);
+		if (erase_flash_sector (start_block+erased_blocks))
+			break;
 	}
 
-	/* disable Flash wait */
-	XMCRA &= 0xff ^ (1<<SRW11); // no wait
-	MCUCR &= 0xff ^ (1<<SRW10); // no wait
+	flash_program_end ();
 
+	if (erased_blocks <= blocks)
+		return 2;	// Flash did not get ready
 	return 0; /*! erase successfully completed */
 }
 
 
 /**
- * \brief Moves contents of a SD Card file into the external Flash memory.
- * \sa write_nand_flash()
- * \sa erase_flash_sector()
+ * \brief Compares data with the Flash contents.
+ * \param sector Flash sector number
+ * \param offset start offset address in sector
+ * \param bytes amount of BYTES to compare, must not cross the sector
+ * \param data pointer to data array
+ * \return 0=equal, 1=different
+ */
+static uint8_t compare_nand_flash (uint8_t sector, uint16_t offset, uint16_t bytes, uint8_t* data)
+{
+uint8_t	lb, hb;
+
+	FLASH_SELECT_SECTOR_ABS (sector);
+	// disable dma functions
+	OUTB (CPLD_BASE_ADDR + MODE_CTRL_ADDR, 0x00);
+
+	while (bytes) {
+		NutEnterCritical();
+		hb = INB(FLASH_BASE_ADDRESS + offset++);
+		lb = INB(CPLD_BASE_ADDR + UPPER_DATA_RD_ADDR);
+		NutExitCritical ();
+
+		if (lb != *data++)
+			return 1;
+		if (!--bytes)
+			break;
+		if (hb != *data++)
+			return 1;
+		bytes--;
+	}
+	return 0;
+}
+
+#define SECTOR_CHANGED(map, sec)	((map)[(sec) >> 3] & (1 << ((sec) & 0x07)))
+
+/**
+ * \brief Reads the next part of the open SD Card file into XRAM banks.
+ * \param bank first XRAM bank
+ * \param size amount of BYTES to read
+ * \param downloadtotal bytes read from the file, updated
+ * \return Number of bytes read, less than size at the end of the file
+ *
+ * Each bank is filled by a single multi block read.
+ */
+static uint32_t file_read_banks (uint8_t bank, uint32_t size, uint32_t *downloadtotal)
+{
+uint32_t total;
+uint16_t want;
+int16_t read_bytes;
+
+	total = 0;
+	while (total < size) {
+		want = min (size - total, XRAM_BANK_SIZE);
+		XRAM_SELECT_BLOCK(bank + total / XRAM_BANK_SIZE);
+		read_bytes = Fread((uint8_t*) XRAM_BASE_ADDRESS, want);
+		if (read_bytes <= 0)
+			break;
+		total += read_bytes;
+		*downloadtotal += read_bytes;
+		show_download_progress (*downloadtotal);
+		if (read_bytes < want)
+			break;	// end of file reached
+	}
+	return total;
+}
+
+/**
+ * \brief Streams a SD Card file through the external Flash memory.
+ * \sa file_2_nand_flash()
  * \param *filename File name string
- * \param start_address Absolute Flash memory address, at which the SD Card file image should start in the Flash memory.
- * \return 0=ok, 1=file error, 2=out of mem
+ * \param start_address Absolute Flash memory address of the file image
+ * \param end_sector first sector, which must not be written
+ * \param bank first XRAM bank of the file data buffer
+ * \param banks number of XRAM banks of the buffer
+ * \param changed sectors which differ from the file, one bit per sector
+ * \param program 0: compare the file and mark changed sectors, 1: erase and write the changed sectors
+ * \param downloadtotal returns the file size
+ * \return 0=ok, 1=file error, 2=file too large, 3=Flash error
  *
+ * The file is read in chunks of the buffer size, which never cross a sector.
+ * A changed sector is erased, while its first chunk is read from the SD Card.
  */
-uint8_t file_2_nand_flash ( char *filename, uint32_t start_address )
+static uint8_t file_2_nand_flash_pass (char *filename, uint32_t start_address, uint8_t end_sector, uint8_t bank, uint8_t banks,
+									   uint8_t *changed, uint8_t program, uint32_t *downloadtotal)
 {
-#define FILE_READ_BUFF_SIZE	512
-uint8_t * buffer; /*! pointer to the file data buffer */
-uint8_t * bptr;
-int16_t read_bytes, written_words;
+uint32_t chunk;
+uint32_t read_bytes;
+uint32_t o;
+uint16_t bytes;
 uint16_t flash_address;
 uint8_t	 flash_sector, last_sector;
-uint32_t downloadtotal; /*! total file size to be downloaded into the Flash memory */
+uint8_t	 erasing;
 unsigned char result;
+uint8_t	status;
 
-  	downloadtotal = 0;
+	*downloadtotal = 0;
+	status = 0;
 
 	/* try to open the file */
 	result=Fopen(filename,F_READ);
@@ -228,64 +632,133 @@ unsigned char result;
 		return 1; /*! file open error */
 	}
 
-	/* allocate memory to store the data read from SD card */
-	buffer = (uint8_t*) malloc (FILE_READ_BUFF_SIZE);
-	if (!buffer) {
-   		Fclose(); /* close the file */
-		return 2; /*! out of memory */
-	}
-
-	/* invalidate Flash content to prevent any function accessing inconsistent Flash data */
-	set_flash_content_invalid();
-
-	/* enable Flash wait */
-	XMCRA |= (1<<SRW11); // wait
-	MCUCR |= (1<<SRW10); // wait
-
 	last_sector = 0xff;
-	while (result==F_OK) {
+	do {
+		/* calculate Flash address */
+		flash_address = start_address & 0x7FFF;
+		flash_sector = (start_address >> 15) & 0x7F;
+		// bytes up to the end of the buffer or of the sector
+		chunk = min ((uint32_t) banks * XRAM_BANK_SIZE, ((uint32_t) FLASH_SECTOR_SIZE - flash_address) << 1);
+
+		// erase ahead, the Flash is busy while the SD Card is read
+		erasing = program && (flash_sector != last_sector) && (flash_sector < end_sector) && SECTOR_CHANGED(changed, flash_sector);
+		if (erasing) {
+			flash_erase_start (flash_sector);
+			last_sector = flash_sector;
+		}
+
+		read_bytes = file_read_banks (bank, chunk, downloadtotal);
 
-		read_bytes = Fread(buffer,FILE_READ_BUFF_SIZE);
-		downloadtotal += read_bytes;
-		show_download_progress (downloadtotal);
-		if (read_bytes < FILE_READ_BUFF_SIZE) {
-           result=F_ERROR; // end of file reached ?
+		if (erasing && flash_erase_wait ()) {
+			status = 3;
+			break;
 		}
-		if (read_bytes > 0) {
-			bptr = buffer;
-			while (read_bytes) {
-				/* calculate Flash address */
-				flash_address = start_address & 0x7FFF;
-				flash_sector = (start_address >> 15) & 0x7F;
-				// erase new sector if used now
-				if (flash_sector != last_sector) {
-					erase_flash_sector (flash_sector);
-					last_sector = flash_sector;
-				}
-
-				// write buffer to Flash (word count)
-				written_words = write_nand_flash (flash_sector, flash_address, (read_bytes+1) >> 1, bptr);
-				if (written_words << 1 > read_bytes) {
-					read_bytes = 0;
-					result = F_ERROR;
-				}
-				else
-					read_bytes -= written_words << 1;
-				start_address += written_words;
-				bptr += written_words << 1;
+		if (!read_bytes)
+			break;
+		// the file must fit into the slot
+		if (flash_sector >= end_sector) {
+			status = 2;
+			break;
+		}
+
+		for (o = 0; (o < read_bytes) && !status; o += XRAM_BANK_SIZE) {
+			bytes = min (read_bytes - o, XRAM_BANK_SIZE);
+			XRAM_SELECT_BLOCK(bank + o / XRAM_BANK_SIZE);
+			if (!program) {
+				// compare until the first difference of the sector
+				if (!SECTOR_CHANGED(changed, flash_sector) &&
+					compare_nand_flash (flash_sector, flash_address + (o >> 1), bytes, (uint8_t*) XRAM_BASE_ADDRESS))
+					changed[flash_sector >> 3] |= 1 << (flash_sector & 0x07);
 			}
+			// write buffer to Flash (word count)
+			else if (SECTOR_CHANGED(changed, flash_sector) &&
+					 (write_nand_flash (flash_sector, flash_address + (o >> 1), (bytes +1) >> 1, (uint8_t*) XRAM_BASE_ADDRESS) < 0))
+				status = 3;
 		}
-	}
+		start_address += (read_bytes +1) >> 1;
+	} while ((read_bytes == chunk) && !status);
 
-	/* close file and release data buffer */
+	/* close file */
    	Fclose();
-	free (buffer);
+	return status;
+}
+
+/**
+ * \brief Moves contents of a SD Card file into the external Flash memory.
+ * \sa write_nand_flash()
+ * \sa erase_flash_sector()
+ * \param *filename File name string
+ * \param start_address Absolute Flash memory address, at which the SD Card file image should start in the Flash memory.
+ * \param end_sector First sector behind the Flash memory available for the file.
+ * \return 0=ok, 1=file error, 2=out of mem or file too large, 3=Flash error
+ *
+ * The first pass compares the file with the Flash contents, the second pass
+ * erases and writes only the sectors, which differ. A third pass verifies the
+ * written sectors. The file is written into the inactive project slot, so the
+ * Flash contents of the active project stay valid.
+ * The file data is buffered in up to FLASH_DOWNLOAD_MAX_BANKS free XRAM banks.
+ */
+uint8_t file_2_nand_flash ( char *filename, uint32_t start_address, uint8_t end_sector )
+{
+uint8_t changed[(FLASH_MAX_SECTOR +8) / 8]; /*! sectors to be written */
+uint32_t downloadtotal; /*! total file size to be downloaded into the Flash memory */
+uint8_t	status;
+uint8_t	bank, banks;
+uint8_t	save_xram_page;
+uint8_t	i;
+#ifdef LCD_DEBUG
+uint32_t start;
+
+	start = NutGetMillis ();
+#endif
+
+	/* allocate XRAM banks to store the data read from SD card */
+	for (banks = FLASH_DOWNLOAD_MAX_BANKS; banks; banks--) {
+		bank = xram_alloc (banks);
+		if (bank)
+			break;
+	}
+	if (!banks) {
+		return 2; /*! out of memory */
+	}
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+
+	flash_program_begin ();
+	// disable dma functions, the buffer is read from XRAM
+	OUTB (CPLD_BASE_ADDR + MODE_CTRL_ADDR, 0x00);
+
+	memset (changed, 0, sizeof (changed));
+	status = file_2_nand_flash_pass (filename, start_address, end_sector, bank, banks, changed, 0, &downloadtotal);
+
+	for (i = 0; (i < sizeof (changed)) && !changed[i]; i++);
+	if (!status && (i < sizeof (changed))) {
+		init_download_progress (downloadtotal);
+		status = file_2_nand_flash_pass (filename, start_address, end_sector, bank, banks, changed, 1, &downloadtotal);
+
+		// verify all sectors again
+		if (!status) {
+			memset (changed, 0, sizeof (changed));
+			init_download_progress (downloadtotal);
+			status = file_2_nand_flash_pass (filename, start_address, end_sector, bank, banks, changed, 0, &downloadtotal);
+			for (i = 0; (i < sizeof (changed)) && !changed[i]; i++);
+			if (!status && (i < sizeof (changed)))
+				status = 3;
+		}
+	}
 
-	/* disable Flash wait */
-	XMCRA &= 0xff ^ (1<<SRW11); // no wait
-	MCUCR &= 0xff ^ (1<<SRW10); // no wait
+	flash_program_end ();
 
-	return 0; /*! download successfully completed */
+	/* release data buffer */
+	XRAM_SELECT_BLOCK(save_xram_page);
+	xram_free (bank, banks);
+
+#ifdef LCD_DEBUG
+	for (i = 0; i <= FLASH_MAX_SECTOR; i++)
+		if (SECTOR_CHANGED(changed, i))
+			printf_P(PSTR("\nSector %d changed"), i);
+	printf_P(PSTR("\nDownload: %lu bytes in %lu ms, %d banks, status %d\n"), downloadtotal, NutGetMillis () - start, banks, status);
+#endif
+	return status; /*! 0: download successfully completed */
 }
 
 /**
@@ -391,6 +864,44 @@ uint16_t offset;
 	return read_flash (sector, offset);
 }
 
+/**
+ * \brief Reads consecutive 16 bit values from the external Flash memory (32 bit linear address)
+ * \sa read_flash_abs()
+ * \param addr absolute 32 bit linear byte address of the first word, odd addresses are truncated
+ * \param buffer receives the words, swapped bytes like read_flash_abs()
+ * \param words number of words to read
+ *
+ * The Flash sector and the DMA mode are set once for all words. The next sector is selected,
+ * when the words cross a sector border.
+ */
+void read_flash_block (uint32_t addr, uint16_t *buffer, uint16_t words) {
+
+uint8_t	sector;
+uint16_t offset;
+uint8_t	lb;
+uint16_t hb;
+
+	sector = FLASH_GET_SECTOR(addr);
+	offset = FLASH_GET_OFFSET(addr);
+	FLASH_SELECT_SECTOR (sector);
+	OUTB (CPLD_BASE_ADDR + MODE_CTRL_ADDR, 0x00);
+
+	while (words--) {
+		// The CPLD keeps the high byte of a word until the next Flash read,
+		// interrupts may read the Flash.
+		NutEnterCritical ();
+		hb = INB(FLASH_BASE_ADDRESS + offset);
+		lb = INB(CPLD_BASE_ADDR + UPPER_DATA_RD_ADDR);
+		NutExitCritical ();
+		*buffer++ = lb | (hb << 8);
+
+		if (++offset > 0x7fff) {
+			offset = 0;
+			FLASH_SELECT_SECTOR (++sector);
+		}
+	}
+}
+
 /**
  * \brief intializes the Flash memory control
  *
@@ -403,6 +914,7 @@ void init_nand_flash ()
 {
 	// Not in QFI mode
 	flash_qfi_mode = 0;
+	NutMutexInit (&flash_mutex);
 
 	/* init Flash control pins */
 	INIT_FLASH_RESET
@@ -413,8 +925,9 @@ void init_nand_flash ()
 	FLASH_500ns_DELAY
 	SET_FLASH_RESET_INACTIVE
 	/* wait until Flash is ready. Max 20us */
-	//FIXME: should allow escape path on timeout
-	while (!FLASH_READY_STATE);
+	flash_wait_ready (FLASH_RESET_TIMEOUT);
+	/* select programming method */
+	flash_detect_write_buffer ();
 	/* select Flash bank 0 */
 	FLASH_SELECT_SECTOR (0);
 }
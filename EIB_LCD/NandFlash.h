@@ -33,9 +33,17 @@
 #define FLASH_500ns_DELAY	asm volatile ("nop"); asm volatile ("nop"); asm volatile ("nop"); asm volatile ("nop");
 
 
+// first sector of the active project slot, see flash_slot.c
+extern uint8_t flash_slot_base;
+
 // address of the Flash Bank select register
-#define	FLASH_SELECT_SECTOR(sec)		OUTB(CPLD_BASE_ADDR + FLASH_BANK_ADDR, sec)
-#define	FLASH_RETURN_SECTOR				INB(CPLD_BASE_ADDR + FLASH_BANK_ADDR)
+// project sectors are relative to the active slot
+#define	FLASH_SELECT_SECTOR(sec)		OUTB(CPLD_BASE_ADDR + FLASH_BANK_ADDR, (uint8_t) ((sec) + flash_slot_base))
+#define	FLASH_RETURN_SECTOR				((uint8_t) (INB(CPLD_BASE_ADDR + FLASH_BANK_ADDR) - flash_slot_base))
+// select physical sector, used for erasing and programming
+#define	FLASH_SELECT_SECTOR_ABS(sec)	OUTB(CPLD_BASE_ADDR + FLASH_BANK_ADDR, sec)
+// project sector of a physical sector, to read it by read_flash()
+#define	FLASH_PROJECT_SECTOR(sec)		((uint8_t) ((sec) - flash_slot_base))
 #define FLASH_SECTOR_SIZE	0x8000
 #define FLASH_MAX_SECTOR	0x7F
 
@@ -54,14 +62,42 @@
 #define FLASH_QFI_T_MIN_BUF_W	0x20
 #define FLASH_QFI_T_BL_ERASE	0x21
 #define FLASH_QFI_DEVICE_SIZE	0x27
+#define FLASH_QFI_MAX_BUF_SIZE	0x2A	// 2^n Bytes
 // PRI information offset to 0x13
 #define FLASH_PRI				0x00	// 3 byte
 #define FLASH_PRI_VER_MAJOR		0x03
 #define FLASH_PRI_VER_MINOR		0x04
 
+// max. time to get ready [ms]
+#define FLASH_RESET_TIMEOUT			2
+#define FLASH_WORD_TIMEOUT			2
+#define FLASH_BUFFER_TIMEOUT		5
+#define FLASH_SUSPEND_TIMEOUT		1
+#define FLASH_SECTOR_ERASE_TIMEOUT	5000
+#define FLASH_CHIP_ERASE_TIMEOUT	256000
+// commands with a longer timeout sleep between the polls [ms]
+#define FLASH_SPIN_TIMEOUT			5
+#define FLASH_POLL_INTERVAL			4
+// max. write buffer used: 2^5 Bytes
+#define FLASH_MAX_BUFFER_SHIFT		5
+// max. XRAM banks buffering a download, one sector
+#define FLASH_DOWNLOAD_MAX_BANKS	((FLASH_SECTOR_SIZE * 2) / XRAM_BANK_SIZE)
+
+// Flash is erased or programmed, other threads must not read it
+extern volatile uint8_t flash_busy;
+
 // init Flash on system startup
 void init_nand_flash (void);
-// write data into Flash. Returns amount of written words.
+// enable the wait states for erasing and programming, mark the Flash busy
+// The Flash is locked for the calling thread until flash_program_end().
+void flash_program_begin (void);
+void flash_program_end (void);
+// lock the Flash for reading, a sector erase of another thread is suspended meanwhile
+void flash_read_begin (void);
+void flash_read_end (void);
+// Erase and write functions use physical sectors, read functions use project sectors.
+// They lock the Flash by themselves, sequences of them are locked by flash_program_begin().
+// write data into Flash. Returns amount of written words, -1 on timeout.
 // uint8_t sector, uint16_t offset, uint16_t size, char* data
 int write_nand_flash (uint8_t, uint16_t, uint16_t, uint8_t*);
 // Send reset command
@@ -74,13 +110,17 @@ uint8_t read_flash_qfi_info (uint8_t);
 uint8_t erase_complete_flash(uint8_t, uint8_t);
 // erase a sector of Flash
 // uint8_t sector
-void erase_flash_sector (uint8_t);
+// returns 0=ok, 1=timeout
+uint8_t erase_flash_sector (uint8_t);
 // moves file contents to Flash memory
-uint8_t file_2_nand_flash ( char *, uint32_t);
+// char* file name, uint32_t physical start word address, uint8_t first physical sector not to be written
+uint8_t file_2_nand_flash ( char *, uint32_t, uint8_t);
 // read 16 bit value from Flash (sector, offset);
 uint16_t read_flash (uint8_t, uint16_t);
 // read 16 bit value from Flash (32 bit linear address);
 uint16_t read_flash_abs (uint32_t);
+// read consecutive 16 bit values from Flash (32 bit linear address, buffer, words)
+void read_flash_block (uint32_t, uint16_t*, uint16_t);
 // read 16 bit value from Flash (sector, offset) in interrupt function
 uint16_t read_flash_int (uint8_t, uint16_t);
 
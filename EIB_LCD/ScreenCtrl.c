@@ -22,6 +22,7 @@
 
 // Global Variables
 volatile uint32_t filesize;
+uint32_t download_start;	// time the download started [ms]
 // 0 = none
 // 1 = system setup man page
 // 2 = system download page
@@ -55,6 +56,12 @@ uint8_t G_pri_address;		// Address for PRI table within QFI info
 #define RESUME_BUTTON_YPOS		204
 #define HARDWARE_MONITOR_BUTTON_XPOS	109
 #define HARDWARE_MONITOR_BUTTON_YPOS	204
+#define MEMORY_MONITOR_BUTTON_XPOS	109
+#define MEMORY_MONITOR_BUTTON_YPOS	160
+#define ROLLBACK_BUTTON_XPOS	109
+#define ROLLBACK_BUTTON_YPOS	160
+#define REFRESH_BUTTON_XPOS		40
+#define REFRESH_BUTTON_YPOS		204
 #define	DOWNLOAD_BUTTON_XPOS	109
 #define	DOWNLOAD_BUTTON_YPOS	204
 #define CLRSCN_BUTTON_XPOS		40
@@ -220,13 +227,19 @@ uint16_t progress;
 void show_download_progress (uint32_t downloadsize) {
 
 uint32_t	progress;
+uint32_t	ms;
 
 	progress = (downloadsize * DOWNLOAD_BAR_WIDTH) / filesize;
 	tft_fill_rect (BYTE2COLOR (255,255,0), DOWNLOAD_BAR_XPOS, DOWNLOAD_BAR_YPOS,
 				 		DOWNLOAD_BAR_XPOS+progress,
 						DOWNLOAD_BAR_YPOS+DOWNLOAD_BAR_HEIGHT);
-	if( !(downloadsize%10240) )	// Print just every 10kbyte thus download speed is not reduced
-		printf_tft_absolute_P(DOWNLOAD_BAR_XPOS, DOWNLOAD_BAR_YPOS-30, TFT_COLOR_RED, TFT_COLOR_WHITE, PSTR("Loading... %u kbyte"), downloadsize/1024);
+	if( !(downloadsize%8192) ) {	// Print just every 8kbyte thus download speed is not reduced
+		ms = NutGetMillis () - download_start;
+		if (!ms)
+			ms = 1;
+		printf_tft_absolute_P(DOWNLOAD_BAR_XPOS, DOWNLOAD_BAR_YPOS-30, TFT_COLOR_RED, TFT_COLOR_WHITE, PSTR("Loading... %u kbyte, %u kbyte/s"),
+							  (uint16_t) (downloadsize/1024), (uint16_t) ((downloadsize / 1024) * 1000 / ms));
+	}
 }
 
 void remove_download_progress() {
@@ -239,6 +252,7 @@ void remove_download_progress() {
 void init_download_progress(uint32_t size) {
 
 	filesize = size;
+	download_start = NutGetMillis ();
 
 	tft_fill_rect (BYTE2COLOR (100,100,100), DOWNLOAD_PROGRESS_XPOS, DOWNLOAD_PROGRESS_YPOS,
 									DOWNLOAD_PROGRESS_XPOS+DOWNLOAD_PROGRESS_WIDTH,
@@ -284,6 +298,23 @@ uint16_t addr;
 
 	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("TFT Controller= %d, R00=%4.4x"), controller_type, controller_id, lcd_type);
 	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("R-Code %u,   Resolution %u x %u"), lcd_type, get_max_x()+1, get_max_y()+1);
+	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("XRAM %u free banks, %u bank writes/s"), xram_get_free_banks (), xram_get_bank_writes ());
+#ifdef PICTURE_CACHE_SUPPORT
+	    if (picture_cache_get_banks ())
+	    	printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Picture cache %u banks, %lu hits, %lu misses"), picture_cache_get_banks (), picture_cache_get_hits (), picture_cache_get_misses ());
+	    else
+	    	printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Picture cache off, no free XRAM banks"));
+#endif
+	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Pictures from Flash %lu ms, packed to %u%%"), picture_get_flash_draw_time (), picture_get_packed_ratio ());
+	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Project slot %c loaded in %lu ms, %lu Bytes by CPLD"), 'A' + flash_slot_get_active (), project_load_time, copy_flash_dma_bytes);
+	    if (crc_get_check_state () == CRC_CHECK_RUNNING)
+	    	printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Flash check running"));
+	    else if (crc_get_errors ())
+	    	printf_tft_P (TFT_COLOR_RED, TFT_COLOR_WHITE, PSTR("Flash check failed, sections %#x"), crc_get_errors ());
+	    else if (crc_get_check_state () == CRC_CHECK_DONE)
+	    	printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Flash check ok"));
+	    if (get_association_overflow ())
+	    	printf_tft_P (TFT_COLOR_RED, TFT_COLOR_WHITE, PSTR("%u objects not updated, max. %u per address"), get_association_overflow (), EIB_MAX_MSG_OBJECTS);
 
         // Draw Exit Button
         draw_button (EXIT_BUTTON_XPOS, EXIT_BUTTON_YPOS, BUTTON_WIDTH, "Exit");
@@ -305,6 +336,9 @@ uint16_t addr;
 	draw_button (MONITOR_BUTTON_XPOS, MONITOR_BUTTON_YPOS, BUTTON_WIDTH, "Monitor");
 	draw_button (DOWNLOAD_BUTTON_XPOS, DOWNLOAD_BUTTON_YPOS, BUTTON_WIDTH, "Download");
 	draw_button (REBOOT_BUTTON_XPOS, REBOOT_BUTTON_YPOS, BUTTON_WIDTH, "Reboot");
+	// the project of the inactive slot can be used again
+	if (flash_slot_valid (flash_slot_get_active () ^ 1))
+		draw_button (ROLLBACK_BUTTON_XPOS, ROLLBACK_BUTTON_YPOS, BUTTON_WIDTH, "Rollback");
 
 	system_page_active = SYSTEM_PAGE_MAIN;
 }
@@ -419,6 +453,7 @@ static void create_monitor_selection_page (void) {
 
 	draw_button (BUSMON_BUTTON_XPOS, BUSMON_BUTTON_YPOS, BUTTON_WIDTH, "Busmon");
 	draw_button (HARDWARE_MONITOR_BUTTON_XPOS, HARDWARE_MONITOR_BUTTON_YPOS, BUTTON_WIDTH, "Hardware");
+	draw_button (MEMORY_MONITOR_BUTTON_XPOS, MEMORY_MONITOR_BUTTON_YPOS, BUTTON_WIDTH, "Memory");
 	draw_button (EXIT_BUTTON_XPOS, EXIT_BUTTON_YPOS, BUTTON_WIDTH, "Exit");
 
 	// set active system page
@@ -440,6 +475,25 @@ static void create_hardware_monitor_page (void) {
 	system_page_active = SYSTEM_PAGE_HARDWARE_MONITOR;
 }
 
+static void create_memory_monitor_page (void) {
+
+_SYSMON_THREAD_t	t;
+uint8_t	n;
+
+	tft_clrscr(TFT_COLOR_WHITE);
+
+	printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Heap free %u, min. %u"), sysmon_get_heap_free (), sysmon_get_heap_min ());
+	printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Thread     Stack  Unused"));
+	for (n = 0; (n < SYSMON_MAX_THREADS) && sysmon_get_thread (n, &t); n++)
+		printf_tft_P ((t.stack_unused < SYSMON_STACK_MARGIN) ? TFT_COLOR_RED : TFT_COLOR_BLACK, TFT_COLOR_WHITE,
+					  PSTR("%-9s  %5u  %5u"), t.name, t.stack_size, t.stack_unused);
+
+	draw_button (REFRESH_BUTTON_XPOS, REFRESH_BUTTON_YPOS, BUTTON_WIDTH, "Refresh");
+	draw_button (EXIT_BUTTON_XPOS, EXIT_BUTTON_YPOS, BUTTON_WIDTH, "Exit");
+	// set active system page
+	system_page_active = SYSTEM_PAGE_MEMORY_MONITOR;
+}
+
 static void create_busmon_page (void) {
 
 	// clear page contents
@@ -534,6 +588,8 @@ uint8_t s;
 	else {
 		showzifustr(130,60, (unsigned char*)"fail!", TFT_COLOR_BLACK, TFT_COLOR_RED);
 	}
+	// the active project is kept on failure, check it again
+	crc_check_start ();
 
 	// release all allocated resources
 	free (sd_file_names);
@@ -555,6 +611,8 @@ static void create_flash_erase_page (void) {
 	printf_tft_P(TFT_COLOR_RED, TFT_COLOR_BLUE, PSTR("Erasing FLASH..."));
 	// Erase all blocks (128)
 	uint8_t success = erase_complete_flash(FLASH_MAX_SECTOR, 0);
+	// the selector log has been erased too
+	flash_slot_init ();
 
 	tft_set_cursor(70, 145);
 	if (!success) {
@@ -599,7 +657,7 @@ static void create_reboot_confirm_page (void) {
 
 	// write header
     printf_tft_P( TFT_COLOR_BLACK, TFT_COLOR_YELLOW, PSTR("Reboot System"));
-    printf_tft_P( TFT_COLOR_BLACK, TFT_COLOR_YELLOW, PSTR("All object values will be cleared."));
+    printf_tft_P( TFT_COLOR_BLACK, TFT_COLOR_YELLOW, PSTR("Object values will be restored."));
     printf_tft_P( TFT_COLOR_BLACK, TFT_COLOR_YELLOW, PSTR("Are you sure to reboot the system?"));
 
 	draw_button (REBOOT_CONFIRM_BUTTON_XPOS, REBOOT_CONFIRM_BUTTON_YPOS, BUTTON_WIDTH, "Reboot");
@@ -636,6 +694,15 @@ static void process_system_page_event (t_touch_event *evt) {
 				sound_beep_on (0);
 				create_reboot_confirm_page ();
 			}
+			// check, if rollback button is visible and hit
+			if (check_button (ROLLBACK_BUTTON_XPOS, ROLLBACK_BUTTON_YPOS, BUTTON_WIDTH, evt) &&
+				!flash_slot_rollback ()) {
+				sound_beep_on (0);
+				init_system_from_flash ();
+				init_physical_address_from_Flash ();
+				crc_check_start ();
+				create_system_info_screen ();
+			}
 			// check, if Exit button is hit
 			if (check_button (EXIT_BUTTON_XPOS, EXIT_BUTTON_YPOS, BUTTON_WIDTH, evt)) {
 				sound_beep_on (0);
@@ -720,6 +787,10 @@ static void process_system_page_event (t_touch_event *evt) {
 				sound_beep_on (0);
 				create_hardware_monitor_page ();
 			}
+			if (check_button (MEMORY_MONITOR_BUTTON_XPOS, MEMORY_MONITOR_BUTTON_YPOS, BUTTON_WIDTH, evt)) {
+				sound_beep_on (0);
+				create_memory_monitor_page ();
+			}
 			// check, if Exit button is hit
 			if (check_button (EXIT_BUTTON_XPOS, EXIT_BUTTON_YPOS, BUTTON_WIDTH, evt)) {
 				sound_beep_on (0);
@@ -739,6 +810,19 @@ static void process_system_page_event (t_touch_event *evt) {
 				create_system_info_screen ();
 			}
 		}
+		else if (system_page_active == SYSTEM_PAGE_MEMORY_MONITOR) {
+
+			// read the values again
+			if (check_button (REFRESH_BUTTON_XPOS, REFRESH_BUTTON_YPOS, BUTTON_WIDTH, evt)) {
+				sound_beep_on (0);
+				create_memory_monitor_page ();
+			}
+			// check, if Exit button is hit
+			if (check_button (EXIT_BUTTON_XPOS, EXIT_BUTTON_YPOS, BUTTON_WIDTH, evt)) {
+				sound_beep_on (0);
+				create_system_info_screen ();
+			}
+		}
 		else if (system_page_active == SYSTEM_PAGE_FLASH_CONTROL) {
 
 			// check, if Flash Erase button is hit
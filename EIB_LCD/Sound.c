@@ -182,7 +182,8 @@ uint16_t next_value;
 				ampl_i = 0; 
 		}
 	}
-	else if (sound_clip_playing) {
+	// the Flash returns status bits while it is erased or programmed, the clip stops
+	else if (sound_clip_playing && !flash_busy) {
 		// Clip
 		// get next sound value
 		next_value = read_flash_int(sound_sector, sound_offset);
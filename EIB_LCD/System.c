@@ -17,43 +17,144 @@
 #include <avr/wdt.h>
 
 volatile uint8_t display_orientation;
+uint32_t project_load_time;
+// CPLD mode RAM_WRITE_ON_FLASH_READ works, see copy_Flash_to_XRAM_test()
+uint8_t copy_flash_dma;
+uint32_t copy_flash_dma_bytes;
 const uint8_t port_bit[7] = { 0x01, 0x02, 0x04, 0x10, 0x20, 0x40, 0x80 };
 //"PE0 (1)", "PE1 (9)", "PE2 (LP)", "PF4 (4)", "PF5 (7)", "PF6 (5)", "PF7 (6)"
 const char channel_names[7][4] = { "PE0", "PE1", "PE2", "PF4", "PF5", "PF6", "PF7" };
 
 
-// copies data from Flash to xram. Can NOT handle sector overflows!
-// stores data starting from 1st XRAM Bank address
+// copies data from Flash to xram
+// flash_sector, flash_offset: start in Flash, flash_offset is a byte offset
+// xram_block, xram_offset: start in XRAM
+// The copy continues in the next Flash sector and in the next XRAM bank.
 void copy_Flash_to_XRAM (uint8_t flash_sector, uint16_t flash_offset, uint8_t xram_block, uint16_t xram_offset, uint16_t byte_count) {
 
-uint16_t 	fdata;
-volatile uint8_t*	p;
+	copy_Flash_to_XRAM_check (flash_sector, flash_offset, xram_block, xram_offset, byte_count, NULL, NULL);
+}
+
+// checks the CPLD mode RAM_WRITE_ON_FLASH_READ with the first bytes of the project header
+// The mode is not documented, see MemoryMap.h. It is used by copy_Flash_to_XRAM_check(), if
+// the CPLD has copied the header like the CPU does, otherwise the CPU copies all words.
+// The bytes are copied to the TOC page, which is overwritten by the TOC afterwards.
+void copy_Flash_to_XRAM_test (void) {
+
+volatile uint8_t	b;
+uint8_t		*p;
+uint16_t	w;
+uint8_t		i;
+
+	XRAM_SELECT_BLOCK (XRAM_TOC_PAGE);
+	p = (uint8_t*) XRAM_BASE_ADDRESS;
+	memset (p, 0, COPY_FLASH_TEST_BYTES);
+
+	FLASH_SELECT_SECTOR (0);
+	OUTB (CPLD_BASE_ADDR + MODE_CTRL_ADDR, 1 << RAM_WRITE_ON_FLASH_READ);
+	for (i = 0; i < COPY_FLASH_TEST_BYTES / 2; i++)
+		b = INB(FLASH_BASE_ADDRESS + i);
+	OUTB (CPLD_BASE_ADDR + MODE_CTRL_ADDR, 0x00);
+
+	copy_flash_dma = 1;
+	for (i = 0; i < COPY_FLASH_TEST_BYTES / 2; i++) {
+		w = read_flash (0, i);
+		if ((p[2*i] != (w & 0xff)) || (p[2*i +1] != ((w >> 8) & 0xff)))
+			copy_flash_dma = 0;
+	}
+#ifdef LCD_DEBUG
+	printf_P (PSTR("\nCPLD copy mode %s"), copy_flash_dma ? "ok" : "not supported");
+#endif
+}
+
+// copies data from Flash to xram and adds the copied bytes to the CRC-32 and XOR checksum
+// crc, checksum: updated, if not NULL
+// The CPLD copies the words, if the Flash and the XRAM offset are the same within a bank,
+// see copy_Flash_to_XRAM_test(). The rest is copied by the CPU.
+void copy_Flash_to_XRAM_check (uint8_t flash_sector, uint16_t flash_offset, uint8_t xram_block, uint16_t xram_offset, uint16_t byte_count,
+							   uint32_t *crc, uint8_t *checksum) {
 
+volatile uint8_t	b;
+uint16_t	address;
+uint8_t		*p;
+uint8_t		data[2*COPY_FLASH_BURST_WORDS];
+uint8_t		i;
+uint16_t	n, k;
 
 	if (!byte_count)
 		return;
 
-	p = (uint8_t*)(xram_offset+XRAM_BASE_ADDRESS);
 	// set xram page
 	XRAM_SELECT_BLOCK (xram_block);
-
-	// check, if starting on odd byte address
-	if (flash_offset & 0x01) {
-		fdata = read_flash (flash_sector, (flash_offset >> 1) & 0x7fff);
-		*p++ = (fdata >> 8) & 0xff;
-		byte_count--;
+	p = (uint8_t*) (XRAM_BASE_ADDRESS + xram_offset);
+	// select sector once, disable dma functions
+	FLASH_SELECT_SECTOR (flash_sector);
+	OUTB (CPLD_BASE_ADDR + MODE_CTRL_ADDR, 0x00);
+	address = FLASH_BASE_ADDRESS + ((flash_offset >> 1) & 0x7fff);
+	// starting on odd byte address: skip the low byte of the first word
+	i = flash_offset & 0x01;
+
+	if (copy_flash_dma && !i && ((flash_offset & (XRAM_BANK_SIZE -1)) == xram_offset)) {
+		while (byte_count > 1) {
+			// words up to the end of the bank
+			n = min (byte_count >> 1, (uint16_t) ((uint8_t*) (XRAM_BASE_ADDRESS + XRAM_BANK_SIZE) - p) >> 1);
+			// interrupts reading the Flash restore the mode, see read_flash_int()
+			OUTB (CPLD_BASE_ADDR + MODE_CTRL_ADDR, 1 << RAM_WRITE_ON_FLASH_READ);
+			for (k = n; k; k--) {
+				b = INB(address);
+				// continue in the next sector
+				if (!++address) {
+					address = FLASH_BASE_ADDRESS;
+					FLASH_SELECT_SECTOR (++flash_sector);
+				}
+			}
+			OUTB (CPLD_BASE_ADDR + MODE_CTRL_ADDR, 0x00);
+			copy_flash_dma_bytes += 2*n;
+			byte_count -= 2*n;
+
+			for (k = 2*n; k; k--, p++) {
+				if (crc)
+					*crc = crc32_byte (*crc, *p);
+				if (checksum)
+					*checksum ^= *p;
+			}
+			if (p == (uint8_t*) (XRAM_BASE_ADDRESS + XRAM_BANK_SIZE)) {
+				p = (uint8_t*) XRAM_BASE_ADDRESS;
+				XRAM_SELECT_BLOCK (++xram_block);
+			}
+		}
 	}
-	flash_offset = ((flash_offset+1) >> 1) & 0x7fff;
 
 	while (byte_count) {
-		// get flash contents
-		fdata = read_flash (flash_sector, flash_offset++);
-		// write xram data
-		*p++ = fdata & 0xff;
-		if (--byte_count) {
+		// The CPLD keeps the high byte of a word until the next Flash read and
+		// interrupts may read the Flash, so a burst of words is read atomically.
+		n = min (((uint32_t) byte_count + i +1) >> 1, COPY_FLASH_BURST_WORDS);
+		NutEnterCritical ();
+		for (k = 0; k < n; k++) {
+			data[2*k +1] = INB(address);
+			data[2*k] = INB(CPLD_BASE_ADDR + UPPER_DATA_RD_ADDR);
+			// continue in the next sector
+			if (!++address) {
+				address = FLASH_BASE_ADDRESS;
+				FLASH_SELECT_SECTOR (++flash_sector);
+			}
+		}
+		NutExitCritical ();
+
+		// the checksums of the burst are calculated with interrupts enabled
+		for (k = i; (k < 2*n) && byte_count; k++) {
+			*p++ = data[k];
 			byte_count--;
-			*p++ = (fdata >> 8) & 0xff;
+			if (crc)
+				*crc = crc32_byte (*crc, data[k]);
+			if (checksum)
+				*checksum ^= data[k];
+			if (p == (uint8_t*) (XRAM_BASE_ADDRESS + XRAM_BANK_SIZE)) {
+				p = (uint8_t*) XRAM_BASE_ADDRESS;
+				XRAM_SELECT_BLOCK (++xram_block);
+			}
 		}
+		i = 0;
 	}
 }
 
@@ -102,10 +203,12 @@ int8_t	init_system_from_flash (void) {
 
 uint8_t	toc_items;
 uint8_t tft_config;
+uint32_t start;
 
 	// check Flash contents
 	flash_content_bad = 1;
 	toc_items = 0;
+	start = NutGetMillis ();
 
 	// check magic
 	if ((read_flash (LCD_HEADER_MAGIC_ADDR_0) != LCD_HEADER_MAGIC_0) ||
@@ -115,7 +218,8 @@ uint8_t tft_config;
 		return -2;
     }
 	// check version
-	  else if (( read_flash (LCD_HEADER_VERSION_ADDR) & 0xff) != LCD_VERSION_EXPECTED) {
+	lcd_file_version = read_flash (LCD_HEADER_VERSION_ADDR) & 0xff;
+	if ((lcd_file_version != LCD_VERSION_EXPECTED) && (lcd_file_version != LCD_VERSION_COMPAT)) {
         flash_content_bad = 3;
 		return -3;
     }
@@ -141,8 +245,17 @@ uint8_t tft_config;
         //read_flash ( LCD_HEADER_DIMMING) & 0xff
 		// copy TOC to xram
 		toc_items = read_flash (LCD_TOC_ADDR >> 1) & 0xff;
+		copy_Flash_to_XRAM_test ();
+		copy_flash_dma_bytes = 0;
 		copy_Flash_to_XRAM (LCD_TOC_ADDR, XRAM_TOC_ADDR, TOC_HEADER_SIZE + toc_items*TOC_ITEMS_SIZE);
+		// sections are verified by the CRC table, if the project has one
+		crc_init ();
 		// check TOC contents
+		// sections of the previous project are dropped
+		xram_init ();
+		picture_reset ();
+		clear_association_table ();
+		eib_object_clear_sizes ();
 int i;
 _LCD_FILE_TOC_ENTRY_t	*toc;
 		toc = (_LCD_FILE_TOC_ENTRY_t*) (TOC_HEADER_SIZE + XRAM_BASE_ADDRESS);
@@ -167,7 +280,8 @@ foffset = (toc->flash_position >> 1) & 0x7fff;
 				break;
 				// picture table
 				case 4:
-					set_picture_table_start_address (toc->flash_position);
+					// copy picture descriptors into RAM mirror
+					printf_tft_P( TFT_COLOR_WHITE, TFT_COLOR_BLACK, PSTR("move picture table returned: %d"), move_picture_table (toc->flash_position, toc->size));
 				break;
 				// sound table
 				case 5:
@@ -181,20 +295,47 @@ foffset = (toc->flash_position >> 1) & 0x7fff;
 					// copy cyclic elements descriptions into RAM mirror
 					printf_tft_P( TFT_COLOR_WHITE, TFT_COLOR_BLACK, PSTR("move cyclic element description returned: %d"), move_cyclic_descriptions (toc->flash_position, toc->size));
 				break;
+				// association table
+				case 8:
+					// copy association table into RAM mirror
+					printf_tft_P( TFT_COLOR_WHITE, TFT_COLOR_BLACK, PSTR("move association table returned: %d"), move_association_table (toc->flash_position, toc->size));
+				break;
+				// object size table
+				case 9:
+					// copy object sizes into RAM mirror
+					printf_tft_P( TFT_COLOR_WHITE, TFT_COLOR_BLACK, PSTR("move object size table returned: %d"), move_object_sizes (toc->flash_position, toc->size));
+				break;
+				// CRC table, see crc_init()
+				case CRC_TOC_TYPE_TABLE:
+				break;
 				default:
 					printf_tft_P( TFT_COLOR_WHITE, TFT_COLOR_RED, PSTR("unknown type %d"), toc->type);
 			}
 			toc++;
 		}
 
+		// cache pictures in the banks not used by the sections
+		picture_cache_init ();
 		// Flash content valid now
         flash_content_bad = 0;
+		// associate objects and group addresses
+		init_association_table ();
 		// set all EIB objects to 0
 		eib_object_init ();
+		// restore object values saved before reboot
+		snapshot_restore ();
+		// collect objects to be read from the bus
+		read_sweep_init ();
 		// init hardware
         // TODO: Do we need this here? Isn't this done by element init?
 		lcd_init_listen_objects ();
 		lcd_init_cyclic_objects ();
+
+		project_load_time = NutGetMillis () - start;
+		printf_tft_P( TFT_COLOR_WHITE, TFT_COLOR_BLACK, PSTR("project loaded in %lu ms, %lu Bytes copied by CPLD"), project_load_time, copy_flash_dma_bytes);
+#ifdef LCD_DEBUG
+		printf_P (PSTR("\nProject loaded in %lu ms, %lu Bytes copied by CPLD"), project_load_time, copy_flash_dma_bytes);
+#endif
 	}
 
 	return 0;
@@ -208,6 +349,9 @@ uint16_t phys_addr;
 	phys_addr = (phys_addr >> 8) & 0xff;
 	phys_addr |= (read_flash (LCD_HEADER_PHYSICAL_ADDR_HB) << 8) & 0xff00;
 	eib_set_device_address(EIB_DEVICE_CHANNEL, phys_addr);
+#ifdef EIBNET_SUPPORT
+	eib_set_device_address(EIB_EIBNET_CHANNEL, eibnet_tunnel_address (phys_addr));
+#endif
 }
 
 /*
@@ -274,14 +418,21 @@ uint8_t check_lcd_type_code (void) {
 }
 
 
-// return: 0=ok, 1=file error, 2=out of mem, 3 out of heap
+// return: 0=ok, 1=file error, 2=out of mem or file too large, 3=Flash error
 uint8_t download_file_from_sd_card (_LCD_FILE_NAMES_t *fname) {
 
-	init_hardware_objects ();
-
 	init_download_progress(fname->size);
 
-	uint8_t result = file_2_nand_flash ( fname->fname83, 0);
+	// the project is written into the inactive slot, the active project keeps running
+	uint8_t slot = flash_slot_get_active () ^ 1;
+	uint8_t result = file_2_nand_flash ( fname->fname83, (uint32_t) FLASH_SLOT_FIRST_SECTOR(slot) << 15,
+										 FLASH_SLOT_FIRST_SECTOR(slot) + FLASH_SLOT_SECTORS);
+	// switch to the new project once it has been verified
+	if (!result) {
+		if (flash_slot_select (slot))
+			result = 3;
+		else init_hardware_objects ();
+	}
 	remove_download_progress();
 	return result;
 }
@@ -370,6 +521,9 @@ _LCD_FILE_NAMES_t *current_fname;
 /* reboot the system by WDT overflow */
 void reboot () {
 
+	// keep object values
+	snapshot_save ();
+
 	// disable interrupts
 	NutEnterCritical ();
 
@@ -27,14 +27,25 @@
 #include "TPUart.h"
 #include "EIBLayers.h"
 #include "EIBObjects.h"
+#include "dpt.h"
+#include "EIBNet.h"
 #include "MemoryMap.h"
+#include "xram.h"
+#include "sysmon.h"
+#include "crc.h"
 #include "NandFlash.h"
 #include "ScreenCtrl.h"
 #include "page.h"
 #include "picture.h"
 #include "addr_tab.h"
+#include "assoc_tab.h"
 #include "listen.h"
 #include "cyclic.h"
+#include "snapshot.h"
+#include "flash_slot.h"
+#include "read_sweep.h"
+#include "history.h"
+#include "compat.h"
 
 #include <dev/board.h>
 //#include <dev/adc.h>
@@ -109,7 +120,10 @@ uint8_t		checksum;
 #define	LCD_HEADER_MAGIC_2			0x4443
 // V1.0
 #define LCD_HEADER_VERSION_ADDR		0, 0x03
-#define LCD_VERSION_EXPECTED		0x1E
+// 0x1F: 16 bit object numbers and element counts, force and init flags of page elements
+#define LCD_VERSION_EXPECTED		0x1F
+// older structure version, converted while loading
+#define LCD_VERSION_COMPAT			0x1E
 // Physical Address
 #define LCD_HEADER_PHYSICAL_ADDR_LB	0, 0x03
 #define LCD_HEADER_PHYSICAL_ADDR_HB	0, 0x04
@@ -137,8 +151,9 @@ char		fname83[MAX_NAME_LENGTH];
 uint32_t	size;
 } _LCD_FILE_NAMES_t;
 
-#define	XRAM_SELECT_BLOCK(blk)		OUTB(CPLD_BASE_ADDR + RAM_BANK_ADDR, blk)
-#define	XRAM_GET_SELECTED_BLOCK		INB(CPLD_BASE_ADDR + RAM_BANK_ADDR)
+// the selected bank is mirrored in xram_bank, selecting it again costs no CPLD write
+#define	XRAM_SELECT_BLOCK(blk)		xram_select_block (blk)
+#define	XRAM_GET_SELECTED_BLOCK		xram_bank
 #define XRAM_SECTOR_SIZE			0x2000
 #define XRAM_MAX_SECTOR				61
 
@@ -148,7 +163,8 @@ uint32_t	size;
 //EIB_LCD.c
 extern const bootldrinfo_t bootlodrinfo;
 //EIB_LCD.c
-extern uint8_t flash_content_bad;
+extern uint8_t flash_content_bad;
+extern uint8_t lcd_file_version;
 
 
 /* DeviceCtrl.c */
@@ -166,12 +182,25 @@ short read_from_NVMEM (char *data, short len, short NVOffset);
 #define DISPLAY_ORIENTATION_UPSIDE	3
 
 extern volatile uint8_t display_orientation;
-// copies data from Flash to xram. Can NOT handle sector overflows!
+// words read from Flash with interrupts disabled, 16 words take about 10us
+#define COPY_FLASH_BURST_WORDS	16
+// copies data from Flash to xram, crosses Flash sectors and XRAM banks
 void copy_Flash_to_XRAM (uint8_t, uint16_t, uint8_t, uint16_t, uint16_t);
+// copies data and updates CRC-32 and XOR checksum, if not NULL
+void copy_Flash_to_XRAM_check (uint8_t, uint16_t, uint8_t, uint16_t, uint16_t, uint32_t*, uint8_t*);
+// bytes of the project header used to test the CPLD copy mode
+#define COPY_FLASH_TEST_BYTES	64
+// checks, if the CPLD copies Flash words into XRAM
+void copy_Flash_to_XRAM_test (void);
+// CPLD copy mode works, bytes copied by the CPLD
+extern uint8_t copy_flash_dma;
+extern uint32_t copy_flash_dma_bytes;
 // init hardware to default state
 void init_hardware (void);
 // init block device for SD card read
 void init_sd_card (void);
+// time to load the project from Flash [ms]
+extern uint32_t project_load_time;
 // evaluate flash contents and init system
 int8_t	init_system_from_flash (void);
 // tries to download config file from SD card
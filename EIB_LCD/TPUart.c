@@ -13,6 +13,8 @@
  * message queue. Contents of the transmit message are copied, therefore the caller
  * can immediately reuse the submitted message buffer. The return value informs about
  * sucess, if the message buffer was not full.
+ * Each virtual device channel owns its own transmit queue. The queues are served
+ * round robin, so a busy channel can not starve the other one.
  *
  * The functions eib_L_DATA_indication_wait and eib_L_DATA_indication_poll retrieve
  * received messages from the reception buffer. The ack field of the message contains
@@ -29,6 +31,7 @@
  *
  */
 #include "TPUart.h"
+#include "sysmon.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -39,9 +42,13 @@ uint8_t							eib_rx_checksum;//checksum of RX message
 
 //message buffers for Network Layer communication
 t_eib_frame		eib_rx_buffer[EIB_RX_BUFFERS];
-t_eib_frame		eib_tx_buffer[EIB_TX_BUFFERS];
+t_eib_frame		eib_tx_buffer[EIB_VIRTUAL_DEVICES][EIB_TX_BUFFERS];
 int				eib_rx_out, eib_rx_in;	// pointers for receive message buffer queue
-int				eib_tx_out, eib_tx_in;	// pointers for transmit message buffer queue
+int				eib_tx_out[EIB_VIRTUAL_DEVICES], eib_tx_in[EIB_VIRTUAL_DEVICES];	// pointers for transmit message buffer queues
+uint8_t			eib_tx_channel;			// virtual channel of the message in transmission
+t_eib_frame*	eib_tx_msg;				// message in transmission
+uint8_t			eib_tx_confirm;			// L_Data.confirm of the message sent to the TPUART
+uint8_t			eib_tx_confirm_pending;	// message has been sent, confirm not yet reported
 
 enum e_eib_transmitter_states		eib_trans_state;	//state of the TPUART transmitter state machine
 //byte counter for tx function
@@ -187,8 +194,11 @@ uint8_t rx_flags = 0; 	// error flags of new data byte
 			// was it a time out?
 			if (arg == RECV_INT) {
 				// store ACK to RX buffer, if no UART error flags
-				if (!rx_flags)
+				if (!rx_flags) {
 					eib_rx_buffer[eib_rx_in].ack = rx_byte;
+					if (eib_trans_state == TX_WAIT)
+						eib_tx_confirm = rx_byte;
+				}
 				// received confirmation for last TX message
 				eib_trans_state = TX_IDLE;
 				// trigger transmitter to sent next TX message to TPUART
@@ -288,13 +298,13 @@ static void eib_tx_interrupt (void *arg)
 	else switch (eib_trans_state) {
 		case TX_NEXT:
 			//sent next ctrl and data byte to TPUART
-			eib_tx_msg_byte_value = eib_tx_buffer[eib_tx_out].frame[eib_tx_buf_i];
+			eib_tx_msg_byte_value = eib_tx_msg->frame[eib_tx_buf_i];
 			eib_tx_msg_byte_flag = 1;
 			//update checksum
 			eib_tx_checksum ^= eib_tx_msg_byte_value;
 			EIB_UDR = U_L_DATA_CONTINUE | eib_tx_buf_i++;
 			//last byte is the checksum
-			if (eib_tx_buffer[eib_tx_out].len == eib_tx_buf_i)
+			if (eib_tx_msg->len == eib_tx_buf_i)
 				eib_trans_state = TX_CHECK;
 		break;
 		case TX_CHECK:
@@ -305,9 +315,12 @@ static void eib_tx_interrupt (void *arg)
 			// next state is waiting for the ACK from TPUART
 			eib_trans_state = TX_WAIT;
 			eib_ack_timeout = 0;
-			// next send buffer
-			if (++eib_tx_out >= EIB_TX_BUFFERS)
-				eib_tx_out = 0;
+			// a missing confirm is reported as negative confirm
+			eib_tx_confirm = TPUART_L_DATA_NO_CONFIRM;
+			eib_tx_confirm_pending = 1;
+			// next send buffer of this channel
+			if (++eib_tx_out[eib_tx_channel] >= EIB_TX_BUFFERS)
+				eib_tx_out[eib_tx_channel] = 0;
 		break;
 		default: 
 			EIB_TXINT_DISABLE
@@ -319,6 +332,8 @@ THREAD(eib_process_tx_queue, arg)
 {
 #define MAX_TX_WAIT 3000	// timeout 3s
 
+uint8_t	i;
+
 	NutThreadSetPriority(NUT_THREAD_PRIORITY_EIB_SERVE_TX);
     /*
      * Now loop endless for new EIB TX messages
@@ -328,10 +343,27 @@ THREAD(eib_process_tx_queue, arg)
     for (;;) {
 
 		NutEventWait (&eib_tx_event, NUT_WAIT_INFINITE);
+		// report the confirm of the last message, before the next one is started.
+		// A reset of the TPUART or the deadlock check end the wait without confirm.
+		if (eib_tx_confirm_pending && (eib_trans_state == TX_IDLE)) {
+			eib_tx_confirm_pending = 0;
+			eib_L_DATA_confirm (eib_tx_channel, eib_tx_confirm == TPUART_L_DATA_CONFIRM_OK);
+		}
 		// are we online?
-		if ((eib_state == EIB_NORMAL) && ( eib_trans_state == TX_IDLE )
-			  && (eib_tx_out != eib_tx_in) ) {
+		if ((eib_state != EIB_NORMAL) || ( eib_trans_state != TX_IDLE ))
+			continue;
+
+		// serve the virtual channels round robin, starting behind the last served one
+		for (i=0; i<EIB_VIRTUAL_DEVICES; i++) {
+			if (++eib_tx_channel >= EIB_VIRTUAL_DEVICES)
+				eib_tx_channel = 0;
+			if (eib_tx_out[eib_tx_channel] != eib_tx_in[eib_tx_channel])
+				break;
+		}
+
+		if (i < EIB_VIRTUAL_DEVICES) {
 			// we have a new message and no pending transmission
+			eib_tx_msg = &eib_tx_buffer[eib_tx_channel][eib_tx_out[eib_tx_channel]];
 
 			// start sending
 			eib_tx_buf_i = 0; // index of next message byte of tx message
@@ -418,15 +450,16 @@ void eib_check_state (void)
 char eib_L_DATA_request (t_eib_frame *msg, uint8_t channel) {
 
 int i;
+t_eib_frame *p;
 
 	if (channel >= EIB_VIRTUAL_DEVICES)
 		return 0;
 
-	i = eib_tx_in+1;
+	i = eib_tx_in[channel]+1;
 	if (i >= EIB_TX_BUFFERS)
 		i = 0;
 	NutEnterCritical();
-	if (i == eib_tx_out) {
+	if (i == eib_tx_out[channel]) {
 		//buffer overflow, ignore message
 		NutExitCritical();
 		return 0;
@@ -436,15 +469,16 @@ int i;
 	// copy message into transmission buffer
 	if (msg->len > FRAME_LEN)
 		return -1;
-	memcpy (&(eib_tx_buffer[eib_tx_in].frame[0]), &(msg->frame[0]), msg->len);	
+	p = &eib_tx_buffer[channel][eib_tx_in[channel]];
+	memcpy (&(p->frame[0]), &(msg->frame[0]), msg->len);	
 	// set my device address
-	eib_tx_buffer[eib_tx_in].frame[1] = device_address[channel] & 0xff;
-	eib_tx_buffer[eib_tx_in].frame[2] = (device_address[channel] >> 8) & 0xff;
-	eib_tx_buffer[eib_tx_in].len = msg->len;
+	p->frame[1] = device_address[channel] & 0xff;
+	p->frame[2] = (device_address[channel] >> 8) & 0xff;
+	p->len = msg->len;
 
 	// avoid interruption by interrupt services
 	NutEnterCritical();
-	eib_tx_in = i;
+	eib_tx_in[channel] = i;
 	NutExitCritical();
 	NutEventPost (&eib_tx_event);
 	return 1;
@@ -541,7 +575,7 @@ char eib_control (enum eib_command_codes cmd) {
 		    NutRegisterIrqHandler(&EIB_TX_INT, eib_tx_interrupt, NULL );
 
 			// create send process
-			NutThreadCreate("EIB_TX", eib_process_tx_queue, 0, NUT_THREAD_EIB_TX_STACK);
+			sysmon_thread_create("EIB_TX", eib_process_tx_queue, 0, NUT_THREAD_EIB_TX_STACK);
 			eib_tpuart_cmd = U_NO_COMMAND;
 			eib_recv_state = RX_IDLE;
 			EIB_RELEASE_TPUART
@@ -596,19 +630,23 @@ uint16_t eib_get_device_address (uint8_t channel) {
 
 
 /**
-* @brief check, if the TX buffer is less than half full
+* @brief check, if the TX buffer of a virtual channel is less than half full
 *
 * This function returns 1, if more than half of the TX buffer is free.
-* It returns 0, if more than half of the TX buffer is already occupied.
+* It returns 0, if more than half of the TX buffer is already occupied
+* or the channel is invalid.
 */
-uint8_t eib_check_tx_space (void) {
+uint8_t eib_check_tx_space (uint8_t channel) {
 
 uint8_t tx_used;
 
+	if (channel >= EIB_VIRTUAL_DEVICES)
+		return 0;
+
 	NutEnterCritical();
-	if (eib_tx_in >= eib_tx_out)
-		tx_used = eib_tx_in - eib_tx_out;
-	else tx_used = EIB_TX_BUFFERS - (eib_tx_out - eib_tx_in);
+	if (eib_tx_in[channel] >= eib_tx_out[channel])
+		tx_used = eib_tx_in[channel] - eib_tx_out[channel];
+	else tx_used = EIB_TX_BUFFERS - (eib_tx_out[channel] - eib_tx_in[channel]);
 	NutExitCritical();
 
 	if (tx_used < (EIB_TX_BUFFERS / 2))
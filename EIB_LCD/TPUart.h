@@ -122,7 +122,8 @@ enum e_eib_transmitter_states
 #define EIB_L_DATA_INDICATION	1
 // Define amount of buffers for communication with Network Layer
 #define EIB_RX_BUFFERS	16
-#define EIB_TX_BUFFERS	16
+// TX buffers are allocated per virtual device channel
+#define EIB_TX_BUFFERS	8
 
 //*****************************************
 // codes sent to TPUART
@@ -166,6 +167,11 @@ enum e_eib_transmitter_states
 // ACK request of this driver.
 extern unsigned char eib_check_group_address (uint16_t);
 
+// external function for the confirmation of sent messages must be defined in project.
+// It is called by the transmit thread for each message of a virtual device channel
+// sent to the TPUART. Argument ok= 1: positive confirm, 0: negative or missing confirm
+extern void eib_L_DATA_confirm (uint8_t, uint8_t);
+
 /**
 * @brief virtual channels of EIB interface
 *
@@ -203,8 +209,8 @@ uint8_t eib_set_device_address (uint8_t, uint16_t);
 //get device address of virtual channel
 uint16_t eib_get_device_address (uint8_t);
 
-//check, if the TX buffer is less than half full
-uint8_t eib_check_tx_space (void);
+//check, if the TX buffer of a virtual channel is less than half full
+uint8_t eib_check_tx_space (uint8_t);
 
 // check, if TX is in deadlock state and restart, if needed.
 void eib_check_tx_deadlock(void);
@@ -17,19 +17,63 @@
 #include "addr_tab.h"
 
 uint16_t address_tab_length;
+uint8_t	 address_tab_sorted;
+// first bank of the address table
+uint8_t	 address_tab_bank;
+
+// number of addresses in a bank
+#define ADDRESS_TAB_BANK_ENTRIES	(XRAM_BANK_SIZE / 2)
+
+// select bank of address i and get its address
+static uint16_t* address_tab_select (uint16_t i) {
+
+	XRAM_SELECT_BLOCK(address_tab_bank + i / ADDRESS_TAB_BANK_ENTRIES);
+	return (uint16_t*) XRAM_BASE_ADDRESS + (i % ADDRESS_TAB_BANK_ENTRIES);
+}
 
 // moves address table from Flash into RAM. Purpose is fast and easy access to Bytes.
+// The table may span several banks.
 // flash offset: start address in Flash
 // size: size of page descriptions in Byte
 uint8_t move_address_table (uint32_t flash_offset, uint32_t size) {
 
-	// we can only handle sizes up to one XRAM page
-	if (size > XRAM_BANK_SIZE)
+_XRAM_LOADER_t	ld;
+uint16_t	prev, val;
+uint16_t	i;
+uint16_t	n;
+uint8_t		banks;
+
+	address_tab_length = 0;
+
+	banks = (size + XRAM_BANK_SIZE -1) / XRAM_BANK_SIZE;
+	if (!banks || (banks > XRAM_SECTION_MAX_BANKS))
+		return 2;
+	address_tab_bank = xram_alloc (banks);
+	if (!address_tab_bank)
 		return 2;
 
-	// move page descriptions from Flash into XRAM
-	copy_Flash_to_XRAM ((flash_offset >> 16) & 0xff, flash_offset & 0xffff, XRAM_GROUP_ADDR, size);
+	// move address table from Flash into XRAM, bank by bank
+	xram_loader_init (&ld, address_tab_bank, banks, flash_offset);
 	address_tab_length = size >> 1;
+	for (; size; size -= n) {
+		n = min (size, XRAM_BANK_SIZE);
+		xram_load_block (&ld, n);
+	}
+	// projects without CRC table are not checked
+	if (crc_verify (ld.start, ld.flash - ld.start, ld.crc, ld.crc_pos) == CRC_ERROR) {
+		address_tab_length = 0;
+		return 1;
+	}
+
+	// binary search requires a table sorted by group address
+	address_tab_sorted = 1;
+	prev = 0;
+	for (i = 0; i < address_tab_length; i++) {
+		val = I2M(*address_tab_select (i));
+		if (i && (val <= prev))
+			address_tab_sorted = 0;
+		prev = val;
+	}
 
 	return 0;
 }
@@ -43,21 +87,36 @@ int get_group_adress_index (uint16_t addr) {
 uint16_t *po;	// pointer to address
 uint8_t	 save_xram_page;
 int i;
+uint16_t lo, hi, key, val;
 
 	save_xram_page = XRAM_GET_SELECTED_BLOCK;
 
-	// set address descriptions bank
-	XRAM_SELECT_BLOCK(XRAM_GROUP_PAGE);
-	po = (uint16_t*) XRAM_BASE_ADDRESS;
+	// addresses are stored HB/LB, compare them in main/middle/sub order
+	if (address_tab_sorted) {
+		key = I2M(addr);
+		lo = 0;
+		hi = address_tab_length;
+		while (lo < hi) {
+			i = (lo + hi) >> 1;
+			val = I2M(*address_tab_select (i));
+			if (val == key) {
+				XRAM_SELECT_BLOCK(save_xram_page);
+				return i;
+			}
+			if (val < key)
+				lo = i +1;
+			else hi = i;
+		}
+		XRAM_SELECT_BLOCK(save_xram_page);
+		return -1;
+	}
 
 	for (i = 0; i < address_tab_length; i++) {
+		po = address_tab_select (i);
 		if (addr == *po) {
 			XRAM_SELECT_BLOCK(save_xram_page);
 			return i;
 		}
-		else {
-			po++;
-		}
 	}
 
 	XRAM_SELECT_BLOCK(save_xram_page);
@@ -65,15 +124,20 @@ int i;
 }
 
 // get address i
-uint16_t get_group_address (uint8_t i) {
+uint16_t get_group_address (uint16_t i) {
 
 uint16_t *po;	// pointer to address
+uint16_t addr;
+uint8_t	 save_xram_page;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
 
 	// set address descriptions bank
-	XRAM_SELECT_BLOCK(XRAM_GROUP_PAGE);
-	po = (uint16_t*) XRAM_BASE_ADDRESS;
-	po += i;
-	return *po;
+	po = address_tab_select (i);
+	addr = *po;
+
+	XRAM_SELECT_BLOCK(save_xram_page);
+	return addr;
 }
 
 uint16_t get_address_tab_length (void) {
@@ -19,9 +19,11 @@
 // moves the address table from Flash into RAM
 // returns 0 if ok
 // returns 1 on checksum error
+// returns 2 if there are not enough XRAM banks
 uint8_t move_address_table (uint32_t, uint32_t);
 
-// checks, if address exists in sorted table and returns the index.
+// checks, if address exists in table and returns the index.
+// Sorted tables are searched binary, others linear.
 // -1: not existing
 // 0: first address
 // 1...
@@ -30,6 +32,6 @@ int get_group_adress_index (uint16_t);
 // get length of address table
 uint16_t get_address_tab_length (void);
 // get address i
-uint16_t get_group_address (uint8_t); 
+uint16_t get_group_address (uint16_t); 
 
 #endif // _GROUP_H_
@@ -0,0 +1,209 @@
+/** \file assoc_tab.c
+ *  \brief Functions for the association of EIB objects and group addresses
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- move association table from Nand Flash into XRAM
+ *	- get all objects associated with a received group address
+ *	- get the send address of an object
+ *
+ *	Projects without association table use a 1:1 association: the object
+ *	number is the index of its group address in the address table.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "assoc_tab.h"
+
+uint16_t association_tab_length;
+uint16_t object_count;
+// number of associations dropped, since the buffer for the objects of a message was full
+uint16_t association_overflow;
+
+// moves association table from Flash into RAM.
+// flash offset: start address in Flash
+// size: size of association table in Byte
+uint8_t move_association_table (uint32_t flash_offset, uint32_t size) {
+
+_ASSOCIATION_ENTRY_t *pa;
+uint16_t i;
+uint32_t crc;
+
+	association_tab_length = 0;
+	association_overflow = 0;
+
+	// table and send address table must fit into one XRAM page
+	if (size > ASSOCIATION_SEND_TABLE_OFFSET)
+		return 2;
+
+	// move association table from Flash into XRAM
+	crc = CRC32_INIT;
+	copy_Flash_to_XRAM_check ((flash_offset >> 16) & 0xff, flash_offset & 0xffff, XRAM_ASSOC_ADDR, size, &crc, NULL);
+	if (crc_verify (flash_offset, size, crc, flash_offset + size) == CRC_ERROR)
+		return 1;
+
+	// table must be sorted for the binary search
+	XRAM_SELECT_BLOCK(XRAM_ASSOC_PAGE);
+	pa = (_ASSOCIATION_ENTRY_t*) XRAM_BASE_ADDRESS;
+	for (i = 1; i < size / sizeof (_ASSOCIATION_ENTRY_t); i++)
+		if (pa[i].address_index < pa[i-1].address_index)
+			return 1;
+
+	// convert entries of older project files
+	if (lcd_file_version == LCD_VERSION_COMPAT)
+		compat_convert_associations (size / sizeof (_ASSOCIATION_ENTRY_t));
+
+	association_tab_length = size / sizeof (_ASSOCIATION_ENTRY_t);
+	return 0;
+}
+
+// forget association table of previous project
+void clear_association_table (void) {
+
+	association_tab_length = 0;
+	association_overflow = 0;
+}
+
+// builds the send address table of all objects.
+// The entry flagged as send address wins, otherwise the first association is used.
+void init_association_table (void) {
+
+_ASSOCIATION_ENTRY_t *pa;
+uint16_t *ps;
+uint16_t object;
+uint16_t i;
+uint16_t fanout, max_fanout;
+
+	if (!association_tab_length) {
+		// 1:1 association
+		object_count = min (get_address_tab_length (), ASSOCIATION_MAX_OBJECTS);
+		return;
+	}
+
+	XRAM_SELECT_BLOCK(XRAM_ASSOC_PAGE);
+	pa = (_ASSOCIATION_ENTRY_t*) XRAM_BASE_ADDRESS;
+	ps = (uint16_t*) (XRAM_BASE_ADDRESS + ASSOCIATION_SEND_TABLE_OFFSET);
+
+	for (i = 0; i < ASSOCIATION_MAX_OBJECTS; i++)
+		ps[i] = ASSOCIATION_NO_SEND_ADDRESS;
+
+	object_count = 0;
+	fanout = max_fanout = 0;
+	for (i = 0; i < association_tab_length; i++, pa++) {
+		// number of objects of the address, the table is sorted
+		fanout = (i && (pa->address_index == pa[-1].address_index)) ? fanout +1 : 1;
+		if (fanout > max_fanout)
+			max_fanout = fanout;
+		// ignore associations to addresses not in the address table
+		if (pa->address_index >= get_address_tab_length ())
+			continue;
+		object = pa->object & ASSOCIATION_OBJECT_MASK;
+		if (object >= ASSOCIATION_MAX_OBJECTS)
+			continue;
+		if ((pa->object & ASSOCIATION_FLAG_SEND) || (ps[object] == ASSOCIATION_NO_SEND_ADDRESS))
+			ps[object] = pa->address_index;
+		if (object >= object_count)
+			object_count = object +1;
+	}
+#ifdef LCD_DEBUG
+	if (max_fanout > EIB_MAX_MSG_OBJECTS)
+		printf_P (PSTR("Assoc: %u objects of one address, only %u are updated\n"), max_fanout, EIB_MAX_MSG_OBJECTS);
+#endif
+}
+
+// gets all objects associated with a group address.
+// objects: buffer for the object numbers
+// max: size of the buffer
+// Returns the number of objects. Associations beyond the size of the buffer
+// are counted by get_association_overflow().
+uint8_t get_associated_objects (uint16_t address, uint16_t *objects, uint8_t max) {
+
+_ASSOCIATION_ENTRY_t *pa;
+int			index;
+uint16_t	lo, hi, mid;
+uint16_t	object;
+uint8_t		count;
+uint8_t		save_xram_page;
+
+	index = get_group_adress_index (address);
+	if (index < 0)
+		return 0;
+
+	// 1:1 association
+	if (!association_tab_length) {
+		if ((index >= object_count) || (!max))
+			return 0;
+		*objects = index;
+		return 1;
+	}
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	XRAM_SELECT_BLOCK(XRAM_ASSOC_PAGE);
+	pa = (_ASSOCIATION_ENTRY_t*) XRAM_BASE_ADDRESS;
+
+	// search first association of the address
+	lo = 0;
+	hi = association_tab_length;
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (pa[mid].address_index < index)
+			lo = mid +1;
+		else hi = mid;
+	}
+
+	// collect all associated objects, objects beyond the project are ignored
+	// like in init_association_table()
+	count = 0;
+	for (; (lo < association_tab_length) && (pa[lo].address_index == index); lo++) {
+		object = pa[lo].object & ASSOCIATION_OBJECT_MASK;
+		if (object >= object_count)
+			continue;
+		if (count < max)
+			objects[count++] = object;
+		else if (association_overflow < 0xffff)
+			association_overflow++;
+	}
+
+	XRAM_SELECT_BLOCK(save_xram_page);
+	return count;
+}
+
+// get send address of object
+// returns 0, if the object has no send address
+uint16_t get_object_send_address (uint16_t object) {
+
+uint16_t	index;
+uint8_t		save_xram_page;
+
+	if (object >= get_object_count ())
+		return 0;
+
+	// 1:1 association
+	if (!association_tab_length)
+		return get_group_address (object);
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	XRAM_SELECT_BLOCK(XRAM_ASSOC_PAGE);
+	index = ((uint16_t*) (XRAM_BASE_ADDRESS + ASSOCIATION_SEND_TABLE_OFFSET))[object];
+	XRAM_SELECT_BLOCK(save_xram_page);
+
+	if (index == ASSOCIATION_NO_SEND_ADDRESS)
+		return 0;
+	return get_group_address (index);
+}
+
+// get number of objects
+uint16_t get_object_count (void) {
+
+	return object_count;
+}
+
+// get number of associations dropped by get_associated_objects()
+uint16_t get_association_overflow (void) {
+
+	return association_overflow;
+}
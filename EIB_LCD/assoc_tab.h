@@ -0,0 +1,58 @@
+/** \file assoc_tab.h
+ *  \brief Constants and definitions for the association of EIB objects and group addresses
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _ASSOC_TAB_H_
+#define _ASSOC_TAB_H_
+
+#include "System.h"
+#include "MemoryMap.h"
+
+/**
+* @brief association of a group address with an object
+*
+* The table is sorted by address_index. Since the address table is sorted
+* by group address, the association table is sorted by group address, too.
+*/
+typedef struct __attribute__ ((packed)) {
+uint16_t	address_index;	// index into the group address table
+uint16_t	object;			// d11..d0: EIB object number, d15: address is the send address of the object
+} _ASSOCIATION_ENTRY_t;
+
+#define ASSOCIATION_FLAG_SEND		0x8000
+#define ASSOCIATION_OBJECT_MASK		0x0fff
+
+// max. number of objects
+#define ASSOCIATION_MAX_OBJECTS		EIB_MAX_OBJECTS
+// the send address table is located at the end of the association bank
+#define ASSOCIATION_SEND_TABLE_OFFSET	(XRAM_BANK_SIZE - 2*ASSOCIATION_MAX_OBJECTS)
+// object has no send address
+#define ASSOCIATION_NO_SEND_ADDRESS	0xffff
+
+// moves the association table from Flash into RAM
+// returns 0 if ok
+// returns 1 if the table is not sorted
+// returns 2 if the table is too large
+uint8_t move_association_table (uint32_t, uint32_t);
+// forget association table of previous project
+void clear_association_table (void);
+// builds the send address table after the address and association table have been loaded
+void init_association_table (void);
+
+// gets all objects associated with a group address. Returns the number of objects.
+uint8_t get_associated_objects (uint16_t, uint16_t*, uint8_t);
+// get send address of object
+uint16_t get_object_send_address (uint16_t);
+// get number of objects
+uint16_t get_object_count (void);
+// get number of associations dropped, since an address has more than EIB_MAX_MSG_OBJECTS objects
+uint16_t get_association_overflow (void);
+
+#endif // _ASSOC_TAB_H_
@@ -0,0 +1,258 @@
+/** \file compat.c
+ *  \brief Functions for loading older project files
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- convert page, listen and cyclic element descriptions of structure
+ *	  version 0x1E into the current structure version
+ *	- convert association table entries of structure version 0x1E
+ *
+ *	Structure version 0x1F uses 16 bit object numbers in all elements and
+ *	16 bit element counts in the descriptors. The descriptions of 0x1E are
+ *	copied into a scratch bank and rebuilt with the fields widened in the
+ *	banks allocated for the section.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "compat.h"
+
+// length of the page name in the page descriptor
+#define COMPAT_PAGE_NAME_LENGTH		16
+
+// object fields of page elements in structure version 0x1E.
+// The force and init flags of version 0x1F were unused bits in 0x1E. The init flag
+// of the value element was d1, which is part of the value type, so it is dropped.
+const _COMPAT_ELEMENT_t compat_page_elements[] = {
+	{ PAGE_ELEMENT_TYPE_BUTTON,				{ 10, 11 }, 0, 0 },		// eib_object0, eib_object1
+	{ PAGE_ELEMENT_TYPE_LED,				{ 12, 13 }, 14, LED_PARAMETER_FORCE },	// eib_object_listen, eib_object_send, parameter
+	{ PAGE_ELEMENT_TYPE_VALUE,				{ 12, 0 }, 13, VALUE_PARAMETER_INIT | VALUE_PARAMETER_FORCE },	// eib_object_listen, parameter
+	{ PAGE_ELEMENT_TYPE_SBUTTON,			{ 14, 15 }, 16, EIB_SBUTTON_FUNCTION_INIT | EIB_SBUTTON_FUNCTION_FORCE }	// eib_object_send, eib_object_listen, eib_function
+};
+
+// object fields of listen elements in structure version 0x1E
+const _COMPAT_ELEMENT_t compat_listen_elements[] = {
+	{ LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE,	{ 3, 0 }, 0, 0 },		// eib_object_listen
+	{ LISTEN_ELEMENT_TYPE_BACKLIGHT_ACTIVE,	{ 3, 0 }, 0, 0 },		// eib_object_listen
+	{ LISTEN_ELEMENT_TYPE_LED,				{ 3, 0 }, 0, 0 },		// eib_object_listen
+	{ LISTEN_ELEMENT_TYPE_WARNING,			{ 2, 0 }, 0, 0 },		// warning_object_id
+	{ LISTEN_ELEMENT_TIMEOUT,				{ 2, 0 }, 0, 0 },		// eib_object_listen
+	{ LISTEN_ELEMENT_TRACE,					{ 2, 0 }, 0, 0 }		// eib_object_listen
+};
+
+// object fields of cyclic elements in structure version 0x1E
+const _COMPAT_ELEMENT_t compat_cyclic_elements[] = {
+	{ CYCLIC_ELEMENT_TYPE_BUTTON,			{ 3, 0 }, 0, 0 },		// eib_object_send
+	{ CYCLIC_ELEMENT_TYPE_DS18S20,			{ 3, 0 }, 0, 0 },		// eib_object
+	{ CYCLIC_ELEMENT_TYPE_IR,				{ 6, 7 }, 0, 0 },		// eib_object0, eib_object1
+	{ CYCLIC_ELEMENT_TYPE_DS18B20,			{ 3, 0 }, 0, 0 },		// eib_object
+	{ CYCLIC_ELEMENT_TYPE_DHT11,			{ 3, 4 }, 0, 0 }		// eib_object, eib_object2
+};
+
+// end of the banks of the converted descriptions
+xram_far_t compat_end;
+// converted descriptions do not fit into the banks
+uint8_t compat_overflow;
+
+// copy descriptions of version 0x1E into the scratch bank and validate the checksum
+// returns 0 if ok, 1 on checksum error, 2 if the descriptions are too big
+static uint8_t compat_load (uint32_t flash_offset, uint32_t size, uint8_t bank, uint8_t banks) {
+
+uint8_t		checksum;
+uint16_t	i;
+
+	// structure version 0x1E is limited to one bank per section
+	if (size > XRAM_BANK_SIZE)
+		return 2;
+
+	copy_Flash_to_XRAM ((flash_offset >> 16) & 0xff, flash_offset & 0xffff, XRAM_COMPAT_PAGE, 0, size);
+	checksum = 0;
+	for (i = 0; i < size; i++)
+		checksum ^= INB (XRAM_BASE_ADDRESS + i);
+
+	compat_end = XRAM_FAR(bank + banks, 0);
+	compat_overflow = 0;
+	return checksum ? 1 : 0;
+}
+
+// get byte of the old descriptions
+static uint8_t compat_get (uint16_t offset) {
+
+	XRAM_SELECT_BLOCK(XRAM_COMPAT_PAGE);
+	return INB (XRAM_BASE_ADDRESS + offset);
+}
+
+// put byte of the converted descriptions
+static void compat_put (xram_far_t dst, uint8_t b) {
+
+	if (dst >= compat_end) {
+		compat_overflow = 1;
+		return;
+	}
+	*xram_far_select (dst) = b;
+}
+
+// move a block to the next bank, if it does not fit into the rest of the bank
+// returns the position of the block
+static xram_far_t compat_align (xram_far_t dst, uint16_t size) {
+
+	if (XRAM_FAR_OFFSET(dst) + size <= XRAM_BANK_SIZE)
+		return dst;
+	// mark the gap
+	compat_put (dst, 0);
+	return XRAM_FAR_NEXT_BANK(dst);
+}
+
+// convert elements, the object fields get a high byte, flags of 0x1F are cleared
+// src: offset of the first element in the old descriptions
+// dst: position of the first element in the converted descriptions
+// returns the position behind the last converted element
+static xram_far_t compat_convert_elements (uint16_t src, xram_far_t dst, uint16_t count, const _COMPAT_ELEMENT_t *table, uint8_t table_size) {
+
+const _COMPAT_ELEMENT_t	*element;
+const uint8_t	*field;
+xram_far_t	start;
+uint16_t	i;
+uint8_t		size;
+uint8_t		grow;
+uint8_t		type;
+uint8_t		j, k;
+
+	for (i = 0; i < count; i++) {
+		size = compat_get (src);
+		type = compat_get (src +1);
+
+		element = NULL;
+		field = NULL;
+		for (k = 0; k < table_size; k++)
+			if (table[k].element_type == type) {
+				element = &table[k];
+				field = element->field;
+			}
+		grow = 0;
+		for (k = 0; field && (k < COMPAT_MAX_FIELDS); k++)
+			if (field[k] && (field[k] < size))
+				grow++;
+
+		// converted elements must not cross a bank border either
+		dst = compat_align (dst, size + grow);
+		start = dst;
+		for (j = 0; j < size; j++) {
+			if (element && element->flags && (element->flags == j))
+				compat_put (dst++, compat_get (src + j) & ~element->flags_clear);
+			else compat_put (dst++, compat_get (src + j));
+			for (k = 0; field && (k < COMPAT_MAX_FIELDS); k++)
+				if (field[k] && (field[k] == j))
+					compat_put (dst++, 0x00);
+		}
+		// new element size
+		compat_put (start, dst - start);
+		src += size;
+	}
+	return dst;
+}
+
+// converts page descriptions of version 0x1E
+// flash_offset, size: descriptions in Flash
+// bank, banks: banks allocated for the converted descriptions
+// returns 0 if ok, 1 on checksum error, 2 if the converted descriptions do not fit into the banks
+uint8_t compat_convert_pages (uint32_t flash_offset, uint32_t size, uint8_t bank, uint8_t banks) {
+
+xram_far_t	section;
+xram_far_t	dst;
+uint16_t	table_size;
+uint16_t	src;
+uint16_t	offset;
+uint8_t		pages;
+uint8_t		count;
+uint8_t		p, j;
+uint8_t		result;
+
+	result = compat_load (flash_offset, size, bank, banks);
+	if (result)
+		return result;
+	section = XRAM_FAR(bank, 0);
+
+	// header and page offset table keep their size
+	pages = compat_get (0);
+	compat_put (section, pages);
+	compat_put (section +1, compat_get (1));
+	table_size = 2 + 2*pages;
+
+	dst = section + table_size;
+	for (p = 0; p < pages; p++) {
+		src = table_size + (compat_get (2 + 2*p) | (compat_get (3 + 2*p) << 8));
+		dst = compat_align (dst, sizeof (_PAGE_DESCRIPTOR_t));
+		offset = dst - section - table_size;
+		compat_put (section + 2 + 2*p, offset & 0xff);
+		compat_put (section + 3 + 2*p, offset >> 8);
+
+		// element count is 16 bit now
+		count = compat_get (src);
+		compat_put (dst++, count);
+		compat_put (dst++, 0x00);
+		for (j = 0; j < COMPAT_PAGE_NAME_LENGTH; j++)
+			compat_put (dst++, compat_get (src + 1 + j));
+
+		dst = compat_convert_elements (src + 1 + COMPAT_PAGE_NAME_LENGTH, dst, count,
+									   compat_page_elements, sizeof (compat_page_elements) / sizeof (_COMPAT_ELEMENT_t));
+	}
+
+	return compat_overflow ? 2 : 0;
+}
+
+// converts listen or cyclic descriptions, the element count is 16 bit now
+static uint8_t compat_convert_list (uint32_t flash_offset, uint32_t size, uint8_t bank, uint8_t banks,
+									const _COMPAT_ELEMENT_t *table, uint8_t table_size) {
+
+xram_far_t	section;
+uint8_t		count;
+uint8_t		result;
+
+	result = compat_load (flash_offset, size, bank, banks);
+	if (result)
+		return result;
+	section = XRAM_FAR(bank, 0);
+
+	count = compat_get (0);
+	compat_put (section, count);
+	compat_put (section +1, 0x00);
+	compat_put (section +2, compat_get (1));
+	compat_convert_elements (2, section +3, count, table, table_size);
+
+	return compat_overflow ? 2 : 0;
+}
+
+// converts listen element descriptions of version 0x1E
+uint8_t compat_convert_listen (uint32_t flash_offset, uint32_t size, uint8_t bank, uint8_t banks) {
+
+	return compat_convert_list (flash_offset, size, bank, banks,
+								compat_listen_elements, sizeof (compat_listen_elements) / sizeof (_COMPAT_ELEMENT_t));
+}
+
+// converts cyclic element descriptions of version 0x1E
+uint8_t compat_convert_cyclic (uint32_t flash_offset, uint32_t size, uint8_t bank, uint8_t banks) {
+
+	return compat_convert_list (flash_offset, size, bank, banks,
+								compat_cyclic_elements, sizeof (compat_cyclic_elements) / sizeof (_COMPAT_ELEMENT_t));
+}
+
+// converts association table entries of version 0x1E in XRAM_ASSOC_PAGE
+// 0x1E stores the object number in the low byte and the flags in the high byte
+void compat_convert_associations (uint16_t count) {
+
+_ASSOCIATION_ENTRY_t *pa;
+uint16_t i;
+
+	XRAM_SELECT_BLOCK(XRAM_ASSOC_PAGE);
+	pa = (_ASSOCIATION_ENTRY_t*) XRAM_BASE_ADDRESS;
+	for (i = 0; i < count; i++, pa++) {
+		if (pa->object & 0x0100)
+			pa->object = (pa->object & 0xff) | ASSOCIATION_FLAG_SEND;
+		else pa->object &= 0xff;
+	}
+}
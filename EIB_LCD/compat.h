@@ -0,0 +1,48 @@
+/** \file compat.h
+ *  \brief Constants and definitions for loading older project files
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _COMPAT_H_
+#define _COMPAT_H_
+
+#include "System.h"
+
+// the object arena is built after all TOC entries have been loaded,
+// so its first bank is free while the descriptions are converted
+#define XRAM_COMPAT_PAGE		XRAM_OBJECT_ARENA_PAGE
+
+// max. number of 8 bit object fields in an element of structure version 0x1E
+#define COMPAT_MAX_FIELDS		2
+
+/**
+* @brief 8 bit object fields of an element type in structure version 0x1E
+*
+* fields are byte offsets in the element, 0 marks unused entries.
+* The bits of flags_clear in the byte at offset flags have no meaning in 0x1E,
+* they are cleared.
+*/
+typedef struct {
+uint8_t		element_type;
+uint8_t		field[COMPAT_MAX_FIELDS];
+uint8_t		flags;
+uint8_t		flags_clear;
+} _COMPAT_ELEMENT_t;
+
+// loads and converts page descriptions of version 0x1E into the banks of the section
+// returns 0 if ok, 1 on checksum error, 2 if the converted descriptions do not fit into the banks
+uint8_t compat_convert_pages (uint32_t, uint32_t, uint8_t, uint8_t);
+// loads and converts listen element descriptions of version 0x1E
+uint8_t compat_convert_listen (uint32_t, uint32_t, uint8_t, uint8_t);
+// loads and converts cyclic element descriptions of version 0x1E
+uint8_t compat_convert_cyclic (uint32_t, uint32_t, uint8_t, uint8_t);
+// converts association table entries of version 0x1E in XRAM_ASSOC_PAGE
+void compat_convert_associations (uint16_t);
+
+#endif // _COMPAT_H_
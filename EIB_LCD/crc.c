@@ -0,0 +1,272 @@
+/** \file crc.c
+ *  \brief Functions for the CRC-32 check of the project sections
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- CRC-32 with a table of 16 entries
+ *	- find the CRC of a section in the CRC table of the TOC
+ *	- verify sections loaded into XRAM, the CRC is calculated while copying
+ *	- verify pictures and sounds by a background thread
+ *
+ *	The CRC table is optional. Projects without it are checked by the XOR
+ *	checksum of the loaded sections as before.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include <avr/pgmspace.h>
+#include "System.h"
+#include "crc.h"
+
+// CRC-32 of a nibble
+static const uint32_t crc32_nibble[16] PROGMEM = {
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+	0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+// Flash position and size of the CRC table, size 0 if there is none
+uint32_t crc_table;
+uint32_t crc_table_size;
+
+/**
+* @brief section checked in the background
+*/
+typedef struct {
+uint32_t	flash_position;
+uint32_t	size;
+uint32_t	crc;
+uint8_t		type;
+} _CRC_CHECK_SECTION_t;
+
+_CRC_CHECK_SECTION_t crc_check_sections[CRC_CHECK_MAX_SECTIONS];
+uint8_t crc_check_count;
+uint8_t crc_check_state;
+// a new check has been started, the running check is given up
+uint8_t crc_check_generation;
+uint16_t crc_errors;
+HANDLE crc_check_event;
+HANDLE crc_check_thread_handle;
+
+// add byte to CRC-32
+uint32_t crc32_byte (uint32_t crc, uint8_t b) {
+
+	crc ^= b;
+	crc = (crc >> 4) ^ pgm_read_dword (&crc32_nibble[crc & 0x0f]);
+	crc = (crc >> 4) ^ pgm_read_dword (&crc32_nibble[crc & 0x0f]);
+	return crc;
+}
+
+// add Flash bytes to CRC-32
+// flash_position: linear Flash address, d23-d16: sector, d15-d0: byte offset
+uint32_t crc32_flash (uint32_t crc, uint32_t flash_position, uint32_t size) {
+
+uint16_t	w;
+
+	while (size) {
+		w = read_flash_abs (flash_position & ~1UL);
+		if (!(flash_position & 0x01)) {
+			crc = crc32_byte (crc, w & 0xff);
+			flash_position++;
+			if (!--size)
+				break;
+		}
+		crc = crc32_byte (crc, (w >> 8) & 0xff);
+		flash_position++;
+		size--;
+	}
+	return crc;
+}
+
+// find the CRC table in the TOC
+void crc_init (void) {
+
+_LCD_FILE_TOC_ENTRY_t	*toc;
+uint8_t		toc_items;
+uint8_t		i;
+
+	crc_table_size = 0;
+
+	XRAM_SELECT_BLOCK(XRAM_TOC_PAGE);
+	toc_items = *(uint8_t*) XRAM_BASE_ADDRESS;
+	toc = (_LCD_FILE_TOC_ENTRY_t*) (TOC_HEADER_SIZE + XRAM_BASE_ADDRESS);
+	for (i = 0; i < toc_items; i++, toc++)
+		if ((toc->type == CRC_TOC_TYPE_TABLE) && !(toc->flash_position & 0x01)) {
+			crc_table = toc->flash_position;
+			crc_table_size = toc->size;
+		}
+}
+
+// get the CRC of the section at flash_position
+// returns 0, if there is none
+static uint8_t crc_get_section (uint32_t flash_position, uint32_t *crc) {
+
+_LCD_FILE_TOC_ENTRY_t	*toc;
+uint32_t	pos;
+uint8_t		toc_items;
+uint8_t		save_xram_page;
+uint8_t		i;
+
+	if (!crc_table_size)
+		return 0;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	XRAM_SELECT_BLOCK(XRAM_TOC_PAGE);
+	toc_items = *(uint8_t*) XRAM_BASE_ADDRESS;
+	toc = (_LCD_FILE_TOC_ENTRY_t*) (TOC_HEADER_SIZE + XRAM_BASE_ADDRESS);
+	for (i = 0; i < toc_items; i++, toc++)
+		if ((toc->type != CRC_TOC_TYPE_TABLE) && (toc->flash_position == flash_position))
+			break;
+	XRAM_SELECT_BLOCK(save_xram_page);
+
+	if ((i == toc_items) || (4 * (uint32_t) i + 4 > crc_table_size))
+		return 0;
+
+	pos = crc_table + 4 * (uint32_t) i;
+	*crc = read_flash_abs (pos +2);
+	*crc = (*crc << 16) | read_flash_abs (pos);
+	return 1;
+}
+
+// verify section at flash_position of size Bytes
+// crc: CRC-32 of the bytes from flash_position up to crc_pos, the rest is read from Flash
+// returns CRC_OK, CRC_ERROR, or CRC_MISSING, if the project has no CRC for the section
+uint8_t crc_verify (uint32_t flash_position, uint32_t size, uint32_t crc, uint32_t crc_pos) {
+
+uint32_t	expected;
+
+	if (!crc_get_section (flash_position, &expected))
+		return CRC_MISSING;
+
+	if ((crc_pos < flash_position) || (crc_pos > flash_position + size)) {
+		crc = CRC32_INIT;
+		crc_pos = flash_position;
+	}
+	crc = crc32_flash (crc, crc_pos, flash_position + size - crc_pos);
+
+	if (~crc != expected) {
+#ifdef LCD_DEBUG
+		printf_P (PSTR("\nCRC error at %lx"), flash_position);
+#endif
+		return CRC_ERROR;
+	}
+	return CRC_OK;
+}
+
+// check a section in chunks, returns 0 if a new check has been started meanwhile
+static uint8_t crc_check_section (_CRC_CHECK_SECTION_t *s, uint8_t generation) {
+
+uint32_t	crc;
+uint32_t	pos;
+uint32_t	n;
+uint8_t		dma_setting_save;
+uint8_t		sector_setting_save;
+
+	crc = CRC32_INIT;
+	for (pos = 0; pos < s->size; pos += n) {
+		// wait while another thread erases or programs the Flash
+		while (flash_busy)
+			NutSleep (CRC_CHECK_BUSY_SLEEP);
+		// the Flash is rewritten
+		if (flash_content_bad || (generation != crc_check_generation))
+			return 0;
+
+		n = min (s->size - pos, CRC_CHECK_CHUNK);
+		// another thread may have been suspended while it reads the Flash
+		dma_setting_save = INB(CPLD_BASE_ADDR + MODE_CTRL_ADDR);
+		sector_setting_save = FLASH_RETURN_SECTOR;
+		crc = crc32_flash (crc, s->flash_position + pos, n);
+		FLASH_SELECT_SECTOR (sector_setting_save);
+		OUTB (CPLD_BASE_ADDR + MODE_CTRL_ADDR, dma_setting_save);
+
+		NutThreadYield ();
+	}
+	if (generation != crc_check_generation)
+		return 0;
+
+	if (~crc != s->crc) {
+		crc_errors |= 1 << s->type;
+#ifdef LCD_DEBUG
+		printf_P (PSTR("\nCRC error in section type %d"), s->type);
+#endif
+	}
+	return 1;
+}
+
+// check pictures and sounds, while all other threads wait
+THREAD(crc_check_thread, arg)
+{
+uint8_t	generation;
+uint8_t	i;
+
+	NutThreadSetPriority (NUT_THREAD_PRIORITY_CRC_CHECK);
+
+	for (;;) {
+		NutEventWait (&crc_check_event, NUT_WAIT_INFINITE);
+
+		generation = crc_check_generation;
+		for (i = 0; i < crc_check_count; i++)
+			if (!crc_check_section (&crc_check_sections[i], generation))
+				break;
+		if (i == crc_check_count)
+			crc_check_state = CRC_CHECK_DONE;
+	}
+}
+
+// check pictures and sounds in the background
+void crc_check_start (void) {
+
+_LCD_FILE_TOC_ENTRY_t	*toc;
+_CRC_CHECK_SECTION_t	*s;
+uint8_t		toc_items;
+uint8_t		save_xram_page;
+uint8_t		i;
+
+	crc_check_generation++;
+	crc_check_count = 0;
+	crc_check_state = CRC_CHECK_NONE;
+	crc_errors = 0;
+	if (flash_content_bad || !crc_table_size)
+		return;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	for (i = 0; crc_check_count < CRC_CHECK_MAX_SECTIONS; i++) {
+		XRAM_SELECT_BLOCK(XRAM_TOC_PAGE);
+		toc_items = *(uint8_t*) XRAM_BASE_ADDRESS;
+		if (i >= toc_items)
+			break;
+		toc = (_LCD_FILE_TOC_ENTRY_t*) (TOC_HEADER_SIZE + XRAM_BASE_ADDRESS) + i;
+		if ((toc->type != CRC_TOC_TYPE_PICTURES) && (toc->type != CRC_TOC_TYPE_SOUNDS))
+			continue;
+
+		s = &crc_check_sections[crc_check_count];
+		s->flash_position = toc->flash_position;
+		s->size = toc->size;
+		s->type = toc->type;
+		if (crc_get_section (s->flash_position, &s->crc))
+			crc_check_count++;
+	}
+	XRAM_SELECT_BLOCK(save_xram_page);
+
+	if (!crc_check_count)
+		return;
+	crc_check_state = CRC_CHECK_RUNNING;
+	if (!crc_check_thread_handle)
+		crc_check_thread_handle = sysmon_thread_create ("CRC", crc_check_thread, 0, NUT_THREAD_CRC_CHECK_STACK);
+	NutEventPost (&crc_check_event);
+}
+
+// get state of the background check
+uint8_t crc_get_check_state (void) {
+
+	return crc_check_state;
+}
+
+// get failed sections, one bit per TOC type
+uint16_t crc_get_errors (void) {
+
+	return crc_errors;
+}
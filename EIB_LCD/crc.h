@@ -0,0 +1,62 @@
+/** \file crc.h
+ *  \brief Constants and definitions for the CRC-32 check of the project sections
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _CRC_H_
+#define _CRC_H_
+
+#include <stdint.h>
+
+// CRC-32 of IEEE 802.3, reflected polynomial
+#define CRC32_INIT				0xffffffffUL
+
+// TOC types of the sections checked in the background
+#define CRC_TOC_TYPE_PICTURES	4
+#define CRC_TOC_TYPE_SOUNDS		5
+// TOC type of the CRC table: one CRC-32 per TOC entry in TOC order, little endian.
+// The entry of the CRC table itself is not checked.
+#define CRC_TOC_TYPE_TABLE		10
+
+// max. number of sections checked in the background
+#define CRC_CHECK_MAX_SECTIONS	4
+// bytes checked before the thread gives up the CPU
+#define CRC_CHECK_CHUNK			256
+// poll interval while the Flash is busy [ms]
+#define CRC_CHECK_BUSY_SLEEP	50
+
+// results of crc_verify()
+#define CRC_OK					0
+#define CRC_ERROR				1
+#define CRC_MISSING				2
+
+// state of the background check
+#define CRC_CHECK_NONE			0	// no CRC table in the project
+#define CRC_CHECK_RUNNING		1
+#define CRC_CHECK_DONE			2
+
+// add byte to CRC-32, start with CRC32_INIT
+uint32_t crc32_byte (uint32_t, uint8_t);
+// add Flash bytes to CRC-32: crc, Flash position, size
+uint32_t crc32_flash (uint32_t, uint32_t, uint32_t);
+
+// find the CRC table in the TOC, call after the TOC has been copied into XRAM
+void crc_init (void);
+// verify section at Flash position of size Bytes
+// crc: CRC-32 of the section bytes up to Flash position crc_pos
+uint8_t crc_verify (uint32_t, uint32_t, uint32_t, uint32_t);
+
+// check pictures and sounds in the background, call after the first page is shown
+void crc_check_start (void);
+// CRC_CHECK_xxx
+uint8_t crc_get_check_state (void);
+// failed sections, one bit per TOC type
+uint16_t crc_get_errors (void);
+
+#endif // _CRC_H_
@@ -23,37 +23,59 @@
 #include "o_button.h"
 
 uint8_t cyclic_descriptions_validated;
+// cyclic element descriptions in XRAM
+xram_far_t cyclic_descriptions;
+// bank of the cyclic element in process
+uint8_t cyclic_bank;
 
 // moves cyclic elements descriptions from Flash into RAM. Purpose is fast and easy access to Bytes.
+// The descriptions may span several banks, elements never cross a bank border.
 // flash offset: start address in Flash
 // size: size of page descriptions in Byte
 uint8_t move_cyclic_descriptions (uint32_t flash_offset, uint32_t size) {
 
-uint8_t checksum;
-uint16_t i;
+_XRAM_LOADER_t	ld;
+uint8_t		banks;
+uint8_t		bank;
+uint8_t		result;
 
+	cyclic_descriptions_validated = 0;
 
-	// we can only handle sizes up to one XRAM page
-	if (size > XRAM_BANK_SIZE)
+	// elements of older project files grow while they are converted
+	banks = xram_section_banks ((lcd_file_version == LCD_VERSION_COMPAT) ? 2*size : size);
+	bank = xram_alloc (banks);
+	if (!bank)
 		return 2;
+	cyclic_descriptions = XRAM_FAR(bank, 0);
 
-	// move page descriptions from Flash into XRAM
-	copy_Flash_to_XRAM ((flash_offset >> 16) & 0xff, flash_offset & 0xffff, XRAM_CYCLIC_ELEMENTS_ADDR, size);
-
-	checksum = 0;
-	// validate checksum in XRAM
-	for (i = 0; i < size; i++) {
-		checksum ^= INB (XRAM_BASE_ADDRESS + i);
+	if (lcd_file_version == LCD_VERSION_COMPAT) {
+		result = compat_convert_cyclic (flash_offset, size, bank, banks);
+		if (result)
+			return result;
+	}
+	else {
+		xram_loader_init (&ld, bank, banks, flash_offset);
+		if (xram_load_block (&ld, sizeof (_CYCLIC_DESCRIPTOR_t)))
+			return 2;
+		result = xram_load_elements (&ld, ((_CYCLIC_DESCRIPTOR_t*) xram_far_select (cyclic_descriptions))->element_count);
+		if (result)
+			return result;
+		if (xram_loader_verify (&ld, size))
+			return 1;
 	}
-
-	if (checksum)
-		return 1;
 
 	cyclic_descriptions_validated = 1;
 
 	return 0;
 }
 
+// start iterating the cyclic elements
+static void cyclic_iterator_init (_XRAM_ITERATOR_t *it) {
+
+	xram_iterator_init (it, &cyclic_bank, cyclic_descriptions + sizeof (_CYCLIC_DESCRIPTOR_t),
+						((_CYCLIC_DESCRIPTOR_t*) xram_far_select (cyclic_descriptions))->element_count);
+}
+
 
 uint8_t rc5_event; // RC5_PRESSED_NEW, RC5_RELEASED_SHORT (<3 msg), RC5_PRESSED_LONG (> 2msg), RC5_RELEASED_LONG
 uint8_t rc5_last_address;
@@ -69,9 +91,8 @@ uint8_t rc5_gap_timer;
 void lcd_cyclic_process_event (void) {
 
 char* p;
+_XRAM_ITERATOR_t	it;
 _CYCLIC_ELEMENT_t	*cyclic_element;
-uint8_t	element_count;
-int i;
 
 	if ((flash_content_bad) || (!cyclic_descriptions_validated))
 		return;
@@ -109,19 +130,11 @@ int i;
 	if (rc5_event == RC5_PRESSED_NEW)
 		hwmon_show_ir_event();
 	// poll all cyclic components and check, if they need service
-	// set page descriptions bank
-	XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
-	p = (char*)XRAM_BASE_ADDRESS;
-	element_count = ((_CYCLIC_DESCRIPTOR_t*) p)->element_count;
-	p += sizeof (_CYCLIC_DESCRIPTOR_t);
-
 	// iterate all cyclic elements
-	for (i = 0; i < element_count; i++) {
+	cyclic_iterator_init (&it);
+	while ((p = xram_iterator_next (&it))) {
 		cyclic_element = (_CYCLIC_ELEMENT_t*) p;
 
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
-
 		switch (cyclic_element->element_type) {
 			case CYCLIC_ELEMENT_TYPE_BUTTON:
 				check_hardware_button (p);
@@ -144,9 +157,6 @@ int i;
 			default: printf_P (PSTR("unknown cyclic element %d\n"), cyclic_element->element_type);
 #endif
 		}
-
-		XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
-		p += cyclic_element->element_size;
 	}
 }
 
@@ -158,9 +168,8 @@ int i;
 void lcd_init_cyclic_objects (void) {
 
 char* p;
+_XRAM_ITERATOR_t	it;
 _CYCLIC_ELEMENT_t	*cyclic_element;
-uint8_t	element_count;
-int i;
 
 	if ((flash_content_bad) || (!cyclic_descriptions_validated))
 		return;
@@ -170,19 +179,11 @@ int i;
 	rc5_counter = 0;
 
 	// poll all cyclic components and check, if they need hardware setup
-	// set page descriptions bank
-	XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
-	p = (char*)XRAM_BASE_ADDRESS;
-	element_count = ((_CYCLIC_DESCRIPTOR_t*) p)->element_count;
-	p += sizeof (_CYCLIC_DESCRIPTOR_t);
-
 	// iterate all listening elements
-	for (i = 0; i < element_count; i++) {
+	cyclic_iterator_init (&it);
+	while ((p = xram_iterator_next (&it))) {
 		cyclic_element = (_CYCLIC_ELEMENT_t*) p;
 
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
-
 		switch (cyclic_element->element_type) {
 
 			case CYCLIC_ELEMENT_TYPE_BUTTON:
@@ -204,9 +205,6 @@ int i;
 			default: printf_P (PSTR("unknown cyclic element %d\n"), cyclic_element->element_type);
 #endif
 		}
-
-		XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
-		p += cyclic_element->element_size;
 	}
 }
 
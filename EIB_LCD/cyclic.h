@@ -17,7 +17,7 @@
 #include "MemoryMap.h"
 
 typedef struct __attribute__ ((packed)) {
-uint8_t		element_count;
+uint16_t	element_count;
 uint8_t		checksum;
 } _CYCLIC_DESCRIPTOR_t;
 
@@ -34,8 +34,12 @@ uint8_t		element_type;
 // moves the page descriptions from Flash into RAM
 // returns 0 if ok
 // returns 1 on checksum error
+// returns 2 if there are not enough XRAM banks
 uint8_t move_cyclic_descriptions (uint32_t, uint32_t);
 
+// bank of the cyclic element in process
+extern uint8_t cyclic_bank;
+
 // check objects on event
 void lcd_cyclic_process_event (void);
 
@@ -43,6 +47,6 @@ void lcd_cyclic_process_event (void);
 void lcd_init_cyclic_objects (void);
 
 // get timeout value of object
-uint16_t lcd_get_timeout_counter (uint8_t);
+uint16_t lcd_get_timeout_counter (uint16_t);
 
 #endif // _CYCLIC_H_
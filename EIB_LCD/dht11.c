@@ -103,7 +103,6 @@ _O_DHTxx_t*	p;
 uint8_t s;	// sensor type
 uint8_t c;	// channel
 uint16_t b;
-int16_t w;
 double r;
 
 
@@ -237,33 +236,12 @@ _O_DHTxx_t*	p;
 					case DHT11_FORMAT_EIS5:
 
 					// Temperature
-					dht_temp[c] *= 100.0/8.0;
-					w = (int16_t) dht_temp[c];
-					w &= 0x07ff;
-					w |= (3 << 11);
-					if (dht_temp[c] < 0)
-					w |= 0x8000;
-					// exchange LB-HB
-					b = (w >> 8) & 0xff;
-					w = w << 8;
-					w |= b;
 					b = p->eib_object;		// temperature address
-					eib_G_DATA_request(get_group_address (b), (uint8_t*)&w, 2);
+					eib_set_object_value (get_object_send_address (b), DPT_9, (int32_t) (dht_temp[c] * DPT_CENTI_SCALE));
 
 					// Humidity
-					dht_humid[c] *= 100.0/8.0;
-					w = (int16_t) dht_humid[c];
-					w &= 0x07ff;
-					w |= (3 << 11);
-					if (dht_humid[c] < 0)
-					w |= 0x8000;
-					// exchange LB-HB
-					b = (w >> 8) & 0xff;
-					w = w << 8;
-					w |= b;
-					XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);	// Reselect, lost after get_group_address()
 					b = p->eib_object2;		// humidity address
-					eib_G_DATA_request(get_group_address (b), (uint8_t*)&w, 2);
+					eib_set_object_value (get_object_send_address (b), DPT_9, (int32_t) (dht_humid[c] * DPT_CENTI_SCALE));
 					break;
 				}
 			}
@@ -30,8 +30,8 @@ typedef struct __attribute__ ((packed)) {
 	uint8_t		element_size;
 	uint8_t		element_type;
 	uint8_t		hw_channel;
-	uint8_t		eib_object;  // temperature
-	uint8_t		eib_object2; // humidity
+	uint16_t	eib_object;  // temperature
+	uint16_t	eib_object2; // humidity
 	uint8_t		repeat_frequency;
 	uint8_t		eis_number_format;
 	int8_t		temp_offset;
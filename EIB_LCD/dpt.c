@@ -0,0 +1,351 @@
+/** \file dpt.c
+ *  \brief Encoding and decoding of EIB datapoint types
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- decode object data of DPT 1, 3, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 16 and 232
+ *	- encode values into object data
+ *	- format object data as string for the value element
+ *
+ *	Float types (DPT 9 and 14) are handled as fixed point numbers in 1/100,
+ *	so no floating point arithmetic is needed.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "dpt.h"
+
+// codec table, indexed by DPT_xxx
+const _DPT_CODEC_t dpt_codec[DPT_COUNT] = {
+	{ 0,  1, DPT_CODING_BIT,     0 },							// DPT 1
+	{ 0,  1, DPT_CODING_STEP,    DPT_FLAG_SIGNED },				// DPT 3
+	{ 1,  1, DPT_CODING_INT,     0 },							// DPT 5
+	{ 1,  1, DPT_CODING_SCALING, 0 },							// DPT 5.001
+	{ 1,  1, DPT_CODING_INT,     DPT_FLAG_SIGNED },				// DPT 6
+	{ 2,  2, DPT_CODING_INT,     0 },							// DPT 7
+	{ 2,  2, DPT_CODING_INT,     DPT_FLAG_SIGNED },				// DPT 8
+	{ 2,  2, DPT_CODING_FLOAT16, DPT_FLAG_SIGNED | DPT_FLAG_CENTI },	// DPT 9
+	{ 3,  3, DPT_CODING_TIME,    0 },							// DPT 10
+	{ 3,  3, DPT_CODING_DATE,    0 },							// DPT 11
+	{ 4,  4, DPT_CODING_INT,     0 },							// DPT 12
+	{ 4,  4, DPT_CODING_INT,     DPT_FLAG_SIGNED },				// DPT 13
+	{ 4,  4, DPT_CODING_FLOAT32, DPT_FLAG_SIGNED | DPT_FLAG_CENTI },	// DPT 14
+	{ 14, 14, DPT_CODING_STRING, 0 },							// DPT 16
+	{ 3,  3, DPT_CODING_RGB,     0 }							// DPT 232
+};
+
+// get size of datapoint in the object
+uint8_t dpt_get_size (uint8_t dpt) {
+
+	if (dpt >= DPT_COUNT)
+		return 0;
+	return dpt_codec[dpt].size;
+}
+
+// get big endian integer of data
+static uint32_t dpt_get_int (uint8_t *data, uint8_t size) {
+
+uint32_t	value;
+
+	value = 0;
+	while (size--) {
+		value = (value << 8) | *data++;
+	}
+	return value;
+}
+
+// put big endian integer into data
+static void dpt_put_int (uint8_t *data, uint32_t value, uint8_t size) {
+
+	while (size--) {
+		data[size] = value & 0xff;
+		value >>= 8;
+	}
+}
+
+// decode 16 bit float into 1/100
+static int32_t dpt_decode_float16 (uint8_t *data) {
+
+int16_t		mantissa;
+uint8_t		exp;
+
+	mantissa = ((data[0] & 0x07) << 8) | data[1];
+	if (data[0] & 0x80)
+		mantissa -= 0x800;
+	exp = (data[0] >> 3) & 0x0f;
+
+	return (int32_t) mantissa << exp;
+}
+
+// encode 1/100 into 16 bit float
+static void dpt_encode_float16 (uint8_t *data, int32_t value) {
+
+int32_t		mantissa;
+uint8_t		exp;
+
+	if (value > DPT_9_MAX)
+		value = DPT_9_MAX;
+	if (value < DPT_9_MIN)
+		value = DPT_9_MIN;
+
+	// find the smallest exponent, the mantissa fits into 12 bit
+	exp = 0;
+	mantissa = value;
+	while ((mantissa > 2047) || (mantissa < -2048)) {
+		exp++;
+		mantissa = (value + ((int32_t) 1 << (exp -1))) >> exp;
+	}
+
+	data[0] = (exp << 3) | ((mantissa >> 8) & 0x07);
+	if (mantissa < 0)
+		data[0] |= 0x80;
+	data[1] = mantissa & 0xff;
+}
+
+// decode IEEE 754 float into 1/100, saturates at the int32_t limits
+static int32_t dpt_decode_float32 (uint8_t *data) {
+
+uint32_t	raw;
+uint32_t	mantissa;
+int16_t		shift;
+
+	raw = dpt_get_int (data, 4);
+	shift = (raw >> 23) & 0xff;
+	// zero and denormals
+	if (!shift)
+		return 0;
+
+	// 24 bit mantissa * 100 still fits into 31 bit
+	mantissa = ((raw & 0x7fffff) | 0x800000) * DPT_CENTI_SCALE;
+	shift -= 127 + 23;
+	if (shift >= 0) {
+		if ((shift > 7) || (mantissa > (0x7fffffffUL >> shift)))
+			mantissa = 0x7fffffffUL;
+		else mantissa <<= shift;
+	}
+	else if (shift > -32) {
+		mantissa = (mantissa + (1UL << (-shift -1))) >> -shift;
+	}
+	else mantissa = 0;
+
+	if (raw & 0x80000000UL)
+		return -(int32_t) mantissa;
+	return mantissa;
+}
+
+// encode 1/100 into IEEE 754 float
+static void dpt_encode_float32 (uint8_t *data, int32_t value) {
+
+uint32_t	a;
+uint32_t	q;
+int8_t		k;
+
+	if (!value) {
+		dpt_put_int (data, 0, 4);
+		return;
+	}
+
+	a = (value < 0) ? -(uint32_t) value : (uint32_t) value;
+
+	// scale a by 2^k, until a/100 has 24 significant bits
+	k = 0;
+	while (a < (100UL << 23)) {
+		a <<= 1;
+		k++;
+	}
+	// large values are divided by 200 in one step, so they are rounded only once
+	if (a >= (100UL << 24)) {
+		q = (a + 100) / 200;
+		k = -1;
+	}
+	else q = (a + 50) / 100;
+	if (q >= (1UL << 24)) {
+		q >>= 1;
+		k--;
+	}
+
+	q = ((uint32_t) (127 + 23 - k) << 23) | (q & 0x7fffff);
+	if (value < 0)
+		q |= 0x80000000UL;
+	dpt_put_int (data, q, 4);
+}
+
+// decode data into a fixed point value
+// DPT 9 and 14 are returned in 1/100, DPT 5.001 in %,
+// DPT 10, 11 and 232 as 24 bit big endian integer.
+int32_t dpt_decode (uint8_t dpt, uint8_t *data) {
+
+const _DPT_CODEC_t	*codec;
+int32_t		value;
+
+	if (dpt >= DPT_COUNT)
+		return 0;
+	codec = &dpt_codec[dpt];
+
+	switch (codec->coding) {
+		case DPT_CODING_BIT:
+			return data[0] & 0x01;
+
+		case DPT_CODING_STEP:
+			value = data[0] & 0x07;
+			if (data[0] & 0x08)
+				return value;
+			return -value;
+
+		case DPT_CODING_SCALING:
+			return ((uint16_t) data[0] * 100 + 127) / 255;
+
+		case DPT_CODING_FLOAT16:
+			return dpt_decode_float16 (data);
+
+		case DPT_CODING_FLOAT32:
+			return dpt_decode_float32 (data);
+
+		case DPT_CODING_STRING:
+			return 0;
+
+		default:
+			value = dpt_get_int (data, codec->size);
+			// sign extension
+			if ((codec->flags & DPT_FLAG_SIGNED) && (codec->size < 4) && (data[0] & 0x80))
+				value |= 0xffffffffUL << (8 * codec->size);
+			return value;
+	}
+}
+
+// encode fixed point value into data
+// returns the length of the data on the bus
+uint8_t dpt_encode (uint8_t dpt, int32_t value, uint8_t *data) {
+
+const _DPT_CODEC_t	*codec;
+
+	if (dpt >= DPT_COUNT)
+		return 0;
+	codec = &dpt_codec[dpt];
+
+	switch (codec->coding) {
+		case DPT_CODING_BIT:
+			data[0] = value ? 1 : 0;
+		break;
+
+		case DPT_CODING_STEP:
+			if (value < 0)
+				data[0] = (-value) & 0x07;
+			else data[0] = 0x08 | (value & 0x07);
+		break;
+
+		case DPT_CODING_SCALING:
+			if (value < 0)
+				value = 0;
+			if (value > 100)
+				value = 100;
+			data[0] = ((uint16_t) value * 255 + 50) / 100;
+		break;
+
+		case DPT_CODING_FLOAT16:
+			dpt_encode_float16 (data, value);
+		break;
+
+		case DPT_CODING_FLOAT32:
+			dpt_encode_float32 (data, value);
+		break;
+
+		case DPT_CODING_STRING:
+			memset (data, 0, codec->size);
+		break;
+
+		default:
+			dpt_put_int (data, value, codec->size);
+	}
+
+	return codec->length;
+}
+
+// format fixed point value in 1/100 like "% *.*f"
+static void dpt_format_centi (char *str, int32_t value, uint8_t width, uint8_t decimals) {
+
+char		buf[16];
+char		*p;
+uint32_t	v;
+uint8_t		d;
+
+	v = (value < 0) ? -(uint32_t) value : (uint32_t) value;
+
+	// round to the number of decimals
+	if (decimals == 0)
+		v = (v + 50) / 100;
+	else if (decimals == 1)
+		v = (v + 5) / 10;
+	d = (decimals < 2) ? decimals : 2;
+
+	if (d == 0)
+		sprintf_P (buf, PSTR("%c%lu"), (value < 0) ? '-' : ' ', (unsigned long) v);
+	else if (d == 1)
+		sprintf_P (buf, PSTR("%c%lu.%01lu"), (value < 0) ? '-' : ' ', (unsigned long) v / 10, (unsigned long) v % 10);
+	else sprintf_P (buf, PSTR("%c%lu.%02lu"), (value < 0) ? '-' : ' ', (unsigned long) v / 100, (unsigned long) v % 100);
+
+	// we only have 2 decimals, pad the rest with zeros
+	p = buf + strlen (buf);
+	while ((d < decimals) && (p < buf + sizeof (buf) -1)) {
+		*p++ = '0';
+		d++;
+	}
+	*p = '\0';
+
+	sprintf_P (str, PSTR("%*s"), width, buf);
+}
+
+// format data as string
+// integers: number of integer digits
+// decimals: number of decimals for float types, min. number of digits for integer types,
+//           DPT_DIGITS_ANY: integer without min. number of digits
+void dpt_format (char *str, uint8_t dpt, uint8_t *data, uint8_t integers, uint8_t decimals) {
+
+const _DPT_CODEC_t	*codec;
+uint8_t		year;
+uint8_t		i;
+int			digits;
+
+	*str = '\0';
+	if (dpt >= DPT_COUNT)
+		return;
+	codec = &dpt_codec[dpt];
+
+	switch (codec->coding) {
+		case DPT_CODING_FLOAT16:
+		case DPT_CODING_FLOAT32:
+			dpt_format_centi (str, dpt_decode (dpt, data), integers+decimals+2, decimals);
+		break;
+
+		case DPT_CODING_TIME:
+			sprintf_P (str, PSTR("%02u:%02u"), data[0] & 0x1f, data[1]);
+		break;
+
+		case DPT_CODING_DATE:
+			// years 90..99 belong to the 20th century
+			year = data[2] & 0x7f;
+			sprintf_P (str, PSTR("%02u.%02u.%04u"), data[0] & 0x1f, data[1] & 0x0f, (year < 90) ? 2000 + year : 1900 + year);
+		break;
+
+		case DPT_CODING_STRING:
+			for (i = 0; (i < codec->size) && data[i]; i++)
+				str[i] = data[i];
+			str[i] = '\0';
+		break;
+
+		case DPT_CODING_RGB:
+			sprintf_P (str, PSTR("%u:%u:%u"), data[0], data[1], data[2]);
+		break;
+
+		default:
+			// a negative precision is ignored by printf
+			digits = (decimals == DPT_DIGITS_ANY) ? -1 : decimals;
+			if (codec->flags & DPT_FLAG_SIGNED)
+				sprintf_P (str, PSTR("%*.*ld"), integers, digits, (long) dpt_decode (dpt, data));
+			else sprintf_P (str, PSTR("%*.*lu"), integers, digits, (unsigned long) (uint32_t) dpt_decode (dpt, data));
+	}
+}
@@ -0,0 +1,83 @@
+/** \file dpt.h
+ *  \brief Constants and definitions for the EIB datapoint type codec
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _DPT_H_
+#define _DPT_H_
+
+#include "System.h"
+
+// supported datapoint types, used as index into the codec table
+#define DPT_1		0	// 1 bit switch
+#define DPT_3		1	// 4 bit dimming/blinds control
+#define DPT_5		2	// 8 bit unsigned
+#define DPT_5_001	3	// 8 bit scaling 0..100%
+#define DPT_6		4	// 8 bit signed
+#define DPT_7		5	// 16 bit unsigned
+#define DPT_8		6	// 16 bit signed
+#define DPT_9		7	// 16 bit float
+#define DPT_10		8	// time of day
+#define DPT_11		9	// date
+#define DPT_12		10	// 32 bit unsigned
+#define DPT_13		11	// 32 bit signed
+#define DPT_14		12	// 32 bit IEEE float
+#define DPT_16		13	// 14 byte string
+#define DPT_232		14	// RGB color
+#define DPT_COUNT	15
+
+// coding of the datapoint value
+#define DPT_CODING_BIT		0	// 1 bit in the APCI
+#define DPT_CODING_STEP		1	// direction and step code in the APCI
+#define DPT_CODING_INT		2	// big endian integer
+#define DPT_CODING_SCALING	3	// 0..255 mapped to 0..100
+#define DPT_CODING_FLOAT16	4	// EIS5 float
+#define DPT_CODING_FLOAT32	5	// IEEE 754 float
+#define DPT_CODING_TIME		6
+#define DPT_CODING_DATE		7
+#define DPT_CODING_STRING	8
+#define DPT_CODING_RGB		9
+
+// codec flags
+#define DPT_FLAG_SIGNED		0x01	// value is a signed integer
+#define DPT_FLAG_CENTI		0x02	// value is scaled by DPT_CENTI_SCALE
+
+/**
+* @brief codec description of a datapoint type
+*/
+typedef struct {
+uint8_t		length;		// length of the data on the bus, 0: data is part of the APCI
+uint8_t		size;		// size of the data in the object
+uint8_t		coding;		// DPT_CODING_xxx
+uint8_t		flags;		// DPT_FLAG_xxx
+} _DPT_CODEC_t;
+
+// float values are handled as fixed point numbers with 2 decimals
+#define DPT_CENTI_SCALE		100
+
+// max. size of a datapoint value
+#define DPT_MAX_SIZE		14
+
+// dpt_format() shows all digits of an integer
+#define DPT_DIGITS_ANY		0xff
+
+// DPT 9 range in 1/100, 0x7fff is reserved for invalid data
+#define DPT_9_MAX			67043328L
+#define DPT_9_MIN			-67108864L
+
+// get size of datapoint in the object
+uint8_t dpt_get_size (uint8_t);
+// decode data into a fixed point value
+int32_t dpt_decode (uint8_t, uint8_t*);
+// encode fixed point value into data, returns the length on the bus
+uint8_t dpt_encode (uint8_t, int32_t, uint8_t*);
+// format data as string
+void dpt_format (char*, uint8_t, uint8_t*, uint8_t, uint8_t);
+
+#endif // _DPT_H_
@@ -244,18 +244,8 @@ _O_DS1820_t*	p;
 				switch (p->eis_number_format) {
 					case DS1820_FORMAT_EIS5:
 
-						ds1820_temp[c] *= 100.0/8.0;
-						w = (int16_t) ds1820_temp[c];
-						w &= 0x07ff;
-						w |= (3 << 11);
-						if (ds1820_temp[c] < 0)
-							w |= 0x8000;
-						// exchange LB-HB
-						b = (w >> 8) & 0xff;
-						w = w << 8;
-						w |= b;
 						b = p->eib_object;
-						eib_G_DATA_request(get_group_address (b), (uint8_t*)&w, 2);
+						eib_set_object_value (get_object_send_address (b), DPT_9, (int32_t) (ds1820_temp[c] * DPT_CENTI_SCALE));
 					break;
 				}
 
@@ -446,18 +436,8 @@ _O_DS1820_t*	p;
 				switch (p->eis_number_format) {
 					case DS1820_FORMAT_EIS5:
 
-						ds1820_temp[c] *= 100.0/8.0;
-						w = (int16_t) ds1820_temp[c];
-						w &= 0x07ff;
-						w |= (3 << 11);
-						if (ds1820_temp[c] < 0)
-							w |= 0x8000;
-						// exchange LB-HB
-						b = (w >> 8) & 0xff;
-						w = w << 8;
-						w |= b;
 						b = p->eib_object;
-						eib_G_DATA_request(get_group_address (b), (uint8_t*)&w, 2);
+						eib_set_object_value (get_object_send_address (b), DPT_9, (int32_t) (ds1820_temp[c] * DPT_CENTI_SCALE));
 					break;
 				}
 
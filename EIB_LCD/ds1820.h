@@ -26,7 +26,7 @@ typedef struct __attribute__ ((packed)) {
 uint8_t		element_size;
 uint8_t		element_type;
 uint8_t		hw_channel;
-uint8_t		eib_object;
+uint16_t	eib_object;
 uint8_t		repeat_frequency;
 uint8_t		eis_number_format;
 int8_t		temp_offset;
@@ -30,10 +30,10 @@ uint8_t touch_button_element (char *cp, t_touch_event *evt, uint8_t *touch_state
 _E_BUTTON_t*	p;
 uint16_t	width, height;
 uint8_t 	hit;
-uint8_t		eib_object;
+uint16_t	eib_object;
 uint8_t		eib_value[2];
 int16_t		new_value;
-float 		fval;
+int32_t 		value;
 
 	p = (_E_BUTTON_t*) cp;
 	get_picture_size (p->picture_index_down, &width, &height);
@@ -46,7 +46,6 @@ float 		fval;
 
 			// user released the touch screen
 			sound_play_clip (p->sound_index_up, 0);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 
 			// check, if we have to execute an activity
 			switch (p->eib_function) {
@@ -55,12 +54,10 @@ float 		fval;
 				case EIB_BUTTON_FUNCTION_DARKER:
 					// dimm stop
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 				break;
 			}
 
-			// set page descriptions bank for safety
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 			draw_picture (p->picture_index_up, p->x_pos, p->y_pos);
 			return 1;
 		}
@@ -72,28 +69,27 @@ float 		fval;
 				case EIB_BUTTON_FUNCTION_ON_BRIGHTER:
 					// switch on
 					eib_value[0] = 0x01;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 				break;
 				case EIB_BUTTON_FUNCTION_OFF_DARKER:
 					// switch off
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 				break;
 				case EIB_BUTTON_FUNCTION_UP_STEPUP:
 					// go up
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object1), eib_value, 0);
 				break;
 				case EIB_BUTTON_FUNCTION_DOWN_STEPDOWN:
 					// go down
 					eib_value[0] = 0x01;
-					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object1), eib_value, 0);
 				break;
 				case EIB_BUTTON_FUNCTION_DELTA_EIS6:
 					// add delta value to 8bit object and send it
 					eib_object = p->eib_object0;
 					eib_value[0] = eib_get_object_8_value (p->eib_object0);
-					XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 					new_value = eib_value[0] + (int8_t) p->value[0];
 					if (new_value < p->min) { 
 						new_value = p->min;
@@ -102,25 +98,23 @@ float 		fval;
 						new_value = p->max;
 					}
 					eib_value[0] = new_value & 0xff;
-					eib_G_DATA_request(get_group_address(eib_object), eib_value, 1);
+					eib_G_DATA_request(get_object_send_address (eib_object), eib_value, 1);
 				break;
 				case EIB_BUTTON_FUNCTION_DELTA_EIS5:
 					// add delta value to 16bit EIS5 object and send it
 					eib_object = p->eib_object0;
-					fval = eib_get_object_EIS5_value (eib_object);
-					XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-					fval += (float) ((int8_t) p->value[0])/10;
+					value = eib_get_object_value (eib_object, DPT_9);
+					// delta value is given in 1/10
+					value += 10 * (int8_t) p->value[0];
 					// check, if the new value is inside of the bounds
-					if (10*fval < p->min) { 
-						fval = p->min;
-						fval /= 10;
+					if (value < 10L*p->min) { 
+						value = 10L*p->min;
 					}
-					if (10*fval > p->max) { 
-						fval = p->max;
-						fval /= 10;
+					if (value > 10L*p->max) { 
+						value = 10L*p->max;
 					}
 					// send new value as EIS5
-					eib_set_object_EIS5_value(get_group_address(eib_object), fval);
+					eib_set_object_value (get_object_send_address (eib_object), DPT_9, value);
 				break;
 			}
 		}
@@ -136,7 +130,7 @@ float 		fval;
                     else {
                         eib_value[0] = 0x09;
                     }                        
-					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object1), eib_value, 0);
 				break;
 				case EIB_BUTTON_FUNCTION_OFF_DARKER:
 					// dimm down
@@ -147,17 +141,17 @@ float 		fval;
                     else {
                         eib_value[0] = 0x01;
                     }                        
-					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object1), eib_value, 0);
 				break;
 				case EIB_BUTTON_FUNCTION_UP_STEPUP:
 					// go up
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 				break;
 				case EIB_BUTTON_FUNCTION_DOWN_STEPDOWN:
 					// go down
 					eib_value[0] = 0x01;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 				break;
 			}
 		}
@@ -169,7 +163,7 @@ float 		fval;
 				case EIB_BUTTON_FUNCTION_OFF_DARKER:
 					// dimm stop
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object1), eib_value, 0);
 				break;
 			}
 		}
@@ -179,12 +173,12 @@ float 		fval;
 				case EIB_BUTTON_FUNCTION_STEPUP:
 					// go up
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 				break;
 				case EIB_BUTTON_FUNCTION_STEPDOWN:
 					// go down
 					eib_value[0] = 0x01;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 				break;
 			}
 		}
@@ -195,7 +189,6 @@ float 		fval;
 					// add delta value to 8bit object and send it
 					eib_object = p->eib_object0;
 					eib_value[0] = eib_get_object_8_value (p->eib_object0);
-					XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 					new_value = eib_value[0] + (int8_t) p->value[1];
 					if (new_value < p->min) { 
 						new_value = p->min;
@@ -204,25 +197,23 @@ float 		fval;
 						new_value = p->max;
 					}
 					eib_value[0] = new_value & 0xff;
-					eib_G_DATA_request(get_group_address(eib_object), eib_value, 1);
+					eib_G_DATA_request(get_object_send_address (eib_object), eib_value, 1);
 				break;
 				case EIB_BUTTON_FUNCTION_DELTA_EIS5:
 					// add delta value to 16bit EIS5 object and send it
 					eib_object = p->eib_object0;
-					fval = eib_get_object_EIS5_value (eib_object);
-					XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-					fval += (float) ((int8_t) p->value[1])/10;
+					value = eib_get_object_value (eib_object, DPT_9);
+					// delta value is given in 1/10
+					value += 10 * (int8_t) p->value[1];
 					// check, if the new value is inside of the bounds
-					if (10*fval < p->min) { 
-						fval = p->min;
-						fval /= 10;
+					if (value < 10L*p->min) { 
+						value = 10L*p->min;
 					}
-					if (10*fval > p->max) { 
-						fval = p->max;
-						fval /= 10;
+					if (value > 10L*p->max) { 
+						value = 10L*p->max;
 					}
 					// send new value as EIS5
-					eib_set_object_EIS5_value(get_group_address(eib_object), fval);
+					eib_set_object_value (get_object_send_address (eib_object), DPT_9, value);
 				break;
 			}
 		}
@@ -246,14 +237,12 @@ float 		fval;
 		if (evt->state == TOUCHED) {
 			*touch_state = 2;
 			sound_play_clip (p->sound_index_down, 0);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		}
 		else return 1;
 		// now we are touched first time
 		draw_picture (p->picture_index_down, p->x_pos, p->y_pos);
 		// check, if we have to send a message
 		// check, if we have to execute an activity
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		switch (p->eib_function) {
 			case EIB_BUTTON_FUNCTION_TOGGLE:
 				eib_object = p->eib_object0;
@@ -262,17 +251,17 @@ float 		fval;
 					eib_value[0] = 0x00;
 				else
 					eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (eib_object), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_ON:
 				// switch on
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_OFF:
 				// switch off
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_BRIGHTER:
 				// dimm up
@@ -283,7 +272,7 @@ float 		fval;
                 else {
                 	eib_value[0] = 0x09;
                 }                    
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_DARKER:
 				// dimm down
@@ -294,30 +283,30 @@ float 		fval;
                 else {
                     eib_value[0] = 0x01;
                 }                
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_UP:
 			case EIB_BUTTON_FUNCTION_STEPUP:
 				// go up
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_DOWN:
 			case EIB_BUTTON_FUNCTION_STEPDOWN:
 				// go down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_8BIT_VALUE:
 				eib_object = p->eib_object0;
 				eib_value[0] = p->value[0];
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 1);
+				eib_G_DATA_request(get_object_send_address (eib_object), eib_value, 1);
 			break;
 			case EIB_BUTTON_FUNCTION_16BIT_VALUE:
 				eib_object = p->eib_object0;
 				eib_value[0] = p->value[1];
 				eib_value[1] = p->value[0];
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 2);
+				eib_G_DATA_request(get_object_send_address (eib_object), eib_value, 2);
 			break;
 		}
 	}
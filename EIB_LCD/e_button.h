@@ -22,8 +22,8 @@ uint16_t	picture_index_up;
 uint16_t	picture_index_down;
 uint16_t	x_pos;
 uint16_t	y_pos;
-uint8_t		eib_object0;
-uint8_t		eib_object1;
+uint16_t	eib_object0;
+uint16_t	eib_object1;
 uint8_t		eib_function;
 uint16_t	sound_index_up;
 uint16_t	sound_index_down;
@@ -68,7 +68,6 @@ uint8_t 	hit, hit_with_margin;
 
 			// user released the touch screen
 			sound_play_clip (p->sound_index_up, 0);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 
 			if (hit_with_margin) {
 				// execute activity
@@ -104,7 +103,6 @@ uint8_t 	hit, hit_with_margin;
 		if (evt->state == TOUCHED) {
 			*touch_state = 2;
 			sound_play_clip (p->sound_index_down, 0);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		}
 		else return 1;
 		// now we are touched first time
@@ -27,8 +27,6 @@ uint8_t		s;
 
 	p = (_E_LED_t*) cp;
 
-	XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-
 	/* binary or radio button function? */
 	if (p->parameter & LED_PARAMETER_RADIO) {
 		s = p->repeat_radio_value == eib_get_object_8_value (p->eib_object_listen);
@@ -37,13 +35,10 @@ uint8_t		s;
 		m = 1 << (p->parameter & LED_PARAMETER_BITPOS);
 		s = eib_get_object_8_value (p->eib_object_listen) & m;
 	}
-	XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 	if (s) {
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		if (p->parameter & LED_PARAMETER_WARNING) {
 			draw_picture (p->picture_warning_index, p->x_pos, p->y_pos);
 			set_backlight_on ();
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 			sound_play_clip (p->sound_index_warning, p->repeat_radio_value);
 		}
 		else {
@@ -56,13 +51,14 @@ uint8_t		s;
 }
 
 
-void check_led_element (char* cp, int obj) {
+void check_led_element (char* cp) {
 
 _E_LED_t*	p;
 
 	p = (_E_LED_t*) cp;
 
-	if (p->eib_object_listen == obj)
+	// warnings wake up the display on every write
+	if (eib_object_updated (p->eib_object_listen, p->parameter & (LED_PARAMETER_FORCE | LED_PARAMETER_WARNING)))
 		draw_led_element (cp);
 }
 
@@ -88,7 +84,6 @@ uint8_t		eib_value;
 
 			// user released the touch screen
 			sound_play_clip (p->sound_index_up, 0);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 
 			return 1;
 		}
@@ -111,7 +106,6 @@ uint8_t		eib_value;
 		if (evt->state == TOUCHED) {
 			*touch_state = 2;
 			sound_play_clip (p->sound_index_down, 0);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		}
 		else return 1;
 		// now we are touched first time
@@ -120,14 +114,12 @@ uint8_t		eib_value;
 		if (p->parameter & LED_PARAMETER_WARNING) {
 			/* Warning element can switch off only */
 			eib_value = 0x00;
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0);
+			eib_G_DATA_request(get_object_send_address (p->eib_object_send), &eib_value, 0);
 		}
 		else if (p->parameter & LED_PARAMETER_RADIO) {
 			/* Radio button element always sends its own ID */
 			eib_value = p->repeat_radio_value;
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 1);
+			eib_G_DATA_request(get_object_send_address (p->eib_object_send), &eib_value, 1);
 		}
 		else {
 			/* Indicator LED always toggles its object value */
@@ -136,8 +128,7 @@ uint8_t		eib_value;
 				eib_value = 0x00;
 			else
 				eib_value = 0x01;
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0);
+			eib_G_DATA_request(get_object_send_address (p->eib_object_send), &eib_value, 0);
 		}
 
 		return 0;
@@ -153,7 +144,6 @@ _E_LED_t*	p;
 		/* warning function? */
 		if (p->parameter & LED_PARAMETER_WARNING) {
 			if (eib_get_object_8_value (p->eib_object_listen)) {
-				XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 				if (warning_toggle)
 					draw_picture (p->picture_warning_index, p->x_pos, p->y_pos);
 				else
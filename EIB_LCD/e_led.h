@@ -22,8 +22,8 @@ uint16_t	picture_on_index;
 uint16_t	picture_warning_index;
 uint16_t	x_pos;
 uint16_t	y_pos;
-uint8_t		eib_object_listen;
-uint8_t		eib_object_send;
+uint16_t	eib_object_listen;
+uint16_t	eib_object_send;
 uint8_t		parameter;
 uint8_t		repeat_radio_value; // radio button index or warning sound repetitions
 uint16_t	sound_index_up;
@@ -31,6 +31,7 @@ uint16_t	sound_index_down;
 uint16_t	sound_index_warning;
 } _E_LED_t;
 #define LED_PARAMETER_BITPOS	0x07
+#define LED_PARAMETER_FORCE		0x08
 #define LED_PARAMETER_WARNING	0x10
 #define LED_PARAMETER_RADIO		0x20
 #define LED_PARAMETER_SEND 		0x40
@@ -40,7 +41,7 @@ uint16_t	sound_index_warning;
 void draw_led_element (char*);
 
 // check for update from EIB
-void check_led_element (char*, int);
+void check_led_element (char*);
 
 uint8_t touch_led_element (char*, t_touch_event*, uint8_t*);
 /* cyclic check of the warning state to toggle the picture */
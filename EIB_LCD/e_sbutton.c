@@ -29,38 +29,32 @@ uint8_t 		eib_value;
 
 	p = (_E_SBUTTON_t*) cp;
 
-	XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-
 	eib_value = eib_get_object_8_value (p->eib_object_listen);
 	if (touch_state == 2) {
 		if (eib_value) {
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 			draw_picture (p->picture_index_down_on, p->x_pos, p->y_pos);
 		}
 		else {
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 			draw_picture (p->picture_index_down_off, p->x_pos, p->y_pos);
 		}
 	}
 	else {
 		if (eib_value) {
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 			draw_picture (p->picture_index_up_on, p->x_pos, p->y_pos);
 		}
 		else {
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 			draw_picture (p->picture_index_up_off, p->x_pos, p->y_pos);
 		}
 	}
 }
 
-void check_sbutton_element (char* cp, int obj, uint8_t is_active, uint8_t state) {
+void check_sbutton_element (char* cp, uint8_t is_active, uint8_t state) {
 
 _E_SBUTTON_t*	p;
 
 	p = (_E_SBUTTON_t*) cp;
 
-	if (p->eib_object_listen == obj)
+	if (eib_object_updated (p->eib_object_listen, p->eib_function & EIB_SBUTTON_FUNCTION_FORCE))
 		draw_sbutton_element (cp, (is_active)? state : 0);
 }
 
@@ -70,7 +64,7 @@ uint8_t touch_sbutton_element (char *cp, t_touch_event *evt, uint8_t *touch_stat
 _E_SBUTTON_t*	p;
 uint16_t	width, height;
 uint8_t 	hit;
-uint8_t		eib_object;
+uint16_t	eib_object;
 uint8_t		eib_value;
 
 	p = (_E_SBUTTON_t*) cp;
@@ -84,9 +78,7 @@ uint8_t		eib_value;
 
 			// user released the touch screen
 			sound_play_clip (p->sound_index_up, 0);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 
-			// set page descriptions bank for safety
 			draw_sbutton_element (cp, 0);
 			return 1;
 		}
@@ -111,15 +103,13 @@ uint8_t		eib_value;
 		if (evt->state == TOUCHED) {
 			*touch_state = 2;
 			sound_play_clip (p->sound_index_down, 0);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		}
 		else return 1;
 		// now we are touched first time
 		draw_sbutton_element (cp, 2);
 		// check, if we have to send a message
 		// check, if we have to execute an activity
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-		switch (p->eib_function) {
+		switch (p->eib_function & EIB_SBUTTON_FUNCTION_MASK) {
 			case EIB_BUTTON_FUNCTION_TOGGLE:
 				eib_object = p->eib_object_send;
 				eib_value = eib_get_object_8_value (p->eib_object_listen);
@@ -127,17 +117,17 @@ uint8_t		eib_value;
 					eib_value = 0x00;
 				else
 					eib_value = 0x01;
-				eib_G_DATA_request(get_group_address (eib_object), &eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (eib_object), &eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_ON:
 				// switch on
 				eib_value = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object_send), &eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_OFF:
 				// switch off
 				eib_value = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object_send), &eib_value, 0);
 			break;
 		}
 	}
@@ -24,8 +24,8 @@ uint16_t	picture_index_up_on;
 uint16_t	picture_index_down_on;
 uint16_t	x_pos;
 uint16_t	y_pos;
-uint8_t		eib_object_send;
-uint8_t		eib_object_listen;
+uint16_t	eib_object_send;
+uint16_t	eib_object_listen;
 uint8_t		eib_function;
 uint16_t	sound_index_up;
 uint16_t	sound_index_down;
@@ -34,6 +34,11 @@ uint16_t	sound_index_down;
 #define EIB_SBUTTON_FUNCTION_TOGGLE		0
 #define EIB_SBUTTON_FUNCTION_ON			1
 #define EIB_SBUTTON_FUNCTION_OFF		2
+#define EIB_SBUTTON_FUNCTION_MASK		0x3f
+// redraw on every write of the listen object
+#define EIB_SBUTTON_FUNCTION_FORCE		0x80
+// read listen object on init
+#define EIB_SBUTTON_FUNCTION_INIT		0x40
 
 // draw button on screen
 void draw_sbutton_element (char*, uint8_t);
@@ -45,6 +50,6 @@ uint8_t touch_sbutton_element (char*, t_touch_event*, uint8_t*);
 // object#
 // boolean: this element is touched
 // state of touched element
-void check_sbutton_element (char*, int, uint8_t, uint8_t);
+void check_sbutton_element (char*, uint8_t, uint8_t);
 
 #endif // _E_SBUTTON_H_
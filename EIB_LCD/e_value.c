@@ -15,7 +15,6 @@
  *
  */
 #include "e_value.h"
-#include "math.h"
 #include "System.h"
 
 uint16_t show_value_string (uint16_t ofs_0, uint16_t x1, uint16_t y1, char *str) {
@@ -148,13 +147,11 @@ uint16_t tdx = p->text_x;
 
 	// change color in case of timeout
 	if ((p->timeout_time) && ((p->timeout_time * 60) < lcd_get_timeout_counter(p->eib_object_listen))) {
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		post_pict = p->picture_timeout_index1 + PICTURE_OFFSET_POSTFIXUNIT;
 		ofs_0 = p->picture_timeout_index1 + PICTURE_OFFSET_ZERO;
 		p->parameter |= VALUE_PARAMETER_TIMEOUT_CONDITION;
 	}
 	else {
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		post_pict = p->picture_index1 + PICTURE_OFFSET_POSTFIXUNIT;
 		ofs_0 = p->picture_index1 + PICTURE_OFFSET_ZERO;
 		p->parameter &= (0xff ^ VALUE_PARAMETER_TIMEOUT_CONDITION);
@@ -174,16 +171,28 @@ uint16_t tdx = p->text_x;
 	}
 }
 
+// DPT of the value types
+const uint8_t value_type_dpt[VALUE_TYPE_COUNT] = {
+	DPT_5_001,	// EIS6, 0-100%
+	DPT_5,		// EIS6, 0-255
+	DPT_9,		// EIS5
+	DPT_14,		// EIS9
+	DPT_7,		// EIS10: 16 bit unsigned
+	DPT_8,		// EIS10: 16 bit signed
+	DPT_12,		// EIS11: 32 bit unsigned
+	DPT_13,		// EIS11: 32 bit signed
+	DPT_10,		// EIS3: time
+	DPT_11		// EIS4: date
+};
+
 void draw_value_element (char* cp) {
 
 _E_VALUE_t*	p;
-uint16_t val;
 char numstr[MAX_VALUE_LENGTH];
 uint8_t integers;
 uint8_t decimals;
-float fval;
-uint32_t *val32;
-uint8_t td[4];
+uint8_t type;
+uint8_t data[DPT_MAX_SIZE];
 
 	p = (_E_VALUE_t*) cp;
 
@@ -193,97 +202,30 @@ uint8_t td[4];
 	// put value
 	integers = (p->chars >> 4) & 0x0f;
 	decimals = p->chars & 0x0f;
+	type = p->parameter & 0x0f;
 
 	// check object value type and calculate value string
-	switch (p->parameter & 0x0f) {
-		// EIS6, 0-100%
-		case 0:
-			val = eib_get_object_8_value (p->eib_object_listen);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			val &= 0xff;
-			val *= 100;
-			val /= 0xff;
-			sprintf_P (numstr, PSTR("%*.*d"), integers, decimals, val);
-		break;
-		
-		// EIS6, 0-255%
-		case 1:
-			val = eib_get_object_8_value (p->eib_object_listen);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			sprintf_P (numstr, PSTR("%*.*d"), integers, decimals, val & 0xff);
-		break;
-
-		// EIS5
-		case 2:
-			fval = eib_get_object_EIS5_value (p->eib_object_listen);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			sprintf_P (numstr, PSTR("% *.*f"), integers+decimals+2, decimals, fval);
-		break;
-
-		// EIS9
-		case 3:
-			val32 = (uint32_t*)&fval;
-			*val32 = eib_get_object_32_value (p->eib_object_listen);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			sprintf_P (numstr, PSTR("% *.*f"), integers+decimals+2, decimals, fval);
-		break;
-		// EIS10: 16 bit unsigned
-		case 4:
-			val = eib_get_object_16_value (p->eib_object_listen);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			sprintf_P (numstr, PSTR("%*u"), integers, val);
-		break;
-		// EIS10: 16 bit signed
-		case 5:
-			val = eib_get_object_16_value (p->eib_object_listen);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			sprintf_P (numstr, PSTR("%*d"), integers, (int16_t)val);
-		break;
-		// EIS10: 32 bit unsigned
-		case 6:
-			val32 = (uint32_t*)td;
-			*val32 = eib_get_object_32_value (p->eib_object_listen);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			sprintf_P (numstr, PSTR("%*lu"), integers, *val32);
-		break;
-		// EIS10: 32 bit signed
-		case 7:
-			val32 = (uint32_t*)td;
-			*val32 = eib_get_object_32_value (p->eib_object_listen);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			sprintf_P (numstr, PSTR("%*ld"), integers, (int32_t)*val32);
-		break;
-		// EIS3: time
-		case 8:
-			val32 = (uint32_t*)td;
-			*val32 = eib_get_object_32_value (p->eib_object_listen);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-				sprintf_P (numstr, PSTR("%02u:%02u"), td[3] & 0x1f, td[2]);
-		break;
-		// EIS4: date
-		case 9:
-			val32 = (uint32_t*)td;
-			*val32 = eib_get_object_32_value (p->eib_object_listen);
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			sprintf_P (numstr, PSTR("%02u.%02u.20%02u"), td[3], td[2], td[1]);
-		break;
-
-		default:
-			numstr[0] = '\0';
+	if (type < VALUE_TYPE_COUNT) {
+		eib_get_object_data (p->eib_object_listen, data, DPT_MAX_SIZE);
+		// the decimals are the min. number of digits of the 8 bit types only
+		if ((type >= VALUE_TYPE_INT_FIRST) && (type <= VALUE_TYPE_INT_LAST))
+			decimals = DPT_DIGITS_ANY;
+		dpt_format (numstr, value_type_dpt[type], data, integers, decimals);
 	}
+	else numstr[0] = '\0';
 
 	// output value to screen
 	show_value_string_with_postfix (p, numstr);
 }
 
 
-void check_value_element (char* cp, int obj) {
+void check_value_element (char* cp) {
 
 _E_VALUE_t*	p;
 
 	p = (_E_VALUE_t*) cp;
 
-	if (p->eib_object_listen == obj) {
+	if (eib_object_updated (p->eib_object_listen, p->parameter & VALUE_PARAMETER_FORCE)) {
 		draw_value_element (cp);
 	}
 }
@@ -299,14 +241,12 @@ _E_VALUE_t*	p;
 		return;
 	// check timeout condition of object
 	if ((p->timeout_time) && ((p->timeout_time * 60) < lcd_get_timeout_counter(p->eib_object_listen))) {
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		// timeout ocurred, is it already flagged?
 		if (!(p->parameter & VALUE_PARAMETER_TIMEOUT_CONDITION)) {
 			draw_value_element (cp);
 		}
 	}	
 	else {
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		// timeout did not ocur
 		if ((p->parameter & VALUE_PARAMETER_TIMEOUT_CONDITION)) {
 			draw_value_element (cp);
@@ -23,16 +23,25 @@ uint16_t	x_pos;
 uint16_t	y_pos;
 uint8_t		text_x;
 uint8_t		chars;
-uint8_t		eib_object_listen;
-// d1: 1=init
+uint16_t	eib_object_listen;
+// d0..d3: value type
+// d5: 1=read on init
+// d6: 1=redraw on every write
 // d7: 1=timeout was detected
 uint8_t		parameter;
 uint8_t		timeout_time;
 } _E_VALUE_t;
-#define VALUE_PARAMETER_INIT 0x02
+#define VALUE_PARAMETER_INIT	0x20
+#define VALUE_PARAMETER_FORCE	0x40
 #define VALUE_PARAMETER_TIMEOUT_CONDITION	0x80
 
-#define MAX_VALUE_LENGTH 14
+#define MAX_VALUE_LENGTH 16
+
+// value types, d0..d3 of parameter
+#define VALUE_TYPE_COUNT	10
+// value types of 16 and 32 bit integers, they are shown without min. number of digits
+#define VALUE_TYPE_INT_FIRST	4
+#define VALUE_TYPE_INT_LAST		7
 
 #define PICTURE_OFFSET_BACKGROUND	0
 #define PICTURE_OFFSET_ZERO			1
@@ -47,7 +56,7 @@ uint8_t		timeout_time;
 void draw_value_element (char*);
 
 // check for update from EIB
-void check_value_element (char*, int);
+void check_value_element (char*);
 
 // check for timeout condition
 void check_value_timeout (char*);
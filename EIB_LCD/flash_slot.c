@@ -0,0 +1,170 @@
+/** \file flash_slot.c
+ *  \brief Functions for the A/B project slots in Flash
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- select the active project slot from the selector log
+ *	- switch to another slot by appending a record to the log
+ *	- roll back to the project of the inactive slot
+ *
+ *	A project is downloaded into the inactive slot, while the project of
+ *	the active slot keeps running. The new slot is selected by one record
+ *	after the download has been verified, an interrupted download leaves
+ *	the active slot untouched. All project accesses to the Flash add the
+ *	first sector of the active slot, see FLASH_SELECT_SECTOR().
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "flash_slot.h"
+
+// first sector of the active slot
+uint8_t flash_slot_base;
+uint8_t flash_slot_active;
+// selector sector in use, word offset of its next free record
+uint8_t flash_slot_log;
+uint16_t flash_slot_offset;
+// sequence number of the last record
+uint16_t flash_slot_sequence;
+
+// read record at offset of a selector sector
+// returns its slot or 0xff if it is not valid
+static uint8_t flash_slot_read_record (uint8_t log, uint16_t offset, uint16_t *sequence) {
+
+uint8_t		sector;
+uint16_t	slot;
+
+	sector = FLASH_PROJECT_SECTOR(FLASH_SLOT_SECTOR(log));
+	if (read_flash (sector, offset) != FLASH_SLOT_MAGIC)
+		return 0xff;
+	slot = read_flash (sector, offset +1);
+	*sequence = read_flash (sector, offset +2);
+	if ((slot >= FLASH_SLOT_COUNT) ||
+		(read_flash (sector, offset +3) != (slot ^ *sequence ^ FLASH_SLOT_MAGIC)))
+		return 0xff;
+	return slot;
+}
+
+// read both selector sectors and select the active slot
+void flash_slot_init (void) {
+
+uint16_t	offset[FLASH_SLOT_LOGS];
+uint16_t	sequence;
+uint8_t		found;
+uint8_t		log;
+uint8_t		slot;
+
+	flash_slot_active = 0;
+	flash_slot_log = 0;
+	flash_slot_sequence = 0;
+	found = 0;
+	for (log = 0; log < FLASH_SLOT_LOGS; log++) {
+		for (offset[log] = 0; offset[log] + FLASH_SLOT_RECORD_WORDS <= FLASH_SECTOR_SIZE; offset[log] += FLASH_SLOT_RECORD_WORDS) {
+			// end of the log
+			if (read_flash (FLASH_PROJECT_SECTOR(FLASH_SLOT_SECTOR(log)), offset[log]) == 0xffff)
+				break;
+			// interrupted records are skipped, the sequence number may wrap
+			slot = flash_slot_read_record (log, offset[log], &sequence);
+			if ((slot != 0xff) && (!found || ((int16_t) (sequence - flash_slot_sequence) > 0))) {
+				found = 1;
+				flash_slot_active = slot;
+				flash_slot_log = log;
+				flash_slot_sequence = sequence;
+			}
+		}
+	}
+	// the log continues in the sector of the last record
+	flash_slot_offset = offset[flash_slot_log];
+	flash_slot_base = FLASH_SLOT_FIRST_SECTOR(flash_slot_active);
+
+#ifdef LCD_DEBUG
+	printf_P (PSTR("\nFlash slot %d active"), flash_slot_active);
+#endif
+}
+
+// get active slot
+uint8_t flash_slot_get_active (void) {
+
+	return flash_slot_active;
+}
+
+// check, if slot holds a project of a supported version
+uint8_t flash_slot_valid (uint8_t slot) {
+
+uint8_t	sector;
+uint8_t	version;
+
+	sector = FLASH_PROJECT_SECTOR(FLASH_SLOT_FIRST_SECTOR(slot));
+	// the inactive slot may be erased or programmed by another thread
+	flash_read_begin ();
+	if ((read_flash (sector, 0x00) != LCD_HEADER_MAGIC_0) ||
+		(read_flash (sector, 0x01) != LCD_HEADER_MAGIC_1) ||
+		(read_flash (sector, 0x02) != LCD_HEADER_MAGIC_2))
+		version = 0;
+	else version = read_flash (sector, 0x03) & 0xff;
+	flash_read_end ();
+	return (version == LCD_VERSION_EXPECTED) || (version == LCD_VERSION_COMPAT);
+}
+
+// make slot active
+// The project of the old slot must not be used anymore, init_system_from_flash() loads the new one.
+// returns 0 if ok, 1 on Flash error
+uint8_t flash_slot_select (uint8_t slot) {
+
+_FLASH_SLOT_RECORD_t	record;
+uint16_t	sequence;
+uint8_t		result;
+
+	record.magic = FLASH_SLOT_MAGIC;
+	record.slot = slot;
+	record.sequence = flash_slot_sequence +1;
+	record.check = slot ^ record.sequence ^ FLASH_SLOT_MAGIC;
+
+	flash_program_begin ();
+
+	// continue the log in the other sector, if the record does not fit anymore.
+	// The records of the full sector stay valid, until the other sector is full, too.
+	result = 0;
+	if (flash_slot_offset + FLASH_SLOT_RECORD_WORDS > FLASH_SECTOR_SIZE) {
+		flash_slot_log ^= 1;
+		result = erase_flash_sector (FLASH_SLOT_SECTOR(flash_slot_log));
+		flash_slot_offset = 0;
+	}
+	if (!result && (write_nand_flash (FLASH_SLOT_SECTOR(flash_slot_log), flash_slot_offset, FLASH_SLOT_RECORD_WORDS, (uint8_t*) &record) < 0))
+		result = 1;
+	if (!result && (flash_slot_read_record (flash_slot_log, flash_slot_offset, &sequence) != slot))
+		result = 1;
+
+	flash_program_end ();
+
+	flash_slot_offset += FLASH_SLOT_RECORD_WORDS;
+	if (result)
+		return 1;
+
+	flash_slot_sequence = record.sequence;
+
+	set_flash_content_invalid ();
+	flash_slot_active = slot;
+	flash_slot_base = FLASH_SLOT_FIRST_SECTOR(slot);
+
+#ifdef LCD_DEBUG
+	printf_P (PSTR("\nFlash slot %d selected"), slot);
+#endif
+	return 0;
+}
+
+// make the inactive slot active again
+// returns 0 if ok, 1 if it holds no project or on Flash error
+uint8_t flash_slot_rollback (void) {
+
+uint8_t	slot;
+
+	slot = flash_slot_active ^ 1;
+	if (!flash_slot_valid (slot))
+		return 1;
+	return flash_slot_select (slot);
+}
@@ -0,0 +1,54 @@
+/** \file flash_slot.h
+ *  \brief Constants and definitions for the A/B project slots in Flash
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _FLASH_SLOT_H_
+#define _FLASH_SLOT_H_
+
+#include "System.h"
+
+// two project slots: slot 0 uses sectors 0..61, slot 1 uses sectors 62..123, sector 124 is unused
+#define FLASH_SLOT_COUNT			2
+#define FLASH_SLOT_SECTORS			62
+#define FLASH_SLOT_FIRST_SECTOR(slot)	((slot) * FLASH_SLOT_SECTORS)
+// the two sectors of the selector log are stored in front of the snapshot sector
+#define FLASH_SLOT_LOGS				2
+#define FLASH_SLOT_SECTOR(log)		(SNAPSHOT_SECTOR - FLASH_SLOT_LOGS + (log))
+
+/**
+* @brief record of the selector log
+*
+* Records are appended to one of the selector sectors, the valid record with
+* the highest sequence number selects the active slot. If a sector is full,
+* the other sector is erased and continues the log, so a valid record is kept
+* while a sector is erased. Without a valid record, slot 0 is active.
+*/
+typedef struct __attribute__ ((packed)) {
+uint16_t	magic;
+uint16_t	slot;
+uint16_t	sequence;
+uint16_t	check;		// slot ^ sequence ^ magic
+} _FLASH_SLOT_RECORD_t;
+
+#define FLASH_SLOT_MAGIC			0x534C
+#define FLASH_SLOT_RECORD_WORDS		(sizeof (_FLASH_SLOT_RECORD_t) >> 1)
+
+// read the selector log and select the active slot, call before the project is loaded
+void flash_slot_init (void);
+// get active slot
+uint8_t flash_slot_get_active (void);
+// check, if slot holds a project
+uint8_t flash_slot_valid (uint8_t);
+// make slot active, returns 0 if ok, 1 on Flash error
+uint8_t flash_slot_select (uint8_t);
+// make the inactive slot active again, returns 0 if ok, 1 if it holds no project
+uint8_t flash_slot_rollback (void);
+
+#endif // _FLASH_SLOT_H_
@@ -0,0 +1,330 @@
+/** \file history.c
+ *  \brief Functions for the object value history
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- record received values of traced objects with time stamps
+ *	- down-sample the values into 1 minute and 15 minute buckets
+ *	- query min/max/avg of the buckets for rendering
+ *
+ *	Objects are selected by listen elements of type LISTEN_ELEMENT_TRACE.
+ *	All values are stored delta encoded, so the 15 minute tier keeps 24h
+ *	in 384 Bytes per object.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "history.h"
+
+#ifdef HISTORY_SUPPORT
+
+// access delta of an entry of samples or buckets
+#define HISTORY_DELTA(entries, entry_size, i)	(*(int16_t*) ((entries) + (uint16_t) (i) * (entry_size)))
+
+// number of used slots
+uint8_t history_slots;
+// minute of the last tick
+uint32_t history_minute;
+
+// select bank of slot and get its address
+static _HISTORY_SLOT_t* history_slot (uint8_t slot) {
+
+	XRAM_SELECT_BLOCK(XRAM_HISTORY_PAGE + slot / HISTORY_SLOTS_PER_BANK);
+	return (_HISTORY_SLOT_t*) (XRAM_BASE_ADDRESS + (slot % HISTORY_SLOTS_PER_BANK) * sizeof (_HISTORY_SLOT_t));
+}
+
+// find slot of object, returns NULL if object is not traced
+static _HISTORY_SLOT_t* history_find (uint16_t object) {
+
+_HISTORY_SLOT_t	*s;
+uint8_t	i;
+
+	for (i = 0; i < history_slots; i++) {
+		s = history_slot (i);
+		if (s->object == object)
+			return s;
+	}
+	return NULL;
+}
+
+// encode distance to the average, rounded up
+static uint8_t history_encode_spread (int32_t d) {
+
+uint8_t	e;
+
+	if (d <= 0)
+		return 0;
+	if (d < 16)
+		return d;
+
+	e = 1;
+	while (((uint32_t) 31 << (e -1)) < d) {
+		if (e == 15)
+			return 0xff;
+		e++;
+	}
+	return (e << 4) | ((((d + (1L << (e -1)) -1) >> (e -1)) - 16) & 0x0f);
+}
+
+// decode distance to the average
+static int32_t history_decode_spread (uint8_t c) {
+
+	if (!(c >> 4))
+		return c;
+	return (int32_t) (16 + (c & 0x0f)) << ((c >> 4) -1);
+}
+
+// add value to accumulator
+static void history_acc_add (_HISTORY_ACC_t *acc, int32_t value, int32_t min, int32_t max) {
+
+	if (!acc->count) {
+		acc->ref = value;
+		acc->min = min;
+		acc->max = max;
+		acc->sum = 0;
+	}
+	if (min < acc->min)
+		acc->min = min;
+	if (max > acc->max)
+		acc->max = max;
+	if (acc->count == 0xff)
+		return;
+	acc->sum += value - acc->ref;
+	acc->count++;
+}
+
+// get average of accumulator
+static int32_t history_acc_avg (_HISTORY_ACC_t *acc) {
+
+	return acc->ref + acc->sum / acc->count;
+}
+
+// append entry to ring, the delta of the entry is stored
+// returns index of the new entry
+static uint8_t history_ring_add (_HISTORY_RING_t *ring, uint8_t *entries, uint8_t entry_size, uint8_t size, int32_t value, uint32_t time) {
+
+int32_t	delta;
+uint8_t	i;
+
+	if (!ring->count) {
+		ring->base = value;
+		ring->last = value;
+		delta = 0;
+	}
+	else {
+		// saturate large steps, the next entries catch up
+		delta = value - ring->last;
+		if (delta > INT16_MAX)
+			delta = INT16_MAX;
+		if (delta < INT16_MIN)
+			delta = INT16_MIN;
+		ring->last += delta;
+	}
+
+	// drop oldest entry
+	if (ring->count == size) {
+		ring->first = (ring->first +1) % size;
+		ring->base += HISTORY_DELTA(entries, entry_size, ring->first);
+		ring->count--;
+	}
+
+	i = (ring->first + ring->count) % size;
+	HISTORY_DELTA(entries, entry_size, i) = delta;
+	ring->count++;
+	ring->time = time;
+	return i;
+}
+
+// close running bucket of a tier
+static void history_close_bucket (_HISTORY_ACC_t *acc, _HISTORY_RING_t *ring, _HISTORY_BUCKET_t *buckets, uint8_t size, uint32_t time) {
+
+uint8_t	i;
+
+	i = history_ring_add (ring, (uint8_t*) buckets, sizeof (_HISTORY_BUCKET_t), size, history_acc_avg (acc), time);
+	buckets[i].below = history_encode_spread (ring->last - acc->min);
+	buckets[i].above = history_encode_spread (acc->max - ring->last);
+	acc->count = 0;
+}
+
+// forget all traced objects
+void history_init (void) {
+
+	history_slots = 0;
+	history_minute = NutGetSeconds () / HISTORY_MINUTE_TIME;
+}
+
+// init trace element: add object to the history
+void init_trace_object (char* cp) {
+
+_O_TRACE_t*	p;
+_HISTORY_SLOT_t	*s;
+uint16_t	object;
+uint8_t	dpt;
+
+	p = (_O_TRACE_t*) cp;
+	object = p->eib_object_listen;
+	dpt = p->dpt;
+
+	if ((history_slots >= HISTORY_MAX_SLOTS) || history_find (object))
+		return;
+
+	s = history_slot (history_slots++);
+	memset (s, 0, sizeof (_HISTORY_SLOT_t));
+	s->object = object;
+	s->dpt = dpt;
+}
+
+// check for update from EIB: record new value
+void check_trace_object (char* cp) {
+
+_O_TRACE_t*	p;
+_HISTORY_SLOT_t	*s;
+int32_t		value;
+uint32_t	now;
+uint32_t	dt;
+uint16_t	object;
+uint8_t		i;
+
+	p = (_O_TRACE_t*) cp;
+	object = p->eib_object_listen;
+	if (!eib_object_changed (object))
+		return;
+
+	value = eib_get_object_value (object, p->dpt);
+	s = history_find (object);
+	if (!s)
+		return;
+
+	now = NutGetSeconds ();
+	dt = now - s->raw_ring.time;
+	if (!s->raw_ring.count || (dt > 0xffff))
+		dt = 0xffff;
+
+	i = history_ring_add (&s->raw_ring, (uint8_t*) s->raw, sizeof (_HISTORY_SAMPLE_t), HISTORY_RAW_SAMPLES, value, now);
+	s->raw[i].dt = dt;
+
+	// short peaks between two ticks are part of min and max
+	history_acc_add (&s->minute_acc, value, value, value);
+}
+
+// down-sample all traced objects, call every second
+void history_tick (void) {
+
+_HISTORY_SLOT_t	*s;
+uint32_t	minute;
+int32_t		value;
+uint8_t		i;
+
+	minute = NutGetSeconds () / HISTORY_MINUTE_TIME;
+
+	for (i = 0; i < history_slots; i++) {
+		s = history_slot (i);
+		value = eib_get_object_value (s->object, s->dpt);
+
+		if ((minute != history_minute) && s->minute_acc.count) {
+			history_close_bucket (&s->minute_acc, &s->minute_ring, s->minute, HISTORY_MINUTE_BUCKETS,
+								  history_minute * HISTORY_MINUTE_TIME);
+			history_acc_add (&s->quarter_acc, s->minute_ring.last, s->minute_acc.min, s->minute_acc.max);
+
+			if (!(minute % HISTORY_QUARTER_MINUTES))
+				history_close_bucket (&s->quarter_acc, &s->quarter_ring, s->quarter, HISTORY_QUARTER_BUCKETS,
+									  (minute - HISTORY_QUARTER_MINUTES) * HISTORY_MINUTE_TIME);
+		}
+
+		// sample the value once per second, the average is weighted by time
+		history_acc_add (&s->minute_acc, value, value, value);
+	}
+
+	history_minute = minute;
+}
+
+// get the newest values of a tier, oldest first
+// object: traced object
+// tier: HISTORY_TIER_xxx
+// values: buffer for max values
+// Returns the number of values.
+uint8_t history_query (uint16_t object, uint8_t tier, _HISTORY_VALUE_t *values, uint8_t max) {
+
+_HISTORY_SLOT_t	*s;
+_HISTORY_RING_t	*ring;
+_HISTORY_BUCKET_t	*buckets;
+uint8_t		*entries;
+uint8_t		entry_size;
+uint8_t		size;
+uint16_t	interval;
+int32_t		v;
+uint32_t	t;
+uint8_t		n, k, i, j;
+
+	s = history_find (object);
+	if (!s)
+		return 0;
+
+	switch (tier) {
+		case HISTORY_TIER_RAW:
+			ring = &s->raw_ring;
+			entries = (uint8_t*) s->raw;
+			entry_size = sizeof (_HISTORY_SAMPLE_t);
+			size = HISTORY_RAW_SAMPLES;
+			interval = 0;
+		break;
+		case HISTORY_TIER_MINUTE:
+			ring = &s->minute_ring;
+			entries = (uint8_t*) s->minute;
+			entry_size = sizeof (_HISTORY_BUCKET_t);
+			size = HISTORY_MINUTE_BUCKETS;
+			interval = HISTORY_MINUTE_TIME;
+		break;
+		case HISTORY_TIER_QUARTER:
+			ring = &s->quarter_ring;
+			entries = (uint8_t*) s->quarter;
+			entry_size = sizeof (_HISTORY_BUCKET_t);
+			size = HISTORY_QUARTER_BUCKETS;
+			interval = HISTORY_QUARTER_MINUTES * HISTORY_MINUTE_TIME;
+		break;
+		default:
+			return 0;
+	}
+
+	n = min (ring->count, max);
+	buckets = (_HISTORY_BUCKET_t*) entries;
+	v = ring->base;
+	t = 0;
+	// walk from the oldest entry, the deltas accumulate
+	for (k = 0, j = 0; k < ring->count; k++) {
+		i = (ring->first + k) % size;
+		if (k) {
+			v += HISTORY_DELTA(entries, entry_size, i);
+			if (!interval)
+				t += ((_HISTORY_SAMPLE_t*) entries)[i].dt;
+		}
+		if (k < ring->count - n)
+			continue;
+
+		values[j].avg = v;
+		if (interval) {
+			values[j].min = v - history_decode_spread (buckets[i].below);
+			values[j].max = v + history_decode_spread (buckets[i].above);
+			values[j].time = ring->time - (uint32_t) (ring->count -1 - k) * interval;
+		}
+		else {
+			values[j].min = v;
+			values[j].max = v;
+			values[j].time = t;
+		}
+		j++;
+	}
+
+	// sample times are relative to the oldest sample, the newest has ring->time
+	if (!interval)
+		for (j = 0; j < n; j++)
+			values[j].time += ring->time - t;
+
+	return n;
+}
+
+#endif // HISTORY_SUPPORT
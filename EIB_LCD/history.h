@@ -0,0 +1,121 @@
+/** \file history.h
+ *  \brief Constants and definitions for the object value history
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include "System.h"
+
+// listen element of type LISTEN_ELEMENT_TRACE selects an object for the history
+typedef struct __attribute__ ((packed)) {
+uint8_t		element_size;
+uint8_t		element_type;
+uint16_t	eib_object_listen;
+uint8_t		dpt;
+} _O_TRACE_t;
+
+// history tiers
+#define HISTORY_TIER_RAW		0	// received values
+#define HISTORY_TIER_MINUTE		1	// 1 minute buckets
+#define HISTORY_TIER_QUARTER	2	// 15 minute buckets
+
+#define HISTORY_RAW_SAMPLES		16
+#define HISTORY_MINUTE_BUCKETS	60	// 1h
+#define HISTORY_QUARTER_BUCKETS	96	// 24h
+#define HISTORY_MINUTE_TIME		60
+#define HISTORY_QUARTER_MINUTES	15
+
+/**
+* @brief received value, delta encoded to the previous sample
+*/
+typedef struct __attribute__ ((packed)) {
+int16_t		dv;			// value change since the previous sample
+uint16_t	dt;			// time since the previous sample in s
+} _HISTORY_SAMPLE_t;
+
+/**
+* @brief down-sampled bucket, the average is delta encoded to the previous bucket
+*
+* The distance of min. and max. to the average is stored as 4 bit exponent
+* and 4 bit mantissa, rounded up.
+*/
+typedef struct __attribute__ ((packed)) {
+int16_t		davg;
+uint8_t		below;
+uint8_t		above;
+} _HISTORY_BUCKET_t;
+
+/**
+* @brief ring buffer state, base is the value of the oldest entry
+*
+* The delta to the previous entry is the first element of samples and buckets.
+*/
+typedef struct __attribute__ ((packed)) {
+int32_t		base;
+int32_t		last;		// value of the newest entry
+uint32_t	time;		// time of the newest entry
+uint8_t		first;
+uint8_t		count;
+} _HISTORY_RING_t;
+
+/**
+* @brief value accumulator of the running bucket
+*/
+typedef struct __attribute__ ((packed)) {
+int32_t		ref;		// first value of the bucket
+int32_t		min;
+int32_t		max;
+int32_t		sum;		// sum of the differences to ref
+uint8_t		count;
+} _HISTORY_ACC_t;
+
+/**
+* @brief history of one object
+*/
+typedef struct __attribute__ ((packed)) {
+uint16_t			object;
+uint8_t				dpt;
+_HISTORY_ACC_t		minute_acc;
+_HISTORY_ACC_t		quarter_acc;
+_HISTORY_RING_t		raw_ring;
+_HISTORY_RING_t		minute_ring;
+_HISTORY_RING_t		quarter_ring;
+_HISTORY_SAMPLE_t	raw[HISTORY_RAW_SAMPLES];
+_HISTORY_BUCKET_t	minute[HISTORY_MINUTE_BUCKETS];
+_HISTORY_BUCKET_t	quarter[HISTORY_QUARTER_BUCKETS];
+} _HISTORY_SLOT_t;
+
+// slots do not cross XRAM banks
+#define HISTORY_SLOTS_PER_BANK	(XRAM_BANK_SIZE / sizeof (_HISTORY_SLOT_t))
+#define HISTORY_MAX_SLOTS		(XRAM_HISTORY_BANKS * HISTORY_SLOTS_PER_BANK)
+
+/**
+* @brief query result: value range of a bucket or a single sample
+*/
+typedef struct {
+uint32_t	time;		// start of the bucket or time of the sample
+int32_t		min;
+int32_t		max;
+int32_t		avg;
+} _HISTORY_VALUE_t;
+
+// forget all traced objects
+void history_init (void);
+// init trace element: add object to the history
+void init_trace_object (char*);
+// check for update from EIB
+void check_trace_object (char*);
+// down-sample all traced objects, call every second
+void history_tick (void);
+// get the newest values of a tier, oldest first
+uint8_t history_query (uint16_t, uint8_t, _HISTORY_VALUE_t*, uint8_t);
+
+#endif // _HISTORY_H_
@@ -17,10 +17,10 @@
 void ir_button_pressed (char *cp, uint8_t evt) {
 
 _IR_BUTTON_t*	p;
-uint8_t		eib_object;
+uint16_t	eib_object;
 uint8_t		eib_value[2];
 int			new_value;
-float		fval;
+int32_t		value;
 
 	p = (_IR_BUTTON_t*) cp;
 	
@@ -37,13 +37,13 @@ float		fval;
 			case EIB_BUTTON_FUNCTION_DARKER:
 				// dimm stop
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_ON_BRIGHTER:
 			case EIB_BUTTON_FUNCTION_OFF_DARKER:
 				// dimm stop
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object1), eib_value, 0);
 			break;
 		}
 	}
@@ -56,17 +56,17 @@ float		fval;
 			case EIB_BUTTON_FUNCTION_DARKER:
 				// dimm stop
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_ON_BRIGHTER:
 				// switch on
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_OFF_DARKER:
 				// switch off
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 		}
 	}
@@ -76,22 +76,22 @@ float		fval;
 			case EIB_BUTTON_FUNCTION_ON_BRIGHTER:
 				// dimm up
 				eib_value[0] = 0x09;
-				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object1), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_OFF_DARKER:
 				// dimm down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object1), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_UP_STEPUP:
 				// go up
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_DOWN_STEPDOWN:
 				// go down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 		}
 	}
@@ -101,18 +101,17 @@ float		fval;
 			case EIB_BUTTON_FUNCTION_STEPUP:
 				// go up
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_STEPDOWN:
 				// go down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_DELTA_EIS6:
 				// add delta value to 8bit object and send it
 				eib_object = p->eib_object0;
 				eib_value[0] = eib_get_object_8_value (p->eib_object0);
-				XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
 				new_value = eib_value[0] + (int8_t) p->value[0];
 /*				if (new_value < p->min) { 
 					new_value = p->min;
@@ -127,31 +126,29 @@ float		fval;
 					new_value = 255;
 				}
 				eib_value[0] = new_value & 0xff;
-				eib_G_DATA_request(get_group_address(eib_object), eib_value, 1);
+				eib_G_DATA_request(get_object_send_address (eib_object), eib_value, 1);
 			break;
 			case EIB_BUTTON_FUNCTION_DELTA_EIS5:
 				// add delta value to 16bit EIS5 object and send it
 				eib_object = p->eib_object0;
-				fval = eib_get_object_EIS5_value (eib_object);
-				XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
-				fval += (float) ((int8_t) p->value[0])/10;
+				value = eib_get_object_value (eib_object, DPT_9);
+				// delta value is given in 1/10
+				value += 10 * (int8_t) p->value[0];
 				// check, if the new value is inside of the bounds
-/*				if (10*fval < p->min) { 
-					fval = p->min;
-					fval /= 10;
+/*				if (value < 10L*p->min) { 
+					value = 10L*p->min;
 				}
-				if (10*fval > p->max) { 
-					fval = p->max;
-					fval /= 10;
+				if (value > 10L*p->max) { 
+					value = 10L*p->max;
 				} */
-				if (fval < -100.0) { 
-					fval = -100.0;
+				if (value < -100*DPT_CENTI_SCALE) { 
+					value = -100*DPT_CENTI_SCALE;
 				}
-				if (fval > 100.0) { 
-					fval = 100.0;
+				if (value > 100*DPT_CENTI_SCALE) { 
+					value = 100*DPT_CENTI_SCALE;
 				}
 				// send new value as EIS5
-				eib_set_object_EIS5_value(get_group_address(eib_object), fval);
+				eib_set_object_value (get_object_send_address (eib_object), DPT_9, value);
 			break;
 		}
 	}
@@ -164,66 +161,65 @@ float		fval;
 					eib_value[0] = 0x00;
 				else
 					eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (eib_object), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_ON:
 				// switch on
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_OFF:
 				// switch off
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_BRIGHTER:
 				// dimm up
 				eib_value[0] = 0x09;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_DARKER:
 				// dimm down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_UP:
 			case EIB_BUTTON_FUNCTION_STEPUP:
 				// go up
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_DOWN:
 			case EIB_BUTTON_FUNCTION_STEPDOWN:
 				// go down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object0), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_UP_STEPUP:
 				// go up
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object1), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_DOWN_STEPDOWN:
 				// go down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+				eib_G_DATA_request(get_object_send_address (p->eib_object1), eib_value, 0);
 			break;
 			case EIB_BUTTON_FUNCTION_8BIT_VALUE:
 				eib_object = p->eib_object0;
 				eib_value[0] = p->value[0];
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 1);
+				eib_G_DATA_request(get_object_send_address (eib_object), eib_value, 1);
 			break;
 			case EIB_BUTTON_FUNCTION_16BIT_VALUE:
 				eib_object = p->eib_object0;
 				eib_value[0] = p->value[1];
 				eib_value[1] = p->value[0];
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 2);
+				eib_G_DATA_request(get_object_send_address (eib_object), eib_value, 2);
 			break;
 			case EIB_BUTTON_FUNCTION_DELTA_EIS6:
 				// add delta value to 8bit object and send it
 				eib_object = p->eib_object0;
 				eib_value[0] = eib_get_object_8_value (p->eib_object0);
-				XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
 				new_value = eib_value[0] + (int8_t) p->value[0];
 /*				if (new_value < p->min) { 
 					new_value = p->min;
@@ -238,31 +234,29 @@ float		fval;
 					new_value = 255;
 				}
 				eib_value[0] = new_value & 0xff;
-				eib_G_DATA_request(get_group_address(eib_object), eib_value, 1);
+				eib_G_DATA_request(get_object_send_address (eib_object), eib_value, 1);
 			break;
 			case EIB_BUTTON_FUNCTION_DELTA_EIS5:
 				// add delta value to 16bit EIS5 object and send it
 				eib_object = p->eib_object0;
-				fval = eib_get_object_EIS5_value (eib_object);
-				XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
-				fval += (float) ((int8_t) p->value[0])/10;
+				value = eib_get_object_value (eib_object, DPT_9);
+				// delta value is given in 1/10
+				value += 10 * (int8_t) p->value[0];
 				// check, if the new value is inside of the bounds
-/*				if (10*fval < p->min) { 
-					fval = p->min;
-					fval /= 10;
+/*				if (value < 10L*p->min) { 
+					value = 10L*p->min;
 				}
-				if (10*fval > p->max) { 
-					fval = p->max;
-					fval /= 10;
+				if (value > 10L*p->max) { 
+					value = 10L*p->max;
 				} */
-				if (fval < -100.0) { 
-					fval = -100.0;
+				if (value < -100*DPT_CENTI_SCALE) { 
+					value = -100*DPT_CENTI_SCALE;
 				}
-				if (fval > 100.0) { 
-					fval = 100.0;
+				if (value > 100*DPT_CENTI_SCALE) { 
+					value = 100*DPT_CENTI_SCALE;
 				}
 				// send new value as EIS5
-				eib_set_object_EIS5_value(get_group_address(eib_object), fval);
+				eib_set_object_value (get_object_send_address (eib_object), DPT_9, value);
 			break;
 		}
 	}
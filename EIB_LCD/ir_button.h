@@ -22,8 +22,8 @@ uint8_t		hardware_id;
 uint8_t		rc5_address;
 uint8_t		rc5_command;
 uint8_t		eib_function;
-uint8_t		eib_object0;
-uint8_t		eib_object1;
+uint16_t	eib_object0;
+uint16_t	eib_object1;
 uint8_t		value[2];
 } _IR_BUTTON_t;
 
@@ -19,95 +19,212 @@
 #include "o_led.h"
 #include "o_warning.h"
 #include "o_timeout.h"
+#include "history.h"
 
 uint8_t listen_descriptions_validated;
+// listen element descriptions in XRAM
+xram_far_t listen_descriptions;
+// bank of the listen element in process
+uint8_t listen_bank;
 volatile uint8_t listen_objects_timer;
 volatile uint8_t listen_objects_timer_1s;
 volatile uint8_t listen_objects_timer_flags;
 
 // moves listening elements descriptions from Flash into RAM. Purpose is fast and easy access to Bytes.
+// The descriptions may span several banks, elements never cross a bank border.
 // flash offset: start address in Flash
 // size: size of page descriptions in Byte
 uint8_t move_listen_descriptions (uint32_t flash_offset, uint32_t size) {
 
-uint8_t checksum;
-uint16_t i;
+_XRAM_LOADER_t	ld;
+uint8_t		banks;
+uint8_t		bank;
+uint8_t		result;
 
+	listen_descriptions_validated = 0;
 
-	// we can only handle sizes up to one XRAM page
-	if (size > XRAM_BANK_SIZE)
+	// elements of older project files grow while they are converted
+	banks = xram_section_banks ((lcd_file_version == LCD_VERSION_COMPAT) ? 2*size : size);
+	bank = xram_alloc (banks);
+	if (!bank)
 		return 2;
+	listen_descriptions = XRAM_FAR(bank, 0);
 
-	// move page descriptions from Flash into XRAM
-	copy_Flash_to_XRAM ((flash_offset >> 16) & 0xff, flash_offset & 0xffff, XRAM_LISTEN_ELEMENTS_ADDR, size);
-
-	checksum = 0;
-	// validate checksum in XRAM
-	for (i = 0; i < size; i++) {
-		checksum ^= INB (XRAM_BASE_ADDRESS + i);
+	if (lcd_file_version == LCD_VERSION_COMPAT) {
+		result = compat_convert_listen (flash_offset, size, bank, banks);
+		if (result)
+			return result;
+	}
+	else {
+		xram_loader_init (&ld, bank, banks, flash_offset);
+		if (xram_load_block (&ld, sizeof (_LISTEN_DESCRIPTOR_t)))
+			return 2;
+		result = xram_load_elements (&ld, ((_LISTEN_DESCRIPTOR_t*) xram_far_select (listen_descriptions))->element_count);
+		if (result)
+			return result;
+		if (xram_loader_verify (&ld, size))
+			return 1;
 	}
-
-	if (checksum)
-		return 1;
 
 	listen_descriptions_validated = 1;
 
 	return 0;
 }
 
+// get object of a listen element, which handles group messages
+// returns 0, if the element does not handle group messages
+static uint8_t listen_element_object (char* p, uint16_t *object) {
+
+	switch (((_LISTEN_ELEMENT_t*) p)->element_type) {
+		case LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE:
+		case LISTEN_ELEMENT_TYPE_BACKLIGHT_ACTIVE:
+			*object = ((_O_BACKLIGHT_t*) p)->eib_object_listen;
+			return 1;
+		case LISTEN_ELEMENT_TYPE_WARNING:
+			*object = ((_O_WARNING_t*) p)->warning_object_id;
+			return 1;
+		case LISTEN_ELEMENT_TIMEOUT:
+			*object = ((_O_TIMEOUT_t*) p)->eib_object_listen;
+			return 1;
+#ifdef HISTORY_SUPPORT
+		case LISTEN_ELEMENT_TRACE:
+			*object = ((_O_TRACE_t*) p)->eib_object_listen;
+			return 1;
+#endif
+	}
+	return 0;
+}
+
+// start iterating the listen elements
+void listen_iterator_init (_XRAM_ITERATOR_t *it) {
+
+	if (!listen_descriptions_validated) {
+		xram_iterator_init (it, &listen_bank, 0, 0);
+		return;
+	}
+	xram_iterator_init (it, &listen_bank, listen_descriptions + sizeof (_LISTEN_DESCRIPTOR_t),
+						((_LISTEN_DESCRIPTOR_t*) xram_far_select (listen_descriptions))->element_count);
+}
+
 /**
-* @brief processes a new group message received from the EIB
+* @brief builds the registry of listen elements for each object
 *
+* The registry is stored like a compressed sparse row matrix: the index table
+* holds the first handler of each object, the handler table holds the offsets
+* of the listen elements. The handlers of object n are
+* handler[index[n]] ... handler[index[n+1]-1].
 */
-void lcd_listen_process_msg (uint16_t address) {
+static void listen_build_registry (void) {
 
+_XRAM_ITERATOR_t	it;
 char* p;
-_LISTEN_ELEMENT_t	*listen_element;
-uint8_t	element_count;
+uint16_t *index;
+uint16_t *handler;
+uint16_t	object;
 int i;
-int	eib_object;
 
-	if (flash_content_bad)
-		return;
+	XRAM_SELECT_BLOCK(XRAM_LISTEN_REGISTRY_PAGE);
+	index = (uint16_t*) (XRAM_BASE_ADDRESS + LISTEN_REGISTRY_INDEX);
+	handler = (uint16_t*) (XRAM_BASE_ADDRESS + LISTEN_REGISTRY_HANDLER);
+	for (i = 0; i <= EIB_MAX_OBJECTS; i++)
+		index[i] = 0;
+
+	// count the handlers of each object
+	listen_iterator_init (&it);
+	while ((p = xram_iterator_next (&it))) {
+		if (listen_element_object (p, &object) && (object < EIB_MAX_OBJECTS)) {
+			XRAM_SELECT_BLOCK(XRAM_LISTEN_REGISTRY_PAGE);
+			index[object +1]++;
+		}
+	}
 
-	eib_object = get_group_adress_index (address);
-	if (eib_object < 0)
-		return;
+	// index of the first handler of each object
+	XRAM_SELECT_BLOCK(XRAM_LISTEN_REGISTRY_PAGE);
+	for (i = 1; i <= EIB_MAX_OBJECTS; i++)
+		index[i] += index[i-1];
+
+	// store the handlers, index[n] is moved to the end of the handlers of object n
+	listen_iterator_init (&it);
+	while ((p = xram_iterator_next (&it))) {
+		if (listen_element_object (p, &object) && (object < EIB_MAX_OBJECTS)) {
+			XRAM_SELECT_BLOCK(XRAM_LISTEN_REGISTRY_PAGE);
+			handler[index[object]++] = XRAM_FAR(listen_bank, (uint16_t) (p - (char*) XRAM_BASE_ADDRESS)) - listen_descriptions;
+		}
+	}
 
-	// poll all components of active page and check, if they match the eib address
-	// set page descriptions bank
-	XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-	p = (char*)XRAM_BASE_ADDRESS;
-	element_count = ((_LISTEN_DESCRIPTOR_t*) p)->element_count;
-	p += sizeof (_LISTEN_DESCRIPTOR_t);
+	// restore the index of the first handler
+	XRAM_SELECT_BLOCK(XRAM_LISTEN_REGISTRY_PAGE);
+	for (i = EIB_MAX_OBJECTS; i > 0; i--)
+		index[i] = index[i-1];
+	index[0] = 0;
+}
 
-	// iterate all listening elements
-	for (i = 0; i < element_count; i++) {
-		listen_element = (_LISTEN_ELEMENT_t*) p;
+// get the handlers of an object from the registry
+// returns the number of handlers
+static uint16_t listen_get_handlers (uint16_t object, uint16_t *first) {
 
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
+uint16_t *index;
+uint16_t count;
 
-		switch (listen_element->element_type) {
-			case LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE:
-			case LISTEN_ELEMENT_TYPE_BACKLIGHT_ACTIVE:
-				check_backlight_object (p, eib_object);
-			break;
-			case LISTEN_ELEMENT_TYPE_LED:
-			break;
-			case LISTEN_ELEMENT_TYPE_WARNING:
-				check_warning_object (p, eib_object);
-			break;
-			case LISTEN_ELEMENT_TIMEOUT:
-				check_timeout_object (p, eib_object);
-			break;
-#ifdef LCD_DEBUG
-			default: printf_P (PSTR("%s():%d unknown listen element %d\n"), __FUNCTION__, __LINE__, listen_element->element_type);
+	XRAM_SELECT_BLOCK(XRAM_LISTEN_REGISTRY_PAGE);
+	index = (uint16_t*) (XRAM_BASE_ADDRESS + LISTEN_REGISTRY_INDEX);
+	*first = index[object];
+	count = index[object +1] - index[object];
+	return count;
+}
+
+// get a listen element from the registry, its bank is selected
+static char* listen_get_handler (uint16_t h) {
+
+uint16_t offset;
+
+	XRAM_SELECT_BLOCK(XRAM_LISTEN_REGISTRY_PAGE);
+	offset = ((uint16_t*) (XRAM_BASE_ADDRESS + LISTEN_REGISTRY_HANDLER))[h];
+	listen_bank = XRAM_FAR_BANK(listen_descriptions + offset);
+	return xram_far_select (listen_descriptions + offset);
+}
+
+/**
+* @brief processes a new group message received from the EIB
+*
+* Only the listen elements registered for the addressed objects are called.
+*/
+void lcd_listen_process_msg (void) {
+
+char* p;
+uint16_t *objects;
+uint8_t	object_count;
+uint16_t h;
+uint16_t count;
+uint8_t	i;
+
+	if (flash_content_bad)
+		return;
+
+	object_count = eib_get_msg_objects (&objects);
+	for (i = 0; i < object_count; i++) {
+		count = listen_get_handlers (objects[i], &h);
+		for (; count; count--, h++) {
+			p = listen_get_handler (h);
+
+			switch (((_LISTEN_ELEMENT_t*) p)->element_type) {
+				case LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE:
+				case LISTEN_ELEMENT_TYPE_BACKLIGHT_ACTIVE:
+					check_backlight_object (p);
+				break;
+				case LISTEN_ELEMENT_TYPE_WARNING:
+					check_warning_object (p);
+				break;
+				case LISTEN_ELEMENT_TIMEOUT:
+					check_timeout_object (p);
+				break;
+#ifdef HISTORY_SUPPORT
+				case LISTEN_ELEMENT_TRACE:
+					check_trace_object (p);
+				break;
 #endif
+			}
 		}
-
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-		p += listen_element->element_size;
 	}
 }
 
@@ -118,27 +235,25 @@ int	eib_object;
 void lcd_init_listen_objects (void) {
 
 char* p;
+_XRAM_ITERATOR_t	it;
 _LISTEN_ELEMENT_t	*listen_element;
-uint8_t	element_count;
-int i;
 
 	if (flash_content_bad)
 		return;
 
-	// poll all listen components and check, if they need hardware setup
-	// set page descriptions bank
-	XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-	p = (char*)XRAM_BASE_ADDRESS;
-	element_count = ((_LISTEN_DESCRIPTOR_t*) p)->element_count;
-	p += sizeof (_LISTEN_DESCRIPTOR_t);
+	// register listen elements for their objects
+	listen_build_registry ();
+#ifdef HISTORY_SUPPORT
+	// forget traced objects of previous project
+	history_init ();
+#endif
 
+	// poll all listen components and check, if they need hardware setup
 	// iterate all listening elements
-	for (i = 0; i < element_count; i++) {
+	listen_iterator_init (&it);
+	while ((p = xram_iterator_next (&it))) {
 		listen_element = (_LISTEN_ELEMENT_t*) p;
 
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-
 		switch (listen_element->element_type) {
 
 			case LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE:
@@ -154,13 +269,15 @@ int i;
 			case LISTEN_ELEMENT_TIMEOUT:
 				init_timeout_object (p);
 			break;
+#ifdef HISTORY_SUPPORT
+			case LISTEN_ELEMENT_TRACE:
+				init_trace_object (p);
+			break;
+#endif
 #ifdef LCD_DEBUG
 			default: printf_P (PSTR("%s():%d unknown listen element %d\n"), __FUNCTION__, __LINE__, listen_element->element_type);
 #endif
 		}
-
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-		p += listen_element->element_size;
 	}
 
 	listen_objects_timer = 0;
@@ -170,44 +287,33 @@ int i;
 
 
 // get timeout counter value
-uint16_t lcd_get_timeout_counter (uint8_t eib_object) {
+// the bank of the caller is kept
+uint16_t lcd_get_timeout_counter (uint16_t eib_object) {
 
 char* p;
-_LISTEN_ELEMENT_t	*listen_element;
-uint8_t	element_count;
-int i;
-uint16_t val = 0;
-
-	// poll all components of active page and check, if they match the eib address
-	// set page descriptions bank
-	XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-	p = (char*)XRAM_BASE_ADDRESS;
-	element_count = ((_LISTEN_DESCRIPTOR_t*) p)->element_count;
-	p += sizeof (_LISTEN_DESCRIPTOR_t);
-
-	// iterate all listening elements
-	for (i = 0; i < element_count; i++) {
-		listen_element = (_LISTEN_ELEMENT_t*) p;
-
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-
-		switch (listen_element->element_type) {
-			case LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE:
-			case LISTEN_ELEMENT_TYPE_BACKLIGHT_ACTIVE:
-			case LISTEN_ELEMENT_TYPE_LED:
-			break;
-			case LISTEN_ELEMENT_TIMEOUT:
-				if (get_timeout_object_counter (p, eib_object, &val))
-					return val;
-			break;
-		}
+uint16_t h;
+uint16_t count;
+uint16_t val;
+uint8_t	save_xram_page;
+uint8_t	save_listen_bank;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	save_listen_bank = listen_bank;
+
+	// only the listen elements registered for the object
+	// should never fail:
+	val = 0xffff;
+	count = listen_get_handlers (eib_object, &h);
+	for (; count; count--, h++) {
+		p = listen_get_handler (h);
+		if (((_LISTEN_ELEMENT_t*) p)->element_type == LISTEN_ELEMENT_TIMEOUT)
+			if (get_timeout_object_counter (p, eib_object, &val))
+				break;
+	}
 
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-		p += listen_element->element_size;
-	}
-	// should never happen:
-	return 0xffff;
+	listen_bank = save_listen_bank;
+	XRAM_SELECT_BLOCK(save_xram_page);
+	return val;
 }
 
 
@@ -219,9 +325,8 @@ uint16_t val = 0;
 void lcd_listen_timer_event () {
 
 char* p;
+_XRAM_ITERATOR_t	it;
 _LISTEN_ELEMENT_t	*listen_element;
-uint8_t	element_count;
-int i;
 
 	if (flash_content_bad)
 		return;
@@ -236,20 +341,18 @@ int i;
 		listen_objects_timer_1s = 0;
 	}
 
-	// poll all components of active page and check, if they match the eib address
-	// set page descriptions bank
-	XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-	p = (char*)XRAM_BASE_ADDRESS;
-	element_count = ((_LISTEN_DESCRIPTOR_t*) p)->element_count;
-	p += sizeof (_LISTEN_DESCRIPTOR_t);
+#ifdef HISTORY_SUPPORT
+	// down-sample traced objects
+	if (!listen_objects_timer_1s)
+		history_tick ();
+#endif
 
+	// poll all components of active page and check, if they match the eib address
 	// iterate all listening elements
-	for (i = 0; i < element_count; i++) {
+	listen_iterator_init (&it);
+	while ((p = xram_iterator_next (&it))) {
 		listen_element = (_LISTEN_ELEMENT_t*) p;
 
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-
 		switch (listen_element->element_type) {
 			case LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE:
 			case LISTEN_ELEMENT_TYPE_BACKLIGHT_ACTIVE:
@@ -262,9 +365,6 @@ int i;
 					tick_timeout_object (p);
 			break;
 		}
-
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-		p += listen_element->element_size;
 	}
 }
 
@@ -19,7 +19,7 @@
 #include "MemoryMap.h"
 
 typedef struct __attribute__ ((packed)) {
-uint8_t		element_count;
+uint16_t	element_count;
 uint8_t		checksum;
 } _LISTEN_DESCRIPTOR_t;
 
@@ -35,6 +35,10 @@ uint8_t		element_type;
 #define LISTEN_ELEMENT_TIMEOUT					4
 #define LISTEN_ELEMENT_TRACE					5
 
+// registry of listen elements for each object in XRAM_LISTEN_REGISTRY_PAGE
+#define LISTEN_REGISTRY_INDEX		0x0000	// uint16_t first handler of each object, EIB_MAX_OBJECTS+1 entries
+#define LISTEN_REGISTRY_HANDLER		(LISTEN_REGISTRY_INDEX + 2*(EIB_MAX_OBJECTS+1))	// uint16_t offset of listen element in the descriptions
+
 // divider for 30ms -> 120ms
 #define LISTEN_OBJECTS_TIMER_MAX				4
 // divider for 30ms -> 1.33sec
@@ -43,10 +47,16 @@ uint8_t		element_type;
 // moves the page descriptions from Flash into RAM
 // returns 0 if ok
 // returns 1 on checksum error
+// returns 2 if there are not enough XRAM banks
 uint8_t move_listen_descriptions (uint32_t, uint32_t);
 
-// check page on EIB event
-void lcd_listen_process_msg (uint16_t);
+// bank of the listen element in process
+extern uint8_t listen_bank;
+// start iterating the listen elements
+void listen_iterator_init (_XRAM_ITERATOR_t*);
+
+// check listen elements on EIB event
+void lcd_listen_process_msg (void);
 
 // process new timer event
 void lcd_listen_timer_event (void);
@@ -19,7 +19,7 @@
 #include "o_backlight.h"
 #include "System.h"
 
-void check_backlight_object (char* cp, int obj) {
+void check_backlight_object (char* cp) {
 
 _O_BACKLIGHT_t*	p;
 uint8_t			eib_value;
@@ -29,10 +29,9 @@ uint8_t			eib_value;
 	if (!(p->parameter & BACKLIGHT_PARAMETER_LISTEN))
 		return;
 
-	if (p->eib_object_listen == obj) {
+	if (eib_object_addressed (p->eib_object_listen)) {
 		// set new value
 		eib_value = eib_get_object_8_value (p->eib_object_listen);
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
 
 		if (p->element_type == LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE) {
 
@@ -18,14 +18,14 @@ typedef struct __attribute__ ((packed)) {
 uint8_t		element_size;
 uint8_t		element_type;
 uint8_t		default_value;
-uint8_t		eib_object_listen;
+uint16_t	eib_object_listen;
 // d0: 1=listen
 uint8_t		parameter;
 } _O_BACKLIGHT_t;
 #define BACKLIGHT_PARAMETER_LISTEN 		0x01
 
 // check for update from EIB
-void check_backlight_object (char*, int);
+void check_backlight_object (char*);
 
 // init object
 void init_backlight_object (char*);
@@ -58,7 +58,7 @@ uint8_t get_input_value (uint8_t id) {
 /** do_hardware_button ( EIB object ID, function code)
  *  Executes the button function "function code" for the EIB object "EIB object ID"
  */
-void do_hardware_button (uint8_t obj, uint8_t fct) {
+void do_hardware_button (uint16_t obj, uint8_t fct) {
 
 uint8_t eib_value;
 
@@ -71,17 +71,17 @@ uint8_t eib_value;
 			else 
 				eib_value = 1;
 			// send value
-			eib_G_DATA_request(get_group_address (obj), &eib_value, 0);
+			eib_G_DATA_request(get_object_send_address (obj), &eib_value, 0);
 		break;
 		case HARDWARE_BUTTON_SEND_0:
 		case HARDWARE_BUTTON_REPEAT_SEND_0:
 			eib_value = 0;
-			eib_G_DATA_request(get_group_address (obj), &eib_value, 0);
+			eib_G_DATA_request(get_object_send_address (obj), &eib_value, 0);
 		break;
 		case HARDWARE_BUTTON_SEND_1:
 		case HARDWARE_BUTTON_REPEAT_SEND_1:
 			eib_value = 1;
-			eib_G_DATA_request(get_group_address (obj), &eib_value, 0);
+			eib_G_DATA_request(get_object_send_address (obj), &eib_value, 0);
 		break;
 	}
 
@@ -90,17 +90,17 @@ uint8_t eib_value;
 /** do_hardware_button_repeat ( EIB object ID, function code)
  *  This function repeats the button function "function code" for the EIB object "EIB object ID"
  */
-void do_hardware_button_repeat (uint8_t obj, uint8_t fct) {
+void do_hardware_button_repeat (uint16_t obj, uint8_t fct) {
 uint8_t eib_value;
 
 	switch (fct & 0x07) {
 		case HARDWARE_BUTTON_REPEAT_SEND_0:
 			eib_value = 0;
-			eib_G_DATA_request(get_group_address (obj), &eib_value, 0);
+			eib_G_DATA_request(get_object_send_address (obj), &eib_value, 0);
 		break;
 		case HARDWARE_BUTTON_REPEAT_SEND_1:
 			eib_value = 1;
-			eib_G_DATA_request(get_group_address (obj), &eib_value, 0);
+			eib_G_DATA_request(get_object_send_address (obj), &eib_value, 0);
 		break;
 	}
 }
@@ -142,7 +142,6 @@ _O_BUTTON_t*	p;
 
 		secound_counter = 0;
 
-		XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);
 		// check, if cyclic message should be sent
 		if ((p->state & 0x7f) < 0x7f)
 			p->state++;
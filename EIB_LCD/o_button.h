@@ -18,7 +18,7 @@ typedef struct __attribute__ ((packed)) {
 uint8_t		element_size;
 uint8_t		element_type;
 uint8_t		hw_object_id;
-uint8_t		eib_object_send;
+uint16_t	eib_object_send;
 uint8_t		function;
 uint8_t		interval;
 // space for object variables
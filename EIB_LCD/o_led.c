@@ -30,7 +30,6 @@ uint8_t			eib_value;
 
 	// get new value
 	eib_value = eib_get_object_8_value (p->eib_object_listen);
-	XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
 
 	// get led output value for led state
 uint8_t lc; // led config
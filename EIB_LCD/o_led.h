@@ -18,7 +18,7 @@ typedef struct __attribute__ ((packed)) {
 uint8_t		element_size;
 uint8_t		element_type;
 uint8_t		hw_object_id;
-uint8_t		eib_object_listen;
+uint16_t	eib_object_listen;
 // Parameter: d5, d4: Flash frequency, d3, d2: state@1, d1, d0: state@0
 uint8_t		parameter;
 } _O_LED_t;
@@ -19,13 +19,13 @@
 #include "o_timeout.h"
 #include "System.h"
 
-void check_timeout_object (char* cp, uint8_t obj) {
+void check_timeout_object (char* cp) {
 
 _O_TIMEOUT_t*	p;
 
 	p = (_O_TIMEOUT_t*) cp;
 
-	if (p->eib_object_listen == obj) {
+	if (eib_object_addressed (p->eib_object_listen)) {
 		// clear counter
 		p->timeout_counter = 0;
 	}
@@ -56,7 +56,7 @@ _O_TIMEOUT_t*	p;
 }
 
 // get object timeout counter
-uint8_t get_timeout_object_counter (char* cp, uint8_t obj, uint16_t *val) {
+uint8_t get_timeout_object_counter (char* cp, uint16_t obj, uint16_t *val) {
 
 _O_TIMEOUT_t*	p;
 
@@ -17,17 +17,17 @@
 typedef struct __attribute__ ((packed)) {
 uint8_t		element_size;
 uint8_t		element_type;
-uint8_t		eib_object_listen;
+uint16_t	eib_object_listen;
 uint16_t	timeout_counter;
 } _O_TIMEOUT_t;
 
 // check for update from EIB
-void check_timeout_object (char*, uint8_t);
+void check_timeout_object (char*);
 // init object
 void init_timeout_object (char*);
 // trigger timer with 1sec interval
 void tick_timeout_object (char*);
 // get timeout counter value
-uint8_t get_timeout_object_counter (char*, uint8_t, uint16_t*);
+uint8_t get_timeout_object_counter (char*, uint16_t, uint16_t*);
 	
 #endif // _O_TIMEOUT_H_
@@ -18,17 +18,16 @@
 #include "o_warning.h"
 #include "System.h"
 
-void check_warning_object (char* cp, uint8_t obj) {
+void check_warning_object (char* cp) {
 
 _O_WARNING_t*	p;
 uint8_t		eib_value;
 
 	p = (_O_WARNING_t*) cp;
 
-	if (p->warning_object_id == obj) {
+	if (eib_object_addressed (p->warning_object_id)) {
 		// get new value
 		eib_value = eib_get_object_8_value (p->warning_object_id);
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
 
 		if (eib_value) {
 			if (get_active_page() != p->destination_page)
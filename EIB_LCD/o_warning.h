@@ -20,12 +20,12 @@
 typedef struct __attribute__ ((packed)) {
 uint8_t		element_size;
 uint8_t		element_type;
-uint8_t		warning_object_id;
+uint16_t	warning_object_id;
 uint8_t		destination_page;
 } _O_WARNING_t;
 
 // check for update from EIB
-void check_warning_object (char*, uint8_t);
+void check_warning_object (char*);
 
 
 #endif // _O_WARNING_H_
@@ -18,8 +18,13 @@
 
 uint8_t page_descriptions_validated;
 uint8_t	active_page;
+// page descriptions in XRAM
+xram_far_t page_descriptions;
+// bank of the page element in process
+uint8_t page_bank;
 
 char*	active_element; // this element has been "touched"
+uint8_t	active_element_bank;
 uint8_t	active_element_state;
 uint8_t	(*touch_function)(char*, t_touch_event*, uint8_t*);	// this function handles the touch event for the active component
 uint8_t auto_jump_counter;
@@ -27,28 +32,69 @@ uint8_t	t_divider;
 uint8_t	warning_state; // 0x81 = show warning picture & sound, 1 = show picture WARNING, 0 = show picture on
 
 // moves page descriptions from Flash into RAM. Purpose is fast and easy access to Bytes.
+// The descriptions may span several banks. Page descriptors and elements never cross
+// a bank border, the page offset table is adjusted to their position in XRAM.
 // flash offset: start address in Flash
 // size: size of page descriptions in Byte
 uint8_t move_page_descriptions (uint32_t flash_offset, uint32_t size) {
 
-uint8_t checksum;
-uint16_t i;
-
-	// we can only handle sizes up to one XRAM page
-	if (size > XRAM_BANK_SIZE)
+_XRAM_LOADER_t	ld;
+uint16_t	*po;
+uint16_t	table_size;
+uint16_t	offset;
+uint16_t	element_count;
+uint8_t		pages;
+uint8_t		banks;
+uint8_t		bank;
+uint8_t		result;
+uint8_t		i;
+
+	page_descriptions_validated = 0;
+
+	// elements of older project files grow while they are converted
+	banks = xram_section_banks ((lcd_file_version == LCD_VERSION_COMPAT) ? 2*size : size);
+	bank = xram_alloc (banks);
+	if (!bank)
 		return 2;
+	page_descriptions = XRAM_FAR(bank, 0);
 
-	// move page descriptions from Flash into XRAM
-	copy_Flash_to_XRAM ((flash_offset >> 16) & 0xff, flash_offset & 0xffff, XRAM_PAGE_ADDR, size);
-
-	checksum = 0;
-	// validate checksum in XRAM
-	for (i = 0; i < size; i++) {
-		checksum ^= INB (XRAM_BASE_ADDRESS + i);
+	if (lcd_file_version == LCD_VERSION_COMPAT) {
+		result = compat_convert_pages (flash_offset, size, bank, banks);
+		if (result)
+			return result;
 	}
+	else {
+		// header and page offset table
+		xram_loader_init (&ld, bank, banks, flash_offset);
+		if (xram_load_block (&ld, 2))
+			return 2;
+		pages = *xram_far_select (page_descriptions);
+		table_size = 2 + 2*pages;
+		if (xram_load_block (&ld, table_size -2))
+			return 2;
+
+		for (i = 0; i < pages; i++) {
+			// offset of the page in Flash
+			po = (uint16_t*) xram_far_select (page_descriptions);
+			ld.flash = flash_offset + table_size + po[i+1];
+
+			result = xram_load_block (&ld, sizeof (_PAGE_DESCRIPTOR_t));
+			if (result)
+				return result;
+			offset = ld.block - page_descriptions - table_size;
+			element_count = ((_PAGE_DESCRIPTOR_t*) xram_far_select (ld.block))->element_count;
+			result = xram_load_elements (&ld, element_count);
+			if (result)
+				return result;
+
+			// offset of the page in XRAM
+			po = (uint16_t*) xram_far_select (page_descriptions);
+			po[i+1] = offset;
+		}
 
-	if (checksum)
-		return 1;
+		if (xram_loader_verify (&ld, size))
+			return 1;
+	}
 
 	page_descriptions_validated = 1;
 	active_page = 0;
@@ -59,23 +105,55 @@ uint16_t i;
 	return 0;
 }
 
-// returns an pointer to the page offset
+// returns the XRAM position of the page descriptor
 // page = 0,1,...
-char* get_page_descriptor (uint8_t page) {
+static xram_far_t get_page_position (uint8_t page) {
 
 uint16_t page_offset, *po;
  
 	// set page descriptions bank
-	XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
+	po = (uint16_t*) xram_far_select (page_descriptions);
 	// check, if page is valid
 	if (page >= INB (XRAM_BASE_ADDRESS))
 		page = 0;
 	// page is valid. Address offset is stored at table offset 2+2*page
-	po = (uint16_t*) XRAM_BASE_ADDRESS;
 	po += (page+1); // skip header 
 	page_offset = *po; // get offset of page
 	page_offset += 2*(1+INB (XRAM_BASE_ADDRESS)); // skip header and page offset table
-	return (char*) page_offset + XRAM_BASE_ADDRESS;
+	return page_descriptions + page_offset;
+}
+
+// get number of pages
+uint8_t get_page_count (void) {
+
+	if (!page_descriptions_validated)
+		return 0;
+	return *xram_far_select (page_descriptions);
+}
+
+// returns an pointer to the page descriptor, its bank is selected
+// page = 0,1,...
+char* get_page_descriptor (uint8_t page) {
+
+xram_far_t	position;
+
+	position = get_page_position (page);
+	page_bank = XRAM_FAR_BANK(position);
+	return xram_far_select (position);
+}
+
+// start iterating the elements of a page
+void page_iterator_init (_XRAM_ITERATOR_t *it, uint8_t page) {
+
+xram_far_t	position;
+
+	if (!page_descriptions_validated) {
+		xram_iterator_init (it, &page_bank, 0, 0);
+		return;
+	}
+	position = get_page_position (page);
+	xram_iterator_init (it, &page_bank, position + sizeof (_PAGE_DESCRIPTOR_t),
+						((_PAGE_DESCRIPTOR_t*) xram_far_select (position))->element_count);
 }
 
 // fill screen with monochrom color
@@ -92,13 +170,17 @@ _E_BACKGROUND_t*	p;
 void set_page (uint8_t page){
 
 char* p;
-_PAGE_DESCRIPTOR_t	*page_table;
+_XRAM_ITERATOR_t	it;
 _PAGE_ELEMENT_t		*page_element;
-uint8_t	element_count;
-int i;
+#ifdef LCD_DEBUG
+uint32_t	start;
+#endif
 
 	if (flash_content_bad)
 		return;
+#ifdef LCD_DEBUG
+	start = NutGetMillis ();
+#endif
 	// init counter for automatic page change
 	auto_jump_counter = 0;
 	/* state for warning picture */
@@ -109,22 +191,15 @@ int i;
 	touch_function = NULL;
 	active_element = NULL;
 	active_element_state = 0;
+	// read objects of the new page first
+	read_sweep_set_page (page);
 
 	// redraw screen contents: poll all components and lay them out on the screen
-	p = get_page_descriptor (page);
-	page_table = (_PAGE_DESCRIPTOR_t*) p;
-	element_count = page_table->element_count;
-
-	// skip page descriptor
-	p += sizeof (_PAGE_DESCRIPTOR_t);
-
 	// iterate all page elements
-	for (i = 0; i < element_count; i++) {
+	page_iterator_init (&it, page);
+	while ((p = xram_iterator_next (&it))) {
 		page_element = (_PAGE_ELEMENT_t*) p;
 
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-
 		switch (page_element->element_type) {
 			case PAGE_ELEMENT_TYPE_PICTURE:
 				draw_picture_element (p);
@@ -151,22 +226,19 @@ int i;
 			default: printf_P (PSTR("unknown page element %d\n"), page_element->element_type);
 #endif
 		}
-
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-		p += page_element->element_size;
 	}
 
+#ifdef LCD_DEBUG
+	printf_P (PSTR("page %d drawn in %lu ms\n"), page, NutGetMillis () - start);
+#endif
 }
 
 // checks active page components on touch event
 void page_touch_event (t_touch_event* evt) {
 	
 char* p;
-_PAGE_DESCRIPTOR_t	*page_table;
+_XRAM_ITERATOR_t	it;
 _PAGE_ELEMENT_t		*page_element;
-uint8_t	element_count;
-int i;
 
 	if (flash_content_bad) {
 		touch_function = NULL;
@@ -179,7 +251,8 @@ int i;
 	// do we already have an actively touched element?
 	if (active_element && touch_function) {
 
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
+		page_bank = active_element_bank;
+		XRAM_SELECT_BLOCK(page_bank);
 		if ((*touch_function)(active_element, evt, &active_element_state )) {
 			// release focus
 			touch_function = NULL;
@@ -190,19 +263,10 @@ int i;
 	}
 
 	// poll all components of active page and check, if they match the touched area
-	p = get_page_descriptor (active_page);
-	page_table = (_PAGE_DESCRIPTOR_t*) p;
-	element_count = page_table->element_count;
-
-	// skip page descriptor
-	p += sizeof (_PAGE_DESCRIPTOR_t);
-
 	// iterate all page elements
-	for (i = 0; i < element_count; i++) {
+	page_iterator_init (&it, active_page);
+	while ((p = xram_iterator_next (&it))) {
 		page_element = (_PAGE_ELEMENT_t*) p;
-
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		
 		switch (page_element->element_type) {
 			case PAGE_ELEMENT_TYPE_PICTURE:
@@ -212,6 +276,7 @@ int i;
 				if (!touch_jumper_element (p, evt, &active_element_state)) {
 					touch_function = touch_jumper_element;
 					active_element = p;
+					active_element_bank = page_bank;
 					return;
 				}
 				// for safety
@@ -221,6 +286,7 @@ int i;
 				if (!touch_button_element(p, evt, &active_element_state)) {
 					touch_function = touch_button_element;
 					active_element = p;
+					active_element_bank = page_bank;
 					return;
 				}
 				// for safety
@@ -230,6 +296,7 @@ int i;
 				if (!touch_led_element(p, evt, &active_element_state)) {
 					touch_function = touch_led_element;
 					active_element = p;
+					active_element_bank = page_bank;
 					return;
 				}
 				// for safety
@@ -239,16 +306,13 @@ int i;
 				if (!touch_sbutton_element(p, evt, &active_element_state)) {
 					touch_function = touch_sbutton_element;
 					active_element = p;
+					active_element_bank = page_bank;
 					return;
 				}
 				// for safety
 				active_element_state = 0;
 			break;
 		}
-
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-		p += page_element->element_size;
 	}
 
 }
@@ -258,14 +322,11 @@ int i;
 * @brief processes a new group message received from the EIB
 *
 */
-void lcd_page_process_msg (uint16_t address) {
+void lcd_page_process_msg (void) {
 
 char* p;
-_PAGE_DESCRIPTOR_t	*page_table;
+_XRAM_ITERATOR_t	it;
 _PAGE_ELEMENT_t		*page_element;
-uint8_t	element_count;
-int i;
-int	eib_object;
 
 	if (flash_content_bad)
 		return;
@@ -273,24 +334,11 @@ int	eib_object;
 	if (system_page_active || is_screen_locked() )
 		return;
 
-	eib_object = get_group_adress_index (address);
-	if (eib_object < 0)
-		return;
-
 	// poll all components of active page and check, if they match the eib address
-	p = get_page_descriptor (active_page);
-	page_table = (_PAGE_DESCRIPTOR_t*) p;
-	element_count = page_table->element_count;
-
-	// skip page descriptor
-	p += sizeof (_PAGE_DESCRIPTOR_t);
-
 	// iterate all page elements
-	for (i = 0; i < element_count; i++) {
+	page_iterator_init (&it, active_page);
+	while ((p = xram_iterator_next (&it))) {
 		page_element = (_PAGE_ELEMENT_t*) p;
-
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		
 		switch (page_element->element_type) {
 			case PAGE_ELEMENT_TYPE_PICTURE:
@@ -301,21 +349,18 @@ int	eib_object;
 			case PAGE_ELEMENT_TYPE_BUTTON:
 			break;
 			case PAGE_ELEMENT_TYPE_LED:
-				check_led_element (p, eib_object);
+				check_led_element (p);
 			break;
 			case PAGE_ELEMENT_TYPE_VALUE:
-				check_value_element (p, eib_object);
+				check_value_element (p);
 			break;
 			case PAGE_ELEMENT_TYPE_SBUTTON:
-				check_sbutton_element (p, eib_object, active_element==p, active_element_state);
+				check_sbutton_element (p, (active_element == p) && (active_element_bank == page_bank), active_element_state);
 			break;
 #ifdef LCD_DEBUG
 			default: printf_P (PSTR("unknown page element %d\n"), page_element->element_type);
 #endif
 		}
-
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-		p += page_element->element_size;
 	}
 
 
@@ -333,11 +378,9 @@ uint8_t get_active_page () {
 void page_time_ticker (void) {
 
 char* p;
-_PAGE_DESCRIPTOR_t	*page_table;
+_XRAM_ITERATOR_t	it;
 _PAGE_ELEMENT_t		*page_element;
-uint8_t	element_count;
 uint8_t	keep_warning_sound;
-int i;
 
 	// check tick counter
 	if (auto_jump_counter < 0xff)
@@ -349,19 +392,10 @@ int i;
 		return;
 
 	// poll all components of active page and check all jumpers and warning LED
-	p = get_page_descriptor (active_page);
-	page_table = (_PAGE_DESCRIPTOR_t*) p;
-	element_count = page_table->element_count;
-
-	// skip page descriptor
-	p += sizeof (_PAGE_DESCRIPTOR_t);
-
 	// iterate all page elements
-	for (i = 0; i < element_count; i++) {
+	page_iterator_init (&it, active_page);
+	while ((p = xram_iterator_next (&it))) {
 		page_element = (_PAGE_ELEMENT_t*) p;
-
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		
 		switch (page_element->element_type) {
 			case PAGE_ELEMENT_TYPE_JUMPER:
@@ -389,9 +423,6 @@ int i;
 			default: printf_P (PSTR("unknown page element %d\n"), page_element->element_type);
 #endif
 		}
-
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-		p += page_element->element_size;
 	}
 
 	if (!keep_warning_sound)
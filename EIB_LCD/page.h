@@ -23,7 +23,7 @@
 #include "e_value.h"
 
 typedef struct __attribute__ ((packed)) {
-uint8_t		element_count;
+uint16_t	element_count;
 char 		page_name[16];
 } _PAGE_DESCRIPTOR_t;
 
@@ -53,6 +53,7 @@ uint8_t		red;
 // moves the page descriptions from Flash into RAM
 // returns 0 if ok
 // returns 1 on checksum error
+// returns 2 if there are not enough XRAM banks
 uint8_t move_page_descriptions (uint32_t, uint32_t);
 
 // set page active and redraw screen contents
@@ -65,10 +66,17 @@ void recover_active_page (void);
 void page_touch_event (t_touch_event*);
 
 // check page on EIB event
-void lcd_page_process_msg (uint16_t);
+void lcd_page_process_msg (void);
 
+// bank of the page element in process
+extern uint8_t page_bank;
+
+// get number of pages
+uint8_t get_page_count (void);
 // get page descriptor
 char* get_page_descriptor (uint8_t);
+// start iterating the elements of a page
+void page_iterator_init (_XRAM_ITERATOR_t*, uint8_t);
 
 // process cyclic events
 void process_cyclic_page_events (void);
@@ -5,10 +5,25 @@
  *	Implemented functions:
  *	- display pictures stored in the Nand Flash
  *	- return picture dimensions to support text output
+ *	- mirror the picture descriptor table in XRAM
+ *	- cache recently drawn pictures in XRAM
  *
  *	This module supports all page elements, which need to display
  *	pictures (including icons) stored in the Nand Flash.
  *
+ *	The cache uses free XRAM banks in pairs, the low bytes of the pixels
+ *	are stored in the first bank, the high bytes in the second one. The
+ *	CPLD copies a cached picture to the TFT with one read per pixel.
+ *	Pictures are stored in slots of 512 pixels, the least recently used
+ *	pictures are dropped, if there are no free slots. The cache takes the
+ *	banks left free by the project, but keeps the banks of the download
+ *	buffer free. It is compiled with PICTURE_CACHE_SUPPORT only, see
+ *	tft_put_xram_image().
+ *
+ *	Pictures flagged with PICTURE_PACKED in their width are run length
+ *	encoded. Runs are written to the TFT without reading the Flash, so
+ *	large flat backgrounds need only a few Flash reads.
+ *
  *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
  *
  *	This program is free software; you can redistribute it and/or modify
@@ -20,89 +35,492 @@
 
 // start address of picture descriptor table in Flash
 uint32_t picture_table_start_address;
+// descriptor table mirrored in XRAM
+xram_far_t picture_table;
+uint16_t picture_table_count;
+
+// cached pictures
+_PICTURE_CACHE_ENTRY_t picture_cache[PICTURE_CACHE_ENTRIES];
+// used slots, one bit per slot
+uint8_t picture_cache_used[PICTURE_CACHE_MAX_SLOTS / 8];
+// first bank and number of slots of the cache, 0: no cache
+uint8_t picture_cache_bank;
+uint8_t picture_cache_slots;
+// time of the last use
+uint16_t picture_cache_clock;
+// statistics
+uint32_t picture_cache_hits;
+uint32_t picture_cache_misses;
+// pictures drawn from Flash: pixels and words read of packed pictures, time
+uint32_t picture_packed_pixels;
+uint32_t picture_packed_words;
+uint32_t picture_flash_draw_time;
+
+#ifdef PICTURE_CACHE_SUPPORT
+static uint8_t picture_cache_is_used (uint8_t slot) {
+
+	return picture_cache_used[slot >> 3] & (1 << (slot & 0x07));
+}
+
+static void picture_cache_set_used (uint8_t slot, uint8_t slots, uint8_t used) {
+
+	for (; slots; slots--, slot++)
+		if (used)
+			picture_cache_used[slot >> 3] |= 1 << (slot & 0x07);
+		else picture_cache_used[slot >> 3] &= ~(1 << (slot & 0x07));
+}
+
+// get bank and offset of a slot
+static uint8_t picture_cache_slot_bank (uint8_t slot, uint16_t *offset) {
+
+	*offset = (slot % PICTURE_CACHE_PAIR_SLOTS) * PICTURE_CACHE_SLOT_PIXELS;
+	return picture_cache_bank + 2 * (slot / PICTURE_CACHE_PAIR_SLOTS);
+}
+
+// mark entry as most recently used
+static void picture_cache_touch (_PICTURE_CACHE_ENTRY_t *e) {
+
+uint8_t	i;
+
+	// restart the clock, the order of the older entries is lost
+	if (!++picture_cache_clock) {
+		for (i = 0; i < PICTURE_CACHE_ENTRIES; i++)
+			picture_cache[i].used = 0;
+		picture_cache_clock = 1;
+	}
+	e->used = picture_cache_clock;
+}
+
+// find cached picture, returns NULL if it is not cached
+static _PICTURE_CACHE_ENTRY_t* picture_cache_find (uint16_t i) {
+
+uint8_t	n;
+
+	for (n = 0; n < PICTURE_CACHE_ENTRIES; n++)
+		if (picture_cache[n].slots && (picture_cache[n].index == i))
+			return &picture_cache[n];
+	return NULL;
+}
+
+// drop the least recently used picture
+// returns 0, if the cache is empty
+static uint8_t picture_cache_evict (void) {
+
+_PICTURE_CACHE_ENTRY_t	*e;
+uint8_t	n;
+
+	e = NULL;
+	for (n = 0; n < PICTURE_CACHE_ENTRIES; n++)
+		if (picture_cache[n].slots && (!e || (picture_cache[n].used < e->used)))
+			e = &picture_cache[n];
+	if (!e)
+		return 0;
+
+	picture_cache_set_used (e->slot, e->slots, 0);
+	e->slots = 0;
+	return 1;
+}
+
+// find consecutive free slots, returns the first slot or 0xff
+static uint8_t picture_cache_find_slots (uint8_t slots) {
+
+uint8_t	first;
+uint8_t	i;
+
+	for (first = 0; first + slots <= picture_cache_slots; first++) {
+		for (i = 0; i < slots; i++)
+			if (picture_cache_is_used (first + i))
+				break;
+		if (i == slots)
+			return first;
+		first += i;
+	}
+	return 0xff;
+}
+
+// start unpacking pixels
+// flash: byte address of the pixels in Flash
+static void picture_unpack_init (_PICTURE_UNPACK_t *u, uint32_t flash, uint8_t packed) {
+
+	u->flash = flash;
+	u->buffered = 0;
+	u->count = 0;
+	u->packed = packed;
+	u->run = 0;
+}
+
+// get next word, the words are read from Flash in bursts
+static uint16_t picture_unpack_word (_PICTURE_UNPACK_t *u) {
+
+	if (!u->buffered) {
+		read_flash_block (u->flash, u->buffer, PICTURE_CACHE_FILL_WORDS);
+		u->flash += 2 * PICTURE_CACHE_FILL_WORDS;
+		u->buffered = PICTURE_CACHE_FILL_WORDS;
+	}
+	return u->buffer[PICTURE_CACHE_FILL_WORDS - u->buffered--];
+}
+
+// get next pixel
+static uint16_t picture_unpack_next (_PICTURE_UNPACK_t *u) {
+
+uint16_t	control;
+
+	if (u->packed && !u->count) {
+		control = picture_unpack_word (u);
+		u->run = (control & TFT_PACKED_RUN) ? 1 : 0;
+		u->count = (control & ~TFT_PACKED_RUN) + 1;
+		if (u->run)
+			u->value = picture_unpack_word (u);
+	}
+	u->count--;
+	if (u->run)
+		return u->value;
+	return picture_unpack_word (u);
+}
+
+// copy picture from Flash into its slots
+// flash: byte address of the pixels in Flash
+static void picture_cache_fill (_PICTURE_CACHE_ENTRY_t *e, uint32_t flash, uint8_t packed) {
+
+_PICTURE_UNPACK_t	u;
+uint16_t	buffer[PICTURE_CACHE_FILL_WORDS];
+uint32_t	pixel;
+uint16_t	offset;
+uint16_t	n, k;
+uint8_t		bank;
+uint8_t		*p;
+
+	bank = picture_cache_slot_bank (e->slot, &offset);
+	pixel = (uint32_t) e->width * e->height;
+	picture_unpack_init (&u, flash, packed);
+
+	while (pixel) {
+		n = min (pixel, PICTURE_CACHE_FILL_WORDS);
+		n = min (n, XRAM_BANK_SIZE - offset);
+		for (k = 0; k < n; k++)
+			buffer[k] = picture_unpack_next (&u);
+
+		// split the pixels into the bank pair. Words from Flash have swapped bytes:
+		// the TFT low byte (Flash D7-0) is in d15-d8, the high byte (D15-8) in d7-d0.
+		p = (uint8_t*) (XRAM_BASE_ADDRESS + offset);
+		XRAM_SELECT_BLOCK(bank);
+		for (k = 0; k < n; k++)
+			p[k] = buffer[k] >> 8;
+		XRAM_SELECT_BLOCK(bank +1);
+		for (k = 0; k < n; k++)
+			p[k] = buffer[k] & 0xff;
+
+		pixel -= n;
+		offset += n;
+		if (offset == XRAM_BANK_SIZE) {
+			offset = 0;
+			bank += 2;
+		}
+	}
+}
+
+// add picture to the cache
+// returns NULL, if the picture is not cached
+static _PICTURE_CACHE_ENTRY_t* picture_cache_add (uint16_t i, uint16_t width, uint16_t height, uint32_t flash, uint8_t packed) {
+
+_PICTURE_CACHE_ENTRY_t	*e;
+uint32_t	pixel;
+uint8_t		slots;
+uint8_t		slot;
+uint8_t		n;
+uint8_t		save_xram_page;
+
+	pixel = (uint32_t) width * height;
+	if (!picture_cache_slots || !pixel || (pixel > PICTURE_CACHE_MAX_PIXELS))
+		return NULL;
+	slots = (pixel + PICTURE_CACHE_SLOT_PIXELS -1) / PICTURE_CACHE_SLOT_PIXELS;
+
+	// free entry, drop the least recently used picture, if there is none
+	for (;;) {
+		for (n = 0; n < PICTURE_CACHE_ENTRIES; n++)
+			if (!picture_cache[n].slots)
+				break;
+		if (n < PICTURE_CACHE_ENTRIES)
+			break;
+		picture_cache_evict ();
+	}
+	e = &picture_cache[n];
+
+	// drop old pictures until the new one fits
+	while ((slot = picture_cache_find_slots (slots)) == 0xff)
+		if (!picture_cache_evict ())
+			return NULL;
+
+	e->index = i;
+	e->width = width;
+	e->height = height;
+	e->slot = slot;
+	e->slots = slots;
+	picture_cache_set_used (slot, slots, 1);
+	picture_cache_touch (e);
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	picture_cache_fill (e, flash, packed);
+	XRAM_SELECT_BLOCK(save_xram_page);
+
+	return e;
+}
+
+// put cached picture to the screen
+// width, height: dimensions of the picture
+static void picture_cache_put (_PICTURE_CACHE_ENTRY_t *e, uint16_t x_pos, uint16_t y_pos, uint16_t *width, uint16_t *height) {
+
+uint16_t	offset;
+uint8_t		bank;
+
+	picture_cache_touch (e);
+	*width = e->width;
+	*height = e->height;
+	bank = picture_cache_slot_bank (e->slot, &offset);
+	tft_put_xram_image (x_pos, y_pos, x_pos + e->width -1, y_pos + e->height -1, bank, offset);
+}
+#endif
+
+// drop the descriptor table and all cached pictures, their banks have been freed by xram_init()
+void picture_reset (void) {
+
+	picture_table_count = 0;
+	memset (picture_cache, 0, sizeof (picture_cache));
+	memset (picture_cache_used, 0, sizeof (picture_cache_used));
+	picture_cache_slots = 0;
+	picture_cache_clock = 0;
+	picture_cache_hits = 0;
+	picture_cache_misses = 0;
+	picture_packed_pixels = 0;
+	picture_packed_words = 0;
+	picture_flash_draw_time = 0;
+}
+
+// allocate the cache banks, call after all sections are loaded
+void picture_cache_init (void) {
+
+#ifdef PICTURE_CACHE_SUPPORT
+uint8_t	banks;
+
+	banks = xram_get_free_banks ();
+	banks = (banks > PICTURE_CACHE_FREE_BANKS) ? banks - PICTURE_CACHE_FREE_BANKS : 0;
+	banks = min (banks, PICTURE_CACHE_BANKS) & ~0x01;
+	// free banks may be fragmented
+	for (; banks; banks -= 2) {
+		picture_cache_bank = xram_alloc (banks);
+		if (picture_cache_bank)
+			break;
+	}
+	picture_cache_slots = banks / 2 * PICTURE_CACHE_PAIR_SLOTS;
+#ifdef LCD_DEBUG
+	printf_P (PSTR("\nPicture cache: %d banks at %d"), banks, picture_cache_bank);
+#endif
+#endif
+}
+
+// number of banks of the cache
+uint8_t picture_cache_get_banks (void) {
+
+	return picture_cache_slots / PICTURE_CACHE_PAIR_SLOTS * 2;
+}
+
+// number of cache hits
+uint32_t picture_cache_get_hits (void) {
+
+	return picture_cache_hits;
+}
+
+// number of cache misses
+uint32_t picture_cache_get_misses (void) {
+
+	return picture_cache_misses;
+}
+
+// size of the packed pictures drawn from Flash in % of the unpacked size
+// returns 0, if no packed picture has been drawn from Flash
+uint8_t picture_get_packed_ratio (void) {
+
+	if (!picture_packed_pixels)
+		return 0;
+	return min (picture_packed_words * 100 / picture_packed_pixels, 255);
+}
+
+// time spent drawing pictures from Flash [ms]
+uint32_t picture_get_flash_draw_time (void) {
+
+	return picture_flash_draw_time;
+}
+
+static uint8_t picture_get_descriptor (uint16_t, _PICTURE_DESCRIPTOR_t*);
+
+// put picture i to the screen
+// width, height: dimensions of the picture
+static void put_picture (uint16_t i, uint16_t x_pos, uint16_t y_pos, uint16_t *width, uint16_t *height) {
+
+#ifdef PICTURE_CACHE_SUPPORT
+_PICTURE_CACHE_ENTRY_t	*e;
+#endif
+_PICTURE_DESCRIPTOR_t	d;
+uint32_t	start;
+uint32_t	pixel;
+uint32_t	words;
+uint8_t		packed;
+
+#ifdef PICTURE_CACHE_SUPPORT
+	e = picture_cache_find (i);
+	if (e) {
+		picture_cache_hits++;
+		picture_cache_put (e, x_pos, y_pos, width, height);
+		return;
+	}
+#endif
+
+	// wait while another thread erases or programs the Flash,
+	// the cache must not be filled with its status bits
+	flash_read_begin ();
+	packed = picture_get_descriptor (i, &d);
+	*width = d.width;
+	*height = d.height;
+
+#ifdef PICTURE_CACHE_SUPPORT
+	if (picture_cache_slots)
+		picture_cache_misses++;
+	e = picture_cache_add (i, d.width, d.height, picture_table_start_address + d.offset, packed);
+	if (e) {
+		flash_read_end ();
+		picture_cache_put (e, x_pos, y_pos, width, height);
+		return;
+	}
+#endif
+
+	// move image to tft
+	start = NutGetMillis ();
+	if (packed) {
+		pixel = (uint32_t) d.width * d.height;
+		words = tft_put_packed_flash_image (x_pos, y_pos, x_pos + d.width -1, y_pos + d.height -1, (picture_table_start_address + d.offset) >> 1 );
+		picture_packed_pixels += pixel;
+		picture_packed_words += words;
+#ifdef LCD_DEBUG
+		printf_P (PSTR("\nPacked picture %u: %lu words for %lu pixels, %lu ms"), i, words, pixel, NutGetMillis () - start);
+#endif
+	}
+	else tft_put_flash_image (x_pos, y_pos, x_pos + d.width -1, y_pos + d.height -1, (picture_table_start_address + d.offset) >> 1 );
+	picture_flash_draw_time += NutGetMillis () - start;
+	flash_read_end ();
+}
 
 uint16_t draw_picture (uint16_t i, uint16_t x_pos, uint16_t y_pos) {
 
-uint32_t	pict;
-uint32_t	ofs;
 uint16_t	width, height;
 
 	if (i == NO_PICTURE)
 		return 0;
-	// get descriptor of picture i
-	pict = sizeof (_PICTURE_DESCRIPTOR_t) * i;
-	pict += picture_table_start_address;
-	
-	// read picture properties from Flash
-	ofs = read_flash_abs (pict +2);
-	ofs = (ofs << 16) | read_flash_abs (pict);
-	width = read_flash_abs (pict+4);
-	height = read_flash_abs (pict+6);
 
-	// move image to tft
-	tft_put_flash_image (x_pos, y_pos, x_pos + width -1, y_pos + height -1, (picture_table_start_address + ofs) >> 1 );
+	put_picture (i, x_pos, y_pos, &width, &height);
 	return width;
 }
 
 uint16_t draw_picture_y (uint16_t i, uint16_t x_pos, uint16_t y_pos) {
 
-uint32_t	pict;
-uint32_t	ofs;
 uint16_t	width, height;
 
-	// get descriptor of picture i
-	pict = sizeof (_PICTURE_DESCRIPTOR_t) * i;
-	pict += picture_table_start_address;
-	
-	// read picture properties from Flash
-	ofs = read_flash_abs (pict +2);
-	ofs = (ofs << 16) | read_flash_abs (pict);
-	width = read_flash_abs (pict+4);
-	height = read_flash_abs (pict+6);
-
-	// move image to tft
-	tft_put_flash_image (x_pos, y_pos, x_pos + width -1, y_pos + height -1, (picture_table_start_address + ofs) >> 1 );
+	put_picture (i, x_pos, y_pos, &width, &height);
 	return height;
 }
 
-void set_picture_table_start_address (uint32_t s) {
+// copy the picture descriptor table into XRAM
+// flash_offset: start of the picture section, d23-d16: sector, d15-d0: byte offset
+// size: size of the picture section including the pixels
+// returns 0 if ok, 1 if the table is invalid, 2 if it is too big
+// Pictures are drawn with descriptors read from Flash, if the table is not mirrored.
+uint8_t move_picture_table (uint32_t flash_offset, uint32_t size) {
+
+_XRAM_LOADER_t	ld;
+uint32_t	ofs;
+uint32_t	table_size;
+uint8_t		banks;
+uint8_t		bank;
+
+	picture_table_start_address = flash_offset;
+	picture_table_count = 0;
+
+	// the pixels of the first picture follow the table
+	ofs = read_flash_abs (flash_offset +2);
+	ofs = (ofs << 16) | read_flash_abs (flash_offset);
+	if (!ofs || (ofs > size) || (ofs % sizeof (_PICTURE_DESCRIPTOR_t)))
+		return 1;
+	table_size = ofs;
+
+	banks = (table_size + XRAM_BANK_SIZE -1) / XRAM_BANK_SIZE;
+	if (banks > PICTURE_TABLE_MAX_BANKS)
+		return 2;
+	bank = xram_alloc (banks);
+	if (!bank)
+		return 2;
+
+	// descriptors never cross a bank border, the banks are filled completely
+	xram_loader_init (&ld, bank, banks, flash_offset);
+	for (ofs = 0; ofs < table_size; ofs += XRAM_BANK_SIZE)
+		if (xram_load_block (&ld, min (table_size - ofs, XRAM_BANK_SIZE)))
+			return 2;
+
+	picture_table = XRAM_FAR(bank, 0);
+	picture_table_count = table_size / sizeof (_PICTURE_DESCRIPTOR_t);
+	return 0;
+}
+
+// get descriptor of picture i, the PICTURE_PACKED flag is removed from the width
+// the bank of the caller is kept
+// returns 1, if the picture is packed
+static uint8_t picture_get_descriptor (uint16_t i, _PICTURE_DESCRIPTOR_t *d) {
 
-	picture_table_start_address = s;
+uint32_t	pict;
+uint8_t		save_xram_page;
+
+	if (i < picture_table_count) {
+		save_xram_page = XRAM_GET_SELECTED_BLOCK;
+		memcpy (d, xram_far_select (picture_table + sizeof (_PICTURE_DESCRIPTOR_t) * (uint32_t) i), sizeof (_PICTURE_DESCRIPTOR_t));
+		XRAM_SELECT_BLOCK(save_xram_page);
+	}
+	else {
+		// read picture properties from Flash
+		pict = sizeof (_PICTURE_DESCRIPTOR_t) * (uint32_t) i;
+		pict += picture_table_start_address;
+		flash_read_begin ();
+		d->offset = read_flash_abs (pict +2);
+		d->offset = (d->offset << 16) | read_flash_abs (pict);
+		d->width = read_flash_abs (pict+4);
+		d->height = read_flash_abs (pict+6);
+		flash_read_end ();
+	}
+
+	if (!(d->width & PICTURE_PACKED))
+		return 0;
+	d->width &= ~PICTURE_PACKED;
+	return 1;
 }
 
 void get_picture_size (uint16_t i, uint16_t *width, uint16_t *height) {
 
-uint32_t	pict;
+_PICTURE_DESCRIPTOR_t	d;
 
-	// get descriptor of picture i
-	pict = sizeof (_PICTURE_DESCRIPTOR_t) * i;
-	pict += picture_table_start_address;
-	
-	// read picture properties from Flash
-	*width = read_flash_abs (pict+4);
-	*height = read_flash_abs (pict+6);
+	picture_get_descriptor (i, &d);
+	*width = d.width;
+	*height = d.height;
 }
 
 uint16_t get_picture_width (uint16_t i) {
 
-uint32_t	pict;
+_PICTURE_DESCRIPTOR_t	d;
 
-	// get descriptor of picture i
-	pict = sizeof (_PICTURE_DESCRIPTOR_t) * i;
-	pict += picture_table_start_address;
-	
-	// read picture properties from Flash
-	return read_flash_abs (pict+4);
+	picture_get_descriptor (i, &d);
+	return d.width;
 }
 
 uint16_t get_picture_height (uint16_t i) {
 
-uint32_t	pict;
+_PICTURE_DESCRIPTOR_t	d;
 
-	// get descriptor of picture i
-	pict = sizeof (_PICTURE_DESCRIPTOR_t) * i;
-	pict += picture_table_start_address;
-	
-	// read picture properties from Flash
-	return read_flash_abs (pict+6);
+	picture_get_descriptor (i, &d);
+	return d.height;
 }
@@ -22,9 +22,54 @@ uint16_t	width;
 uint16_t	height;
 } _PICTURE_DESCRIPTOR_t;
 
+// width flag of packed pictures, their pixels are stored as TFT_PACKED_RUN packets
+#define PICTURE_PACKED	0x8000
+
 // a picture with this ID is skipped. Added to suppress LED icon outputs for weather symbol display.
 #define NO_PICTURE	0xffff
 
+// max. banks of the mirrored descriptor table, 4096 pictures
+#define PICTURE_TABLE_MAX_BANKS		4
+
+// cache of pictures in XRAM bank pairs, see tft_put_xram_image()
+// The cache is compiled with PICTURE_CACHE_SUPPORT only, the Makefile enables it.
+// max. banks of the cache
+#define PICTURE_CACHE_BANKS			16
+// banks left free for the download buffer
+#define PICTURE_CACHE_FREE_BANKS	FLASH_DOWNLOAD_MAX_BANKS
+// pixels of a cache slot
+#define PICTURE_CACHE_SLOT_PIXELS	512
+#define PICTURE_CACHE_PAIR_SLOTS	(XRAM_BANK_SIZE / PICTURE_CACHE_SLOT_PIXELS)
+#define PICTURE_CACHE_MAX_SLOTS		(PICTURE_CACHE_BANKS / 2 * PICTURE_CACHE_PAIR_SLOTS)
+// bigger pictures are always drawn from Flash
+#define PICTURE_CACHE_MAX_PIXELS	XRAM_BANK_SIZE
+// max. number of cached pictures
+#define PICTURE_CACHE_ENTRIES		24
+// words read from Flash at once while filling the cache
+#define PICTURE_CACHE_FILL_WORDS	16
+
+/**
+* @brief state of unpacking the pixels of a picture
+*/
+typedef struct {
+uint32_t	flash;		// byte address of the next burst in Flash
+uint16_t	buffer[PICTURE_CACHE_FILL_WORDS];	// words of the last burst
+uint8_t		buffered;	// words left in the buffer
+uint16_t	count;		// pixels left in the packet
+uint16_t	value;		// pixel of a run
+uint8_t		packed;		// pixels are packed
+uint8_t		run;		// packet is a run
+} _PICTURE_UNPACK_t;
+
+typedef struct {
+uint16_t	index;		// picture index
+uint16_t	width;
+uint16_t	height;
+uint16_t	used;		// time of last use
+uint8_t		slot;		// first slot
+uint8_t		slots;		// number of slots, 0: entry is free
+} _PICTURE_CACHE_ENTRY_t;
+
 // put picture to lcd (i, x, y)
 // i = picture index
 // x = starting x-pos
@@ -33,11 +78,26 @@ uint16_t	height;
 uint16_t  draw_picture (uint16_t, uint16_t, uint16_t);
 uint16_t  draw_picture_y (uint16_t, uint16_t, uint16_t);
 
-void set_picture_table_start_address (uint32_t);
+// copy picture descriptor table into XRAM
+uint8_t move_picture_table (uint32_t, uint32_t);
 
 void get_picture_size (uint16_t, uint16_t*, uint16_t*);
 
 uint16_t get_picture_width (uint16_t);
 uint16_t get_picture_height (uint16_t);
 
+// drop the descriptor table and all cached pictures, the banks have been freed
+void picture_reset (void);
+// allocate the cache banks, call after all sections are loaded
+void picture_cache_init (void);
+// number of banks of the cache, 0 if there were not enough free banks
+uint8_t picture_cache_get_banks (void);
+// number of cache hits and misses
+uint32_t picture_cache_get_hits (void);
+uint32_t picture_cache_get_misses (void);
+// size of the packed pictures drawn from Flash in % of the unpacked size, 0 if there were none
+uint8_t picture_get_packed_ratio (void);
+// time spent drawing pictures from Flash [ms]
+uint32_t picture_get_flash_draw_time (void);
+
 #endif // _PICTURE_H_
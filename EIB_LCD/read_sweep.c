@@ -0,0 +1,234 @@
+/** \file read_sweep.c
+ *  \brief Functions for the startup read of object values
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- collect objects of page and listen elements flagged for read on init
+ *	- send GroupValueRead requests paced by the main loop
+ *	- read objects of the active page first
+ *
+ *	Many panels start at the same time after bus power returns. The start
+ *	and the interval of the reads depend on the device address, other
+ *	objects than those of the active page are not read on high bus load,
+ *	and an object is not read anymore, once any telegram has set its value.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "read_sweep.h"
+#include "o_backlight.h"
+#include "o_led.h"
+#include "o_warning.h"
+
+// objects waiting for a read request, one bit per object
+uint8_t read_sweep_pending[EIB_MAX_OBJECTS / 8];
+// objects of the active page, one bit per object
+uint8_t read_sweep_page[EIB_MAX_OBJECTS / 8];
+// object to start the next search with
+uint16_t read_sweep_next;
+// ticks until the next read request
+uint8_t read_sweep_delay;
+// start delay has been applied
+uint8_t read_sweep_started;
+// bus load measurement
+uint8_t read_sweep_load_ticks;
+uint8_t read_sweep_telegrams;
+uint8_t read_sweep_load;
+// TPUART state of the last call
+enum e_eib_tpuart_states read_sweep_eib_state;
+
+// mark object in the object map
+static void read_sweep_mark (uint8_t *map, uint16_t object) {
+
+	if (object < get_object_count ())
+		map[object >> 3] |= 1 << (object & 0x07);
+}
+
+// mark objects of page elements flagged for read on init
+static void read_sweep_collect_page (uint8_t page, uint8_t *map) {
+
+_XRAM_ITERATOR_t	it;
+char* p;
+_PAGE_ELEMENT_t		*page_element;
+
+	page_iterator_init (&it, page);
+	while ((p = xram_iterator_next (&it))) {
+		page_element = (_PAGE_ELEMENT_t*) p;
+
+		switch (page_element->element_type) {
+			case PAGE_ELEMENT_TYPE_LED:
+				if (((_E_LED_t*) p)->parameter & LED_PARAMETER_INIT)
+					read_sweep_mark (map, ((_E_LED_t*) p)->eib_object_listen);
+			break;
+			case PAGE_ELEMENT_TYPE_VALUE:
+				if (((_E_VALUE_t*) p)->parameter & VALUE_PARAMETER_INIT)
+					read_sweep_mark (map, ((_E_VALUE_t*) p)->eib_object_listen);
+			break;
+			case PAGE_ELEMENT_TYPE_SBUTTON:
+				if (((_E_SBUTTON_t*) p)->eib_function & EIB_SBUTTON_FUNCTION_INIT)
+					read_sweep_mark (map, ((_E_SBUTTON_t*) p)->eib_object_listen);
+			break;
+		}
+	}
+}
+
+// mark objects of the always listening elements
+static void read_sweep_collect_listen (uint8_t *map) {
+
+_XRAM_ITERATOR_t	it;
+char* p;
+_LISTEN_ELEMENT_t	*listen_element;
+
+	listen_iterator_init (&it);
+	while ((p = xram_iterator_next (&it))) {
+		listen_element = (_LISTEN_ELEMENT_t*) p;
+
+		switch (listen_element->element_type) {
+			case LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE:
+			case LISTEN_ELEMENT_TYPE_BACKLIGHT_ACTIVE:
+				if (((_O_BACKLIGHT_t*) p)->parameter & BACKLIGHT_PARAMETER_LISTEN)
+					read_sweep_mark (map, ((_O_BACKLIGHT_t*) p)->eib_object_listen);
+			break;
+			case LISTEN_ELEMENT_TYPE_LED:
+				read_sweep_mark (map, ((_O_LED_t*) p)->eib_object_listen);
+			break;
+			case LISTEN_ELEMENT_TYPE_WARNING:
+				read_sweep_mark (map, ((_O_WARNING_t*) p)->warning_object_id);
+			break;
+		}
+	}
+}
+
+// collect all objects to be read from pages and listen elements
+// must be called after init_association_table()
+void read_sweep_init (void) {
+
+uint8_t	page_count;
+uint8_t	page;
+
+	memset (read_sweep_pending, 0, sizeof (read_sweep_pending));
+	memset (read_sweep_page, 0, sizeof (read_sweep_page));
+	read_sweep_next = 0;
+	read_sweep_started = 0;
+	read_sweep_eib_state = EIB_NORMAL;
+
+	if (flash_content_bad)
+		return;
+
+	page_count = get_page_count ();
+	for (page = 0; page < page_count; page++)
+		read_sweep_collect_page (page, read_sweep_pending);
+	read_sweep_collect_listen (read_sweep_pending);
+}
+
+// read objects of the page first
+void read_sweep_set_page (uint8_t page) {
+
+	memset (read_sweep_page, 0, sizeof (read_sweep_page));
+	read_sweep_collect_page (page, read_sweep_page);
+}
+
+// object value has been received, no need to read it anymore
+void read_sweep_object_received (uint16_t object) {
+
+	read_sweep_pending[object >> 3] &= ~(1 << (object & 0x07));
+}
+
+// a telegram has been received from the bus
+void read_sweep_bus_telegram (void) {
+
+	if (read_sweep_telegrams < 0xff)
+		read_sweep_telegrams++;
+}
+
+// find next object waiting for a read request
+// page_only: search only objects of the active page
+// returns -1, if there is none
+static int16_t read_sweep_find (uint8_t page_only) {
+
+uint16_t	n;
+uint16_t	object;
+uint8_t		bits;
+
+	for (n = 0; n < EIB_MAX_OBJECTS; n++) {
+		object = (read_sweep_next + n) & (EIB_MAX_OBJECTS -1);
+		bits = read_sweep_pending[object >> 3];
+		if (page_only)
+			bits &= read_sweep_page[object >> 3];
+		// skip the rest of an empty byte
+		if (!bits) {
+			n += 7 - (object & 0x07);
+			continue;
+		}
+		if (bits & (1 << (object & 0x07)))
+			return object;
+	}
+	return -1;
+}
+
+// send pending reads, call every main loop tick with the TPUART state
+void read_sweep_process (enum e_eib_tpuart_states state) {
+
+int16_t		object;
+uint16_t	address;
+uint8_t		ticks;
+uint8_t		spread;
+
+	// read all objects again, when the bus power returns
+	if ((state == EIB_NORMAL) && (read_sweep_eib_state == EIB_POWER_DOWN)) {
+		read_sweep_init ();
+		read_sweep_set_page (get_active_page ());
+	}
+	read_sweep_eib_state = state;
+
+	// measure the bus load
+	if (++read_sweep_load_ticks >= READ_SWEEP_LOAD_TICKS) {
+		read_sweep_load_ticks = 0;
+		read_sweep_load = read_sweep_telegrams;
+		read_sweep_telegrams = 0;
+	}
+
+	if (state != EIB_NORMAL)
+		return;
+
+	// panels with different addresses start and repeat at different times
+	spread = eib_get_device_address (EIB_DEVICE_CHANNEL) & READ_SWEEP_START_TICKS_MASK;
+	if (!read_sweep_started) {
+		read_sweep_started = 1;
+		read_sweep_delay = spread;
+	}
+	if (read_sweep_delay) {
+		read_sweep_delay--;
+		return;
+	}
+	if (!eib_check_tx_space (EIB_DEVICE_CHANNEL))
+		return;
+
+	// objects of the active page first
+	object = read_sweep_find (1);
+	ticks = READ_SWEEP_PAGE_TICKS;
+	if (object < 0) {
+		if (read_sweep_load > READ_SWEEP_MAX_LOAD)
+			return;
+		object = read_sweep_find (0);
+		ticks = READ_SWEEP_TICKS + spread;
+	}
+	if (object < 0)
+		return;
+
+	// retry later, if the TX buffer is full
+	address = get_object_send_address (object);
+	if (address && !eib_G_READ_request (address))
+		return;
+
+	read_sweep_object_received (object);
+	read_sweep_next = object +1;
+	read_sweep_delay = ticks -1;
+#ifdef LCD_DEBUG
+	printf_P(PSTR("\nRead object %d"), object);
+#endif
+}
@@ -0,0 +1,40 @@
+/** \file read_sweep.h
+ *  \brief Constants and definitions for the startup read of object values
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _READ_SWEEP_H_
+#define _READ_SWEEP_H_
+
+#include "System.h"
+
+// all times in ticks of the main loop (MAIN_TIME_LOOP_SLEEP)
+// min. time between two reads of objects on the active page: 60ms
+#define READ_SWEEP_PAGE_TICKS		2
+// min. time between two reads of other objects: 300ms
+#define READ_SWEEP_TICKS			10
+// max. start delay, selected by the device address
+#define READ_SWEEP_START_TICKS_MASK	0x07
+// measurement interval of the bus load: 1s
+#define READ_SWEEP_LOAD_TICKS		33
+// other objects are not read, while the bus load is higher [telegrams/s]
+#define READ_SWEEP_MAX_LOAD			15
+
+// collect all objects to be read from pages and listen elements
+void read_sweep_init (void);
+// read objects of the page first
+void read_sweep_set_page (uint8_t);
+// object value has been received
+void read_sweep_object_received (uint16_t);
+// a telegram has been received from the bus
+void read_sweep_bus_telegram (void);
+// send pending reads, call every main loop tick with the TPUART state
+void read_sweep_process (enum e_eib_tpuart_states);
+
+#endif // _READ_SWEEP_H_
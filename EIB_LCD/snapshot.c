@@ -0,0 +1,218 @@
+/** \file snapshot.c
+ *  \brief Functions for persistent object value snapshots
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- save object values into a log in the last Flash sector
+ *	- restore object values of the same project after reboot
+ *
+ *	Snapshots are appended to the log, so the sector is erased only once
+ *	per (sector size / snapshot size) snapshots. A snapshot is written
+ *	SNAPSHOT_MIN_INTERVAL after an object value has changed, when the
+ *	TPUART indicates bus power down and before a reboot.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include <stddef.h>
+#include "snapshot.h"
+
+// word offset of the next free record in the snapshot sector
+uint16_t snapshot_offset;
+// object values have been changed since the last snapshot
+uint8_t snapshot_pending;
+// time of the last snapshot
+uint32_t snapshot_time;
+// TPUART state of the last call
+enum e_eib_tpuart_states snapshot_eib_state;
+
+// get project key, the creation date of the project file
+static uint32_t snapshot_get_project (void) {
+
+uint32_t	project;
+uint16_t	addr;
+uint16_t	w;
+uint8_t		i;
+
+	// the creation date is not word aligned
+	project = 0;
+	addr = offsetof (_LCD_FILE_HEADER_t, file_creation_date) + 3;
+	for (i = 0; i < 4; i++, addr--) {
+		w = read_flash (0, addr >> 1);
+		project = (project << 8) | ((addr & 0x01) ? (w >> 8) : w) & 0xff;
+	}
+	return project;
+}
+
+// calculates the checksum of the object values in the arena
+static uint16_t snapshot_arena_checksum (uint16_t size) {
+
+uint16_t	checksum;
+uint16_t	o;
+uint8_t		*p;
+
+	checksum = 0;
+	for (o = 0; o < size; o++) {
+		if (!(o % XRAM_BANK_SIZE))
+			XRAM_SELECT_BLOCK(XRAM_OBJECT_ARENA_PAGE + o / XRAM_BANK_SIZE);
+		p = (uint8_t*) (XRAM_BASE_ADDRESS + o % XRAM_BANK_SIZE);
+		checksum += *p;
+	}
+	return checksum;
+}
+
+// calculates the checksum of a snapshot record in Flash
+static uint16_t snapshot_flash_checksum (uint16_t offset, uint16_t size) {
+
+uint16_t	checksum;
+uint16_t	w;
+
+	checksum = 0;
+	offset += SNAPSHOT_HEADER_WORDS;
+	while (size) {
+		w = read_flash (FLASH_PROJECT_SECTOR(SNAPSHOT_SECTOR), offset++);
+		checksum += w & 0xff;
+		if (--size) {
+			size--;
+			checksum += (w >> 8) & 0xff;
+		}
+	}
+	return checksum;
+}
+
+// restore object values of the project from the snapshot log
+// must be called after eib_object_init()
+void snapshot_restore (void) {
+
+uint16_t	offset;
+uint16_t	found;
+uint16_t	size;
+uint16_t	words;
+uint16_t	o, chunk;
+uint32_t	project;
+
+	snapshot_pending = 0;
+	snapshot_time = NutGetSeconds ();
+	snapshot_eib_state = EIB_POWER_DOWN;
+
+	size = eib_object_arena_size ();
+	project = snapshot_get_project ();
+
+	// find the last valid snapshot of the project and the end of the log
+	found = FLASH_SECTOR_SIZE;
+	offset = 0;
+	while (offset + SNAPSHOT_HEADER_WORDS <= FLASH_SECTOR_SIZE) {
+		// end of log
+		if (read_flash (FLASH_PROJECT_SECTOR(SNAPSHOT_SECTOR), offset) == 0xffff)
+			break;
+		// corrupted log, erase before the next snapshot
+		if (read_flash (FLASH_PROJECT_SECTOR(SNAPSHOT_SECTOR), offset) != SNAPSHOT_MAGIC) {
+			offset = FLASH_SECTOR_SIZE;
+			break;
+		}
+		words = read_flash (FLASH_PROJECT_SECTOR(SNAPSHOT_SECTOR), offset +1);
+		words = SNAPSHOT_HEADER_WORDS + ((words +1) >> 1);
+		if (offset + words > FLASH_SECTOR_SIZE) {
+			offset = FLASH_SECTOR_SIZE;
+			break;
+		}
+		// same project and object layout?
+		if ((read_flash (FLASH_PROJECT_SECTOR(SNAPSHOT_SECTOR), offset +1) == size) &&
+			(read_flash (FLASH_PROJECT_SECTOR(SNAPSHOT_SECTOR), offset +2) == (project & 0xffff)) &&
+			(read_flash (FLASH_PROJECT_SECTOR(SNAPSHOT_SECTOR), offset +3) == (project >> 16)) &&
+			(read_flash (FLASH_PROJECT_SECTOR(SNAPSHOT_SECTOR), offset +4) == snapshot_flash_checksum (offset, size)))
+			found = offset;
+		offset += words;
+	}
+	snapshot_offset = offset;
+
+#ifdef LCD_DEBUG
+	printf_P(PSTR("\nSnapshot log end %u, found %u"), snapshot_offset, found);
+#endif
+	if (found == FLASH_SECTOR_SIZE)
+		return;
+
+	// copy object values into the arena
+	for (o = 0; o < size; o += chunk) {
+		chunk = min (size - o, XRAM_BANK_SIZE - o % XRAM_BANK_SIZE);
+		copy_Flash_to_XRAM (FLASH_PROJECT_SECTOR(SNAPSHOT_SECTOR), ((found + SNAPSHOT_HEADER_WORDS) << 1) + o,
+							XRAM_OBJECT_ARENA_PAGE + o / XRAM_BANK_SIZE, o % XRAM_BANK_SIZE, chunk);
+	}
+}
+
+// object values have been changed
+void snapshot_object_changed (void) {
+
+	snapshot_pending = 1;
+}
+
+// save changed object values now
+void snapshot_save (void) {
+
+_SNAPSHOT_HEADER_t	header;
+uint16_t	size;
+uint16_t	words;
+uint16_t	o, chunk;
+
+	if (!snapshot_pending)
+		return;
+	snapshot_pending = 0;
+	snapshot_time = NutGetSeconds ();
+
+	size = eib_object_arena_size ();
+	if (flash_content_bad || !size)
+		return;
+
+	flash_program_begin ();
+
+	// start a new log, if the snapshot does not fit anymore
+	words = SNAPSHOT_HEADER_WORDS + ((size +1) >> 1);
+	if ((uint32_t) snapshot_offset + words > FLASH_SECTOR_SIZE) {
+		erase_flash_sector (SNAPSHOT_SECTOR);
+		snapshot_offset = 0;
+	}
+
+	// object values may change while other threads run during the erase
+	header.magic = SNAPSHOT_MAGIC;
+	header.size = size;
+	header.project = snapshot_get_project ();
+	header.checksum = snapshot_arena_checksum (size);
+
+	// header first, an interrupted snapshot fails the checksum test
+	write_nand_flash (SNAPSHOT_SECTOR, snapshot_offset, SNAPSHOT_HEADER_WORDS, (uint8_t*) &header);
+	for (o = 0; o < size; o += chunk) {
+		chunk = min (size - o, XRAM_BANK_SIZE - o % XRAM_BANK_SIZE);
+		XRAM_SELECT_BLOCK(XRAM_OBJECT_ARENA_PAGE + o / XRAM_BANK_SIZE);
+		write_nand_flash (SNAPSHOT_SECTOR, snapshot_offset + SNAPSHOT_HEADER_WORDS + (o >> 1), (chunk +1) >> 1,
+						  (uint8_t*) (XRAM_BASE_ADDRESS + o % XRAM_BANK_SIZE));
+	}
+	snapshot_offset += words;
+
+	flash_program_end ();
+
+#ifdef LCD_DEBUG
+	printf_P(PSTR("\nSnapshot saved, log end %u"), snapshot_offset);
+#endif
+}
+
+// save changed object values, call frequently with the TPUART state
+void snapshot_process (enum e_eib_tpuart_states state) {
+
+	// the Flash is erased or programmed by another thread, save later.
+	// The state is not taken, so a bus power down is still detected.
+	if (flash_busy)
+		return;
+
+	// save immediately on bus power down, since we may lose power, too
+	if ((state == EIB_POWER_DOWN) && (snapshot_eib_state != EIB_POWER_DOWN))
+		snapshot_save ();
+	snapshot_eib_state = state;
+
+	// batch changes
+	if (snapshot_pending && (NutGetSeconds () - snapshot_time >= SNAPSHOT_MIN_INTERVAL))
+		snapshot_save ();
+}
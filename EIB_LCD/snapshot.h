@@ -0,0 +1,49 @@
+/** \file snapshot.h
+ *  \brief Constants and definitions for persistent object value snapshots
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include "System.h"
+
+// the snapshot log uses the last Flash sector, project files must not use it
+// it is a physical sector, read it as FLASH_PROJECT_SECTOR(SNAPSHOT_SECTOR)
+#define SNAPSHOT_SECTOR			FLASH_MAX_SECTOR
+
+/**
+* @brief header of a snapshot record in Flash
+*
+* Records are appended to the snapshot sector, the object values follow the header.
+* The sector is erased, when the next record does not fit anymore.
+*/
+typedef struct __attribute__ ((packed)) {
+uint16_t	magic;
+uint16_t	size;		// size of the object values in bytes
+uint32_t	project;	// creation date of the project file
+uint16_t	checksum;	// sum of all object value bytes
+} _SNAPSHOT_HEADER_t;
+
+#define SNAPSHOT_MAGIC			0x534E
+#define SNAPSHOT_HEADER_WORDS	(sizeof (_SNAPSHOT_HEADER_t) >> 1)
+
+// min. time between two snapshots in s
+#define SNAPSHOT_MIN_INTERVAL	60
+
+// restore object values of the project from the snapshot log
+void snapshot_restore (void);
+// object values have been changed
+void snapshot_object_changed (void);
+// save changed object values, call frequently with the TPUART state
+void snapshot_process (enum e_eib_tpuart_states);
+// save changed object values now
+void snapshot_save (void);
+
+#endif // _SNAPSHOT_H_
@@ -0,0 +1,145 @@
+/** \file sysmon.c
+ *  \brief Functions for the thread stack and heap monitor
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- paint the unused stack space of all threads
+ *	- find the high-water mark of each stack
+ *	- track the min. free heap
+ *	- provide the values for the system page and memory read requests
+ *
+ *	A stack grows down from the thread info to the start of the memory
+ *	allocated by NutThreadCreate(). Painted bytes at the start of this
+ *	memory have never been used.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "System.h"
+#include "sysmon.h"
+
+// min. free heap since start
+uint16_t sysmon_heap_min;
+
+// paint the unused stack space of a thread
+static void sysmon_paint (NUTTHREADINFO *td) {
+
+uint8_t	*p;
+uint8_t	*top;
+
+	// a suspended thread does not use the space below its saved stack pointer,
+	// interrupts of the running thread may use some bytes below SP
+	if (td == runningThread)
+		top = (uint8_t*) SP - SYSMON_STACK_MARGIN;
+	else top = (uint8_t*) td->td_sp;
+
+	for (p = td->td_memory; p < top; p++)
+		*p = SYSMON_STACK_PATTERN;
+}
+
+// paint the stacks of the running threads, call first in main()
+void sysmon_init (void) {
+
+NUTTHREADINFO	*td;
+
+	for (td = nutThreadList; td; td = td->td_next)
+		sysmon_paint (td);
+	sysmon_heap_min = NutHeapAvailable ();
+}
+
+// create thread with painted stack
+HANDLE sysmon_thread_create (char *name, void (*fn) (void*), void *arg, size_t stack_size) {
+
+HANDLE	h;
+
+	h = NutThreadCreate (name, fn, arg, stack_size);
+	// the new thread may have run already, it is suspended now
+	if (h)
+		sysmon_paint ((NUTTHREADINFO*) h);
+	return h;
+}
+
+// track the free heap, call from the main loop
+void sysmon_tick (void) {
+
+uint16_t	heap;
+
+	heap = NutHeapAvailable ();
+	if (heap < sysmon_heap_min)
+		sysmon_heap_min = heap;
+}
+
+// get stack usage of thread n
+// returns 0, if there is no thread n
+uint8_t sysmon_get_thread (uint8_t n, _SYSMON_THREAD_t *t) {
+
+NUTTHREADINFO	*td;
+uint8_t	*p;
+uint8_t	*top;
+
+	for (td = nutThreadList; td && n; td = td->td_next)
+		n--;
+	if (!td)
+		return 0;
+
+	strncpy (t->name, (char*) td->td_name, SYSMON_NAME_LENGTH);
+	t->name[SYSMON_NAME_LENGTH] = 0;
+	// the thread info follows the stack
+	top = (uint8_t*) td;
+	t->stack_size = top - td->td_memory;
+
+	for (p = td->td_memory; (p < top) && (*p == SYSMON_STACK_PATTERN); p++)
+		;
+	t->stack_unused = p - td->td_memory;
+	return 1;
+}
+
+// free heap
+uint16_t sysmon_get_heap_free (void) {
+
+	return NutHeapAvailable ();
+}
+
+// min. free heap since start
+uint16_t sysmon_get_heap_min (void) {
+
+	return sysmon_heap_min;
+}
+
+// read byte of the emulated memory, see SYSMON_MEM_xxx
+uint8_t sysmon_get_mem (uint16_t addr) {
+
+_SYSMON_THREAD_t	t;
+uint16_t	value;
+uint8_t		n;
+
+	switch (addr) {
+		case SYSMON_MEM_HEAP_FREE:
+			return sysmon_get_heap_free () >> 8;
+		case SYSMON_MEM_HEAP_FREE +1:
+			return sysmon_get_heap_free () & 0xff;
+		case SYSMON_MEM_HEAP_MIN:
+			return sysmon_heap_min >> 8;
+		case SYSMON_MEM_HEAP_MIN +1:
+			return sysmon_heap_min & 0xff;
+		case SYSMON_MEM_THREADS:
+			for (n = 0; (n < SYSMON_MAX_THREADS) && sysmon_get_thread (n, &t); n++)
+				;
+			return n;
+	}
+	if ((addr < SYSMON_MEM_THREAD) || (addr >= SYSMON_MEM_SIZE))
+		return 0xff;
+
+	addr -= SYSMON_MEM_THREAD;
+	if (!sysmon_get_thread (addr / SYSMON_MEM_THREAD_SIZE, &t))
+		return 0xff;
+	addr %= SYSMON_MEM_THREAD_SIZE;
+	if (addr < SYSMON_NAME_LENGTH)
+		return t.name[addr];
+	value = (addr < SYSMON_NAME_LENGTH +2) ? t.stack_size : t.stack_unused;
+	return (addr & 0x01) ? value & 0xff : value >> 8;
+}
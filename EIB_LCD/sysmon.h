@@ -0,0 +1,57 @@
+/** \file sysmon.h
+ *  \brief Constants and definitions for the thread stack and heap monitor
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _SYSMON_H_
+#define _SYSMON_H_
+
+#include <stdint.h>
+#include <sys/thread.h>
+
+// byte painted into the unused stack space
+#define SYSMON_STACK_PATTERN	0xA5
+// bytes below the stack pointer of the running thread, which are not painted
+#define SYSMON_STACK_MARGIN		64
+// max. number of reported threads
+#define SYSMON_MAX_THREADS		10
+// length of reported thread names
+#define SYSMON_NAME_LENGTH		8
+
+// emulated memory for memory read requests, see al_get_mem()
+// all values are big endian
+#define SYSMON_MEM_HEAP_FREE	0	// 2 bytes: free heap
+#define SYSMON_MEM_HEAP_MIN		2	// 2 bytes: min. free heap since start
+#define SYSMON_MEM_THREADS		4	// 1 byte: number of threads
+#define SYSMON_MEM_THREAD		5	// thread records
+// thread record: name, 2 bytes stack size, 2 bytes never used stack
+#define SYSMON_MEM_THREAD_SIZE	(SYSMON_NAME_LENGTH +4)
+#define SYSMON_MEM_SIZE			(SYSMON_MEM_THREAD + SYSMON_MAX_THREADS * SYSMON_MEM_THREAD_SIZE)
+
+typedef struct {
+char		name[SYSMON_NAME_LENGTH +1];
+uint16_t	stack_size;
+uint16_t	stack_unused;	// high-water mark: bytes of the stack never used
+} _SYSMON_THREAD_t;
+
+// paint the stacks of the running threads, call first in main()
+void sysmon_init (void);
+// create thread with painted stack
+HANDLE sysmon_thread_create (char*, void (*)(void*), void*, size_t);
+// track the free heap, call from the main loop
+void sysmon_tick (void);
+// get stack usage of thread n, returns 0 if there is no thread n
+uint8_t sysmon_get_thread (uint8_t, _SYSMON_THREAD_t*);
+// free heap and min. free heap
+uint16_t sysmon_get_heap_free (void);
+uint16_t sysmon_get_heap_min (void);
+// read byte of the emulated memory
+uint8_t sysmon_get_mem (uint16_t);
+
+#endif // _SYSMON_H_
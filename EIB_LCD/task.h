@@ -17,11 +17,16 @@
 #define NUT_THREAD_EIB_TX_STACK 			0x200
 #define NUT_THREAD_EIBSERVICE_STACK 		0x200
 #define NUT_THREAD_POLL_TOUCH_STACK			0x200
+#define NUT_THREAD_EIBNET_STACK				0x200
+#define NUT_THREAD_CRC_CHECK_STACK			0x200
 
 /* Thread priorities */
 #define NUT_THREAD_PRIORITY_EIB_LL_SERVICE		50
 #define NUT_THREAD_PRIORITY_EIB_TL_SERVICE		55
 #define NUT_THREAD_PRIORITY_EIB_SERVE_TX		60
+#define NUT_THREAD_PRIORITY_EIBNET				65
 #define NUT_THREAD_PRIORITY_MAIN				70
+// runs only, while all other threads wait
+#define NUT_THREAD_PRIORITY_CRC_CHECK			252
 
 #endif // _TASK_H_
@@ -422,6 +422,143 @@ void tft_put_flash_image(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
 #endif
 }
 
+// move to the next Flash word, continue in the next sector
+#define TFT_FLASH_NEXT_WORD(address, sector) \
+	if (!++(address)) { \
+		(address) = FLASH_BASE_ADDRESS; \
+		FLASH_SELECT_SECTOR(++(sector)); \
+	}
+
+/**
+ * Copies a packed image from Flash to the screen.
+ * Runs are written to the TFT data port without reading the Flash, literal
+ * pixels are copied by the CPLD like in tft_put_flash_image().
+ * Returns the number of words read from Flash.
+ */
+uint32_t tft_put_packed_flash_image(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
+		uint32_t flash_address) {
+	volatile uint8_t b;
+	uint32_t pixel;
+	uint32_t words;
+	uint16_t n;
+	uint8_t sector;
+	uint16_t address;
+	uint8_t lb, hb;
+
+	if (controller_type == CTRL_UNKNOWN)
+		return 0;
+
+	address_set(x1, y1, x2, y2);
+
+	address = (flash_address & 0x7fff) + FLASH_BASE_ADDRESS;
+	sector = (flash_address >> 15) & 0x7f;
+	FLASH_SELECT_SECTOR(sector);
+
+	pixel = (y2 - y1 + 1);
+	pixel *= (x2 - x1 + 1);
+	words = 0;
+
+	while (pixel) {
+		// read control word, the upper byte latch is shared with interrupts
+		OUTB(CPLD_BASE_ADDR + MODE_CTRL_ADDR, 0x00);
+		NutEnterCritical();
+		hb = INB ( address );
+		lb = INB ( CPLD_BASE_ADDR + UPPER_DATA_RD_ADDR );
+		NutExitCritical ();
+		TFT_FLASH_NEXT_WORD(address, sector);
+		n = lb | (hb << 8);
+		words++;
+
+		if (n & TFT_PACKED_RUN) {
+			n = (n & ~TFT_PACKED_RUN) + 1;
+			if (n > pixel)
+				n = pixel;
+			pixel -= n;
+			// read pixel of the run
+			NutEnterCritical();
+			hb = INB ( address );
+			lb = INB ( CPLD_BASE_ADDR + UPPER_DATA_RD_ADDR );
+			NutExitCritical ();
+			TFT_FLASH_NEXT_WORD(address, sector);
+			words++;
+			// set high data byte to CPLD, the flash upper byte is the TFT upper byte
+			OUTB( CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, lb);
+			while (n--) {
+				// write low byte to LCD
+				OUTB( LCD_BASE_ADDR + LCD_DATA, hb);
+			}
+		}
+		else {
+			n = n + 1;
+			if (n > pixel)
+				n = pixel;
+			pixel -= n;
+			words += n;
+			//enable copy mode Flash -> TFT
+			OUTB(CPLD_BASE_ADDR + MODE_CTRL_ADDR, 1 << TFT_WRITE_ON_FLASH_READ);
+			while (n--) {
+				// read low byte from Flash
+				b = INB ( address );
+				TFT_FLASH_NEXT_WORD(address, sector);
+			}
+		}
+	}
+
+	OUTB(CPLD_BASE_ADDR + MODE_CTRL_ADDR, 0x00);
+	return words;
+}
+
+#ifdef PICTURE_CACHE_SUPPORT
+/**
+ * Copies an image from XRAM to the screen.
+ * Low bytes of the pixels are stored in bank, high bytes at the same offset
+ * in bank +1. Images continue in the next bank pair.
+ * The bank of the caller is kept.
+ * The CPLD mode TFT_WRITE_ON_RAM_BANK_READ is expected to write the pixel
+ * with the byte read from bank and the byte of bank +1. The function is
+ * compiled with PICTURE_CACHE_SUPPORT, which the Makefile enables by default.
+ * Remove it from HWDEF to draw all pictures from Flash on a CPLD without this
+ * mode.
+ */
+void tft_put_xram_image(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
+		uint8_t bank, uint16_t offset) {
+	volatile uint8_t b;
+	uint32_t pixel;
+	uint8_t *address;
+	uint8_t mode_save;
+	uint8_t bank_save;
+
+	if (controller_type == CTRL_UNKNOWN)
+		return;
+
+	address_set(x1, y1, x2, y2);
+
+	bank_save = XRAM_GET_SELECTED_BLOCK;
+	XRAM_SELECT_BLOCK(bank);
+	address = (uint8_t*) (XRAM_BASE_ADDRESS + offset);
+
+	pixel = (y2 - y1 + 1);
+	pixel *= (x2 - x1 + 1);
+
+	//enable copy mode XRAM -> TFT, no other XRAM reads until it is disabled
+	mode_save = INB(CPLD_BASE_ADDR + MODE_CTRL_ADDR);
+	OUTB(CPLD_BASE_ADDR + MODE_CTRL_ADDR, 1 << TFT_WRITE_ON_RAM_BANK_READ);
+
+	while (pixel--) {
+		// read low byte, the CPLD adds the high byte
+		b = *address++;
+		if (address == (uint8_t*) (XRAM_BASE_ADDRESS + XRAM_BANK_SIZE)) {
+			address = (uint8_t*) XRAM_BASE_ADDRESS;
+			bank += 2;
+			XRAM_SELECT_BLOCK(bank);
+		}
+	}
+
+	OUTB(CPLD_BASE_ADDR + MODE_CTRL_ADDR, mode_save);
+	XRAM_SELECT_BLOCK(bank_save);
+}
+#endif
+
 void inttostr(int dd, unsigned char *str) {
 	str[0] = dd / 10000 + 48;
 	str[1] = (dd / 1000) - ((dd / 10000) * 10) + 48;
@@ -689,7 +826,7 @@ void touch_init(void) {
 	char_y = START_CHAR_Y_POS;
 
 	// create touch poll process
-	NutThreadCreate("TOUCH", poll_touch, 0, NUT_THREAD_POLL_TOUCH_STACK);
+	sysmon_thread_create("TOUCH", poll_touch, 0, NUT_THREAD_POLL_TOUCH_STACK);
 }
 
 //init the tft control i/f
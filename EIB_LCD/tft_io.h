@@ -98,6 +98,11 @@ extern volatile uint8_t backlight_active;
 #define nop() \
    asm volatile ("nop")
 
+// Packed images are a sequence of packets, each starts with a control word.
+// A control word with this bit set is followed by one pixel, which is repeated
+// (control & 0x7fff) +1 times. Otherwise (control +1) pixels follow literally.
+#define TFT_PACKED_RUN		0x8000
+
 // Some RGB 565 color codes
 #define TFT_COLOR_WHITE		0xffff
 #define TFT_COLOR_LIGHTGRAY	0xbdf7
@@ -244,6 +249,16 @@ void tft_pant(unsigned int);
  *
  */
 void tft_put_flash_image (uint16_t,uint16_t,uint16_t,uint16_t, uint32_t);
+/** copy packed image from Flash to screen, see TFT_PACKED_RUN
+ *  returns the number of words read from Flash
+ */
+uint32_t tft_put_packed_flash_image (uint16_t,uint16_t,uint16_t,uint16_t, uint32_t);
+#ifdef PICTURE_CACHE_SUPPORT
+/** copy image from XRAM bank pairs to screen
+ *
+ */
+void tft_put_xram_image (uint16_t,uint16_t,uint16_t,uint16_t, uint8_t, uint16_t);
+#endif
 /** fill rect with color
  *
  */
@@ -0,0 +1,766 @@
+/** \file lcdpack.c
+ *  \brief Host tool to optimize project files for the Flash
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- validate the element sizes of pages, listen and cyclic elements
+ *	- sort the group address table for the binary search of the firmware
+ *	- align pictures to the fast path of tft_put_flash_image()
+ *	- align sections loaded into XRAM to the CPLD copy of copy_Flash_to_XRAM_check()
+ *	- remove duplicate pictures, optionally pack pictures (see PICTURE_PACKED)
+ *	- add a CRC-32 table of all sections (see crc.h)
+ *
+ *	The tool reads a project file created by the configuration tool and
+ *	writes an optimized copy, which is downloaded from the SD Card as usual:
+ *
+ *	lcdpack [-p] [-v] input.lcd output.lcd
+ *
+ *	The structures of the project file are defined by the firmware headers,
+ *	the constants below must follow them.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// project file header, _LCD_FILE_HEADER_t of System.h with a 32 bit time_t
+#define LCD_HEADER_SIZE			184
+#define LCD_HEADER_MAGIC		"EIBLCD"
+#define LCD_HEADER_VERSION		6
+#define LCD_VERSION_EXPECTED	0x1F
+#define LCD_VERSION_COMPAT		0x1E
+// TOC, _LCD_FILE_TOC_ENTRY_t of System.h
+#define TOC_HEADER_SIZE			2
+#define TOC_ITEMS_SIZE			9
+#define TOC_MAX_ITEMS			255
+
+// TOC types, see init_system_from_flash()
+#define TOC_TYPE_ADDRESS_TABLE	1
+#define TOC_TYPE_PAGES			3
+#define TOC_TYPE_PICTURES		4
+#define TOC_TYPE_SOUNDS			5
+#define TOC_TYPE_LISTEN			6
+#define TOC_TYPE_CYCLIC			7
+#define TOC_TYPE_ASSOCIATIONS	8
+#define TOC_TYPE_OBJECT_SIZES	9
+#define TOC_TYPE_CRC_TABLE		10
+
+// sizes of the section headers, see page.h, listen.h and cyclic.h
+#define PAGE_DESCRIPTOR_SIZE	18
+#define ELEMENT_DESCRIPTOR_SIZE	3
+// _ASSOCIATION_ENTRY_t of assoc_tab.h
+#define ASSOCIATION_ENTRY_SIZE	4
+#define ASSOCIATION_FLAG_SEND	0x8000
+#define ASSOCIATION_OBJECT_MASK	0x0fff
+#define ASSOCIATION_NO_ENTRY	0xffffffffUL
+#define ADDRESS_INDEX_INVALID	0xffff
+// _PICTURE_DESCRIPTOR_t of picture.h
+#define PICTURE_DESCRIPTOR_SIZE	8
+#define PICTURE_PACKED			0x8000
+// packet control word, see tft_io.h
+#define TFT_PACKED_RUN			0x8000
+#define PACKED_MAX_COUNT		0x8000
+// shorter runs are stored as literal pixels
+#define PACKED_MIN_RUN			3
+
+// tft_put_flash_image() copies two pixels per loop from even word addresses
+#define SECTION_ALIGN			4
+#define PICTURE_ALIGN			4
+// the CPLD copies sections into XRAM, which start at the same offset as the XRAM bank
+#define XRAM_SECTION_ALIGN		0x2000
+// Flash available for a project slot, see flash_slot.h
+#define FLASH_SLOT_BYTES		(62UL * 0x10000UL)
+
+/**
+* @brief section of the project file
+*/
+typedef struct {
+uint8_t		type;
+uint8_t		*data;
+uint32_t	size;
+uint32_t	position;	// position in the output file
+} _SECTION_t;
+
+/**
+* @brief group address of the address table
+*/
+typedef struct {
+uint16_t	key;		// group address in main/middle/sub order
+uint16_t	index;		// index in the input table
+} _ADDRESS_t;
+
+/**
+* @brief association entry sorted by the new address index
+*/
+typedef struct {
+uint16_t	address_index;
+uint16_t	object;
+uint32_t	order;		// position in the input table, keeps the sort stable
+} _ASSOCIATION_t;
+
+/**
+* @brief picture data written into the output section
+*/
+typedef struct {
+uint32_t	hash;
+uint32_t	offset;
+uint32_t	size;
+uint16_t	width;		// including PICTURE_PACKED
+uint16_t	height;
+} _PICTURE_BLOB_t;
+
+_SECTION_t sections[TOC_MAX_ITEMS];
+uint8_t section_count;
+uint8_t file_version;
+int verbose;
+int pack_pictures;
+
+static uint16_t get16 (const uint8_t *p) {
+
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32 (const uint8_t *p) {
+
+	return get16 (p) | ((uint32_t) get16 (p +2) << 16);
+}
+
+static void put16 (uint8_t *p, uint16_t v) {
+
+	p[0] = v & 0xff;
+	p[1] = v >> 8;
+}
+
+static void put32 (uint8_t *p, uint32_t v) {
+
+	put16 (p, v & 0xffff);
+	put16 (p +2, v >> 16);
+}
+
+static uint32_t align (uint32_t v, uint32_t a) {
+
+	return (v + a -1) & ~(a -1);
+}
+
+// alignment of a section, sections loaded into XRAM start at a bank border
+static uint32_t section_align (uint8_t type) {
+
+	switch (type) {
+		case TOC_TYPE_ADDRESS_TABLE:
+		case TOC_TYPE_PAGES:
+		case TOC_TYPE_PICTURES:
+		case TOC_TYPE_LISTEN:
+		case TOC_TYPE_CYCLIC:
+		case TOC_TYPE_ASSOCIATIONS:
+		case TOC_TYPE_OBJECT_SIZES:
+			return XRAM_SECTION_ALIGN;
+	}
+	return SECTION_ALIGN;
+}
+
+static void* xmalloc (size_t size) {
+
+void	*p;
+
+	p = malloc (size ? size : 1);
+	if (!p) {
+		fprintf (stderr, "out of memory\n");
+		exit (1);
+	}
+	return p;
+}
+
+// CRC-32 of IEEE 802.3 as checked by crc_verify()
+static uint32_t crc32 (const uint8_t *p, uint32_t size) {
+
+uint32_t	crc;
+int			k;
+
+	crc = 0xffffffffUL;
+	while (size--) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320UL : 0);
+	}
+	return ~crc;
+}
+
+// FNV-1a hash to find duplicate pictures
+static uint32_t hash32 (const uint8_t *p, uint32_t size) {
+
+uint32_t	h;
+
+	h = 2166136261UL;
+	while (size--)
+		h = (h ^ *p++) * 16777619UL;
+	return h;
+}
+
+// get section of type, NULL if there is none
+static _SECTION_t* find_section (uint8_t type) {
+
+uint8_t	i;
+
+	for (i = 0; i < section_count; i++)
+		if (sections[i].type == type)
+			return &sections[i];
+	return NULL;
+}
+
+// walk count elements starting at pos, the first byte of each element is its size
+// returns the position behind the elements, 0 on an invalid element size
+static uint32_t validate_elements (const char *name, _SECTION_t *s, uint32_t pos, uint16_t count) {
+
+uint16_t	i;
+
+	for (i = 0; i < count; i++) {
+		if ((pos >= s->size) || !s->data[pos] || (pos + s->data[pos] > s->size)) {
+			fprintf (stderr, "%s: invalid size of element %u at %lu\n", name, i, (unsigned long) pos);
+			return 0;
+		}
+		pos += s->data[pos];
+	}
+	return pos;
+}
+
+// validate the elements of all pages, see move_page_descriptions()
+// returns 0 if ok
+static int validate_pages (_SECTION_t *s) {
+
+uint32_t	table_size;
+uint32_t	pos;
+uint8_t		pages;
+uint8_t		i;
+
+	if (s->size < 2) {
+		fprintf (stderr, "pages: section too short\n");
+		return 1;
+	}
+	pages = s->data[0];
+	table_size = 2 + 2 * (uint32_t) pages;
+	if (table_size > s->size)
+		return 1;
+
+	for (i = 0; i < pages; i++) {
+		pos = table_size + get16 (s->data + 2 + 2*i);
+		if (pos + PAGE_DESCRIPTOR_SIZE > s->size) {
+			fprintf (stderr, "pages: page %u out of the section\n", i);
+			return 1;
+		}
+		if (!validate_elements ("pages", s, pos + PAGE_DESCRIPTOR_SIZE, get16 (s->data + pos)))
+			return 1;
+	}
+	if (verbose)
+		printf ("pages: %u pages ok\n", pages);
+	return 0;
+}
+
+// validate listen and cyclic elements, see move_listen_descriptions()
+// returns 0 if ok
+static int validate_element_section (const char *name, _SECTION_t *s) {
+
+uint16_t	count;
+
+	if (s->size < ELEMENT_DESCRIPTOR_SIZE) {
+		fprintf (stderr, "%s: section too short\n", name);
+		return 1;
+	}
+	count = get16 (s->data);
+	if (count && !validate_elements (name, s, ELEMENT_DESCRIPTOR_SIZE, count))
+		return 1;
+	if (verbose)
+		printf ("%s: %u elements ok\n", name, count);
+	return 0;
+}
+
+static int compare_addresses (const void *a, const void *b) {
+
+	return (int) ((const _ADDRESS_t*) a)->key - (int) ((const _ADDRESS_t*) b)->key;
+}
+
+static int compare_associations (const void *a, const void *b) {
+
+const _ASSOCIATION_t	*x = a;
+const _ASSOCIATION_t	*y = b;
+
+	if (x->address_index != y->address_index)
+		return (int) x->address_index - (int) y->address_index;
+	return (x->order < y->order) ? -1 : 1;
+}
+
+// sort the group addresses and remove duplicates, renumber the associations
+// The firmware searches sorted tables binary. The send address of each object
+// is flagged, since the first association of an object may change.
+// returns 0 if ok
+static int sort_address_table (void) {
+
+_SECTION_t		*at, *as;
+_ADDRESS_t		*addr;
+_ASSOCIATION_t	*assoc;
+uint16_t		*map;
+uint32_t		*send;
+uint32_t		n, m, i, k;
+uint16_t		index, object;
+int				sorted;
+
+	at = find_section (TOC_TYPE_ADDRESS_TABLE);
+	as = find_section (TOC_TYPE_ASSOCIATIONS);
+	if (!at)
+		return 0;
+	// without association table the object is the index of its address
+	if (!as) {
+		printf ("address table: no association table, order kept\n");
+		return 0;
+	}
+	// associations of older project files are converted by the firmware
+	if (file_version != LCD_VERSION_EXPECTED) {
+		printf ("address table: old file version, order kept\n");
+		return 0;
+	}
+
+	n = at->size / 2;
+	m = as->size / ASSOCIATION_ENTRY_SIZE;
+	addr = xmalloc (n * sizeof (_ADDRESS_t));
+	map = xmalloc (n * sizeof (uint16_t));
+	assoc = xmalloc (m * sizeof (_ASSOCIATION_t));
+	send = xmalloc ((ASSOCIATION_OBJECT_MASK +1) * sizeof (uint32_t));
+
+	// addresses are stored HB/LB
+	sorted = 1;
+	for (i = 0; i < n; i++) {
+		addr[i].key = (at->data[2*i] << 8) | at->data[2*i +1];
+		addr[i].index = i;
+		if (i && (addr[i].key <= addr[i-1].key))
+			sorted = 0;
+	}
+	qsort (addr, n, sizeof (_ADDRESS_t), compare_addresses);
+	for (i = 0, k = 0; i < n; i++) {
+		if (i && (addr[i].key != addr[i-1].key))
+			k++;
+		map[addr[i].index] = k;
+		at->data[2*k] = addr[i].key >> 8;
+		at->data[2*k +1] = addr[i].key & 0xff;
+	}
+	k = n ? k +1 : 0;
+	at->size = 2*k;
+
+	// send address chosen by init_association_table()
+	for (i = 0; i <= ASSOCIATION_OBJECT_MASK; i++)
+		send[i] = ASSOCIATION_NO_ENTRY;
+	for (i = 0; i < m; i++) {
+		index = get16 (as->data + ASSOCIATION_ENTRY_SIZE*i);
+		object = get16 (as->data + ASSOCIATION_ENTRY_SIZE*i +2);
+		if (index >= n)
+			continue;
+		if ((object & ASSOCIATION_FLAG_SEND) || (send[object & ASSOCIATION_OBJECT_MASK] == ASSOCIATION_NO_ENTRY))
+			send[object & ASSOCIATION_OBJECT_MASK] = i;
+	}
+
+	for (i = 0; i < m; i++) {
+		index = get16 (as->data + ASSOCIATION_ENTRY_SIZE*i);
+		object = get16 (as->data + ASSOCIATION_ENTRY_SIZE*i +2) & ~ASSOCIATION_FLAG_SEND;
+		assoc[i].address_index = (index < n) ? map[index] : ADDRESS_INDEX_INVALID;
+		assoc[i].object = object;
+		if (send[object & ASSOCIATION_OBJECT_MASK] == i)
+			assoc[i].object |= ASSOCIATION_FLAG_SEND;
+		assoc[i].order = i;
+	}
+	qsort (assoc, m, sizeof (_ASSOCIATION_t), compare_associations);
+	for (i = 0; i < m; i++) {
+		put16 (as->data + ASSOCIATION_ENTRY_SIZE*i, assoc[i].address_index);
+		put16 (as->data + ASSOCIATION_ENTRY_SIZE*i +2, assoc[i].object);
+	}
+
+	printf ("address table: %lu addresses, %lu duplicates removed, %s\n", (unsigned long) n,
+			(unsigned long) (n - k), sorted ? "was sorted" : "sorted now");
+
+	free (addr);
+	free (map);
+	free (assoc);
+	free (send);
+	return 0;
+}
+
+// get size of packed pixels
+// returns 0, if the packets do not fit into size Bytes
+static uint32_t packed_size (const uint8_t *p, uint32_t size, uint32_t pixels) {
+
+uint32_t	pos;
+uint32_t	n;
+uint16_t	control;
+
+	pos = 0;
+	while (pixels) {
+		if (pos + 2 > size)
+			return 0;
+		control = get16 (p + pos);
+		n = (control & ~TFT_PACKED_RUN) + 1;
+		pos += 2 + ((control & TFT_PACKED_RUN) ? 2 : 2*n);
+		pixels -= (n < pixels) ? n : pixels;
+	}
+	return (pos <= size) ? pos : 0;
+}
+
+// pack pixels into TFT_PACKED_RUN packets
+// dst: buffer of 4 * pixels + 4 Bytes
+// returns the size of the packed pixels
+static uint32_t pack (const uint8_t *src, uint32_t pixels, uint8_t *dst) {
+
+uint32_t	i, start, run;
+uint32_t	pos;
+
+	pos = 0;
+	i = 0;
+	while (i < pixels) {
+		// run of equal pixels
+		for (run = 1; (i + run < pixels) && (run < PACKED_MAX_COUNT) &&
+					  !memcmp (src + 2*i, src + 2*(i + run), 2); run++);
+		if (run >= PACKED_MIN_RUN) {
+			put16 (dst + pos, TFT_PACKED_RUN | (run -1));
+			memcpy (dst + pos +2, src + 2*i, 2);
+			pos += 4;
+			i += run;
+			continue;
+		}
+
+		// literal pixels up to the next run
+		start = i;
+		while ((i < pixels) && (i - start < PACKED_MAX_COUNT)) {
+			for (run = 1; (i + run < pixels) && (run < PACKED_MIN_RUN) &&
+						  !memcmp (src + 2*i, src + 2*(i + run), 2); run++);
+			if (run >= PACKED_MIN_RUN)
+				break;
+			i++;
+		}
+		put16 (dst + pos, i - start -1);
+		memcpy (dst + pos +2, src + 2*start, 2*(i - start));
+		pos += 2 + 2*(i - start);
+	}
+	return pos;
+}
+
+// rebuild the picture section: align pictures, remove duplicates, pack pictures
+// returns 0 if ok
+static int optimize_pictures (void) {
+
+_SECTION_t		*s;
+_PICTURE_BLOB_t	*blobs;
+uint8_t		*out;
+uint8_t		*packed;
+uint8_t		*p;
+uint32_t	table_size;
+uint32_t	count, blob_count;
+uint32_t	offset, size, pixels;
+uint32_t	out_size, out_capacity, raw_size, pos;
+uint32_t	hash;
+uint32_t	i, k;
+uint16_t	width, height;
+int			dup;
+
+	s = find_section (TOC_TYPE_PICTURES);
+	if (!s)
+		return 0;
+
+	// the pixels of the first picture follow the table, see move_picture_table()
+	if (s->size < 4) {
+		fprintf (stderr, "pictures: section too short\n");
+		return 1;
+	}
+	table_size = get32 (s->data);
+	if (!table_size || (table_size > s->size) || (table_size % PICTURE_DESCRIPTOR_SIZE)) {
+		fprintf (stderr, "pictures: invalid descriptor table\n");
+		return 1;
+	}
+	count = table_size / PICTURE_DESCRIPTOR_SIZE;
+
+	out_capacity = s->size + count * PICTURE_ALIGN;
+	out = xmalloc (out_capacity);
+	blobs = xmalloc (count * sizeof (_PICTURE_BLOB_t));
+	memcpy (out, s->data, table_size);
+	out_size = table_size;
+	blob_count = 0;
+	raw_size = 0;
+	dup = 0;
+
+	for (i = 0; i < count; i++) {
+		p = s->data + PICTURE_DESCRIPTOR_SIZE*i;
+		offset = get32 (p);
+		width = get16 (p +4);
+		height = get16 (p +6);
+		pixels = (uint32_t) (width & ~PICTURE_PACKED) * height;
+
+		if (width & PICTURE_PACKED)
+			size = (offset < s->size) ? packed_size (s->data + offset, s->size - offset, pixels) : 0;
+		else size = 2 * pixels;
+		if (pixels && (!size || (offset > s->size) || (size > s->size - offset))) {
+			fprintf (stderr, "pictures: picture %lu out of the section\n", (unsigned long) i);
+			free (out);
+			free (blobs);
+			return 1;
+		}
+		raw_size += 2 * pixels;
+
+		// pack picture, if it gets smaller
+		p = s->data + offset;
+		packed = NULL;
+		if (pack_pictures && pixels && !(width & PICTURE_PACKED)) {
+			packed = xmalloc (4 * (size_t) pixels + 4);
+			k = pack (p, pixels, packed);
+			if (k < size) {
+				p = packed;
+				size = k;
+				width |= PICTURE_PACKED;
+			}
+		}
+
+		// use the pixels of an identical picture
+		hash = hash32 (p, size);
+		for (k = 0; k < blob_count; k++)
+			if ((blobs[k].hash == hash) && (blobs[k].size == size) && (blobs[k].width == width) &&
+				(blobs[k].height == height) && !memcmp (out + blobs[k].offset, p, size))
+				break;
+		if (k < blob_count) {
+			pos = blobs[k].offset;
+			dup++;
+		}
+		else {
+			// 0xff is not programmed
+			pos = align (out_size, PICTURE_ALIGN);
+			// pictures may share pixels in the input file
+			if (pos + size > out_capacity) {
+				out_capacity = 2 * (pos + size);
+				out = realloc (out, out_capacity);
+				if (!out) {
+					fprintf (stderr, "out of memory\n");
+					exit (1);
+				}
+			}
+			memset (out + out_size, 0xff, pos - out_size);
+			memcpy (out + pos, p, size);
+			out_size = pos + size;
+			if (pixels) {
+				blobs[blob_count].hash = hash;
+				blobs[blob_count].offset = pos;
+				blobs[blob_count].size = size;
+				blobs[blob_count].width = width;
+				blobs[blob_count].height = height;
+				blob_count++;
+			}
+		}
+		free (packed);
+
+		put32 (out + PICTURE_DESCRIPTOR_SIZE*i, pos);
+		put16 (out + PICTURE_DESCRIPTOR_SIZE*i +4, width);
+	}
+
+	printf ("pictures: %lu pictures, %d duplicates removed, %lu -> %lu Bytes",
+			(unsigned long) count, dup, (unsigned long) s->size, (unsigned long) out_size);
+	if (raw_size)
+		printf (" (%lu%% of the raw pixels)", (unsigned long) ((out_size - table_size) * 100ULL / raw_size));
+	printf ("\n");
+
+	free (s->data);
+	free (blobs);
+	s->data = out;
+	s->size = out_size;
+	return 0;
+}
+
+// read project file and its sections
+// returns 0 if ok
+static int read_project (const char *name, uint8_t *header) {
+
+FILE		*f;
+uint8_t		*file;
+uint8_t		*entry;
+long		length;
+uint32_t	position;
+uint8_t		toc_items;
+uint8_t		i;
+
+	f = fopen (name, "rb");
+	if (!f) {
+		perror (name);
+		return 1;
+	}
+	fseek (f, 0, SEEK_END);
+	length = ftell (f);
+	fseek (f, 0, SEEK_SET);
+	file = xmalloc (length);
+	if ((length < LCD_HEADER_SIZE + TOC_HEADER_SIZE) || (fread (file, 1, length, f) != (size_t) length)) {
+		fprintf (stderr, "%s: file too short\n", name);
+		fclose (f);
+		return 1;
+	}
+	fclose (f);
+
+	if (memcmp (file, LCD_HEADER_MAGIC, strlen (LCD_HEADER_MAGIC))) {
+		fprintf (stderr, "%s: no project file\n", name);
+		return 1;
+	}
+	file_version = file[LCD_HEADER_VERSION];
+	if ((file_version != LCD_VERSION_EXPECTED) && (file_version != LCD_VERSION_COMPAT)) {
+		fprintf (stderr, "%s: unsupported version %#x\n", name, file_version);
+		return 1;
+	}
+	memcpy (header, file, LCD_HEADER_SIZE + TOC_HEADER_SIZE);
+
+	toc_items = file[LCD_HEADER_SIZE];
+	if (LCD_HEADER_SIZE + TOC_HEADER_SIZE + TOC_ITEMS_SIZE * (long) toc_items > length) {
+		fprintf (stderr, "%s: TOC too long\n", name);
+		return 1;
+	}
+
+	section_count = 0;
+	for (i = 0; i < toc_items; i++) {
+		entry = file + LCD_HEADER_SIZE + TOC_HEADER_SIZE + TOC_ITEMS_SIZE * i;
+		// the CRC table is built again
+		if (entry[0] == TOC_TYPE_CRC_TABLE)
+			continue;
+		position = get32 (entry +1);
+		sections[section_count].type = entry[0];
+		sections[section_count].size = get32 (entry +5);
+		if ((position > (uint32_t) length) || (sections[section_count].size > (uint32_t) length - position)) {
+			fprintf (stderr, "%s: section type %u out of the file\n", name, entry[0]);
+			return 1;
+		}
+		sections[section_count].data = xmalloc (sections[section_count].size);
+		memcpy (sections[section_count].data, file + position, sections[section_count].size);
+		section_count++;
+	}
+
+	free (file);
+	return 0;
+}
+
+// write sections with the TOC and the CRC table
+// returns 0 if ok
+static int write_project (const char *name, uint8_t *header) {
+
+FILE		*f;
+uint8_t		*out;
+uint8_t		*entry;
+uint32_t	size;
+uint32_t	crc_table;
+uint8_t		toc_items;
+uint8_t		i;
+
+	if (section_count >= TOC_MAX_ITEMS) {
+		fprintf (stderr, "too many sections\n");
+		return 1;
+	}
+	toc_items = section_count +1;
+
+	// sections are aligned for the fast picture path and the CPLD copy into XRAM
+	size = LCD_HEADER_SIZE + TOC_HEADER_SIZE + TOC_ITEMS_SIZE * toc_items;
+	for (i = 0; i < section_count; i++) {
+		size = align (size, section_align (sections[i].type));
+		sections[i].position = size;
+		size += sections[i].size;
+	}
+	size = align (size, SECTION_ALIGN);
+	crc_table = size;
+	size += 4 * toc_items;
+	if (size > FLASH_SLOT_BYTES) {
+		fprintf (stderr, "%s: %lu Bytes do not fit into a project slot\n", name, (unsigned long) size);
+		return 1;
+	}
+
+	out = xmalloc (size);
+	memset (out, 0xff, size);
+	memcpy (out, header, LCD_HEADER_SIZE + TOC_HEADER_SIZE);
+	out[LCD_HEADER_SIZE] = toc_items;
+
+	for (i = 0; i < toc_items; i++) {
+		entry = out + LCD_HEADER_SIZE + TOC_HEADER_SIZE + TOC_ITEMS_SIZE * i;
+		if (i == section_count) {
+			// CRC table is the last entry, its own CRC is not checked
+			entry[0] = TOC_TYPE_CRC_TABLE;
+			put32 (entry +1, crc_table);
+			put32 (entry +5, 4 * toc_items);
+			put32 (out + crc_table + 4*i, 0);
+			continue;
+		}
+		entry[0] = sections[i].type;
+		put32 (entry +1, sections[i].position);
+		put32 (entry +5, sections[i].size);
+		memcpy (out + sections[i].position, sections[i].data, sections[i].size);
+		put32 (out + crc_table + 4*i, crc32 (sections[i].data, sections[i].size));
+		if (verbose)
+			printf ("section type %u: %lu Bytes at %#lx\n", sections[i].type,
+					(unsigned long) sections[i].size, (unsigned long) sections[i].position);
+	}
+
+	f = fopen (name, "wb");
+	if (!f) {
+		perror (name);
+		free (out);
+		return 1;
+	}
+	if (fwrite (out, 1, size, f) != size) {
+		perror (name);
+		fclose (f);
+		free (out);
+		return 1;
+	}
+	fclose (f);
+	free (out);
+
+	printf ("%s: %lu Bytes, %u sections\n", name, (unsigned long) size, toc_items);
+	return 0;
+}
+
+static void usage (void) {
+
+	fprintf (stderr, "usage: lcdpack [-p] [-v] input.lcd output.lcd\n"
+					 "  -p  pack pictures by run length encoding\n"
+					 "  -v  verbose output\n");
+	exit (1);
+}
+
+int main (int argc, char *argv[]) {
+
+uint8_t		header[LCD_HEADER_SIZE + TOC_HEADER_SIZE];
+_SECTION_t	*s;
+int			i;
+
+	for (i = 1; (i < argc) && (argv[i][0] == '-'); i++) {
+		if (!strcmp (argv[i], "-p"))
+			pack_pictures = 1;
+		else if (!strcmp (argv[i], "-v"))
+			verbose = 1;
+		else usage ();
+	}
+	if (argc - i != 2)
+		usage ();
+
+	if (read_project (argv[i], header))
+		return 1;
+
+	// element formats of older project files are converted by the firmware
+	if (file_version == LCD_VERSION_EXPECTED) {
+		s = find_section (TOC_TYPE_PAGES);
+		if (s && validate_pages (s))
+			return 1;
+		s = find_section (TOC_TYPE_LISTEN);
+		if (s && validate_element_section ("listen", s))
+			return 1;
+		s = find_section (TOC_TYPE_CYCLIC);
+		if (s && validate_element_section ("cyclic", s))
+			return 1;
+	}
+
+	if (sort_address_table ())
+		return 1;
+	if (optimize_pictures ())
+		return 1;
+
+	return write_project (argv[i +1], header);
+}
@@ -0,0 +1,89 @@
+/** \file host.h
+ *  \brief Host environment for the tests of firmware modules
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	The tests compile firmware modules with the native compiler. This header
+ *	replaces System.h and TPUart.h, which pull in Nut/OS and the AVR headers,
+ *	by the few definitions the tested modules need. The Nut/OS functions are
+ *	declared here and faked by each test as required.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _HOST_H_
+#define _HOST_H_
+
+// skip the firmware headers replaced by this one
+#define _SYSTEM_H_
+#define TPUART_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "task.h"
+
+// AVR program memory
+#define PSTR(s)			s
+#define PROGMEM
+#define printf_P		printf
+#define sprintf_P		sprintf
+
+// Nut/OS threads and events
+typedef void*			HANDLE;
+#define THREAD(name, arg)	void name (void *arg)
+#define NUT_WAIT_INFINITE	0
+#define NutEnterCritical()
+#define NutExitCritical()
+
+void NutEventPost (HANDLE*);
+int NutEventWait (HANDLE*, uint32_t);
+void NutThreadSetPriority (uint8_t);
+void NutThreadExit (void);
+void NutThreadYield (void);
+void NutSleep (uint32_t);
+uint32_t NutGetSeconds (void);
+uint32_t NutGetMillis (void);
+HANDLE sysmon_thread_create (char*, void (*)(void*), void*, size_t);
+
+// Nut/OS network
+typedef struct {
+uint32_t	if_local_ip;
+} IFNET;
+typedef struct {
+void		*dev_icb;
+} NUTDEVICE;
+typedef void			UDPSOCKET;
+extern NUTDEVICE		DEV_ETHER;
+#define DEV_ETHER_NAME	"eth0"
+
+int NutRegisterDevice (NUTDEVICE*, uintptr_t, uint8_t);
+int NutDhcpIfConfig (const char*, uint8_t*, uint32_t);
+UDPSOCKET* NutUdpCreateSocket (uint16_t);
+int NutUdpSendTo (UDPSOCKET*, uint32_t, uint16_t, void*, uint16_t);
+int NutUdpReceiveFrom (UDPSOCKET*, uint32_t*, uint16_t*, void*, uint16_t, uint32_t);
+
+// TPUART Link Layer, see TPUart.h
+#define FRAME_LEN		23
+#define EIB_TX_BUFFERS	8
+typedef struct {
+	int8_t 		len;
+	uint8_t		ack;
+	uint8_t 	frame[FRAME_LEN];
+} t_eib_frame;
+
+char eib_L_DATA_request (t_eib_frame*, uint8_t);
+uint8_t eib_set_device_address (uint8_t, uint16_t);
+uint16_t eib_get_device_address (uint8_t);
+
+// result of a test, counts the failed checks
+extern int test_failed;
+#define CHECK(cond)	do { if (!(cond)) { printf ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); test_failed++; } } while (0)
+
+#endif // _HOST_H_
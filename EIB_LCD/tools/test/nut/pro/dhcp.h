@@ -0,0 +1 @@
+// Nut/OS header for the host tests, the declarations are in host.h
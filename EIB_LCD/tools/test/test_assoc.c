@@ -0,0 +1,166 @@
+/** \file test_assoc.c
+ *  \brief Host test of the association of objects and group addresses
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	assoc_tab.c and EIBObjects.c are compiled with an emulated XRAM. The
+ *	association table is loaded from an emulated Flash and maps group
+ *	addresses to objects, one association points beyond the objects of the
+ *	project. Group messages must update the objects of the project only.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "host.h"
+#include "MemoryMap.h"
+#include "crc.h"
+#include "EIBLayers.h"
+#include "dpt.h"
+#include "compat.h"
+#include "assoc_tab.h"
+#include "EIBObjects.h"
+
+#define ADDRESSES		4
+#define OBJECTS			3
+#define XRAM_BANKS		16
+// object beyond the objects of the project
+#define BAD_OBJECT		0x0800
+
+// emulated XRAM
+static uint8_t	host_xram_banks[XRAM_BANKS][XRAM_BANK_SIZE];
+static uint8_t	host_xram_bank;
+
+#undef XRAM_BASE_ADDRESS
+#define XRAM_BASE_ADDRESS	((uintptr_t) host_xram_banks[host_xram_bank])
+#define	XRAM_SELECT_BLOCK(blk)		(host_xram_bank = (blk))
+#define	XRAM_GET_SELECTED_BLOCK		host_xram_bank
+
+#define min(a,b)  ( (a)<(b) ? (a) : (b) )
+#define max(a,b)  ( (a)>(b) ? (a) : (b) )
+
+// see System.h
+#define LCD_VERSION_EXPECTED	0x1F
+#define LCD_VERSION_COMPAT		0x1E
+void copy_Flash_to_XRAM_check (uint8_t, uint16_t, uint8_t, uint16_t, uint16_t, uint32_t*, uint8_t*);
+// see addr_tab.h
+int get_group_adress_index (uint16_t);
+uint16_t get_address_tab_length (void);
+uint16_t get_group_address (uint16_t);
+void xram_yield (void);
+void read_sweep_object_received (uint16_t);
+void snapshot_object_changed (void);
+
+uint8_t lcd_file_version = LCD_VERSION_EXPECTED;
+
+#include "dpt.c"
+#include "assoc_tab.c"
+#include "EIBObjects.c"
+
+int test_failed;
+
+// association table in the emulated Flash:
+// address 0: object 1, address 1: BAD_OBJECT, address 2: objects 2 and BAD_OBJECT, address 3: object 0
+static _ASSOCIATION_ENTRY_t	flash_associations[] = {
+	{ 0, 1 },
+	{ 1, BAD_OBJECT | ASSOCIATION_FLAG_SEND },
+	{ 2, 2 },
+	{ 2, BAD_OBJECT },
+	{ 3, 0 },
+};
+
+// objects received by the read sweep
+static uint16_t	received[OBJECTS];
+
+
+void copy_Flash_to_XRAM_check (uint8_t sector, uint16_t addr, uint8_t bank, uint16_t dst, uint16_t size, uint32_t *crc, uint8_t *checksum) {
+
+	memcpy (host_xram_banks[bank] + dst, (uint8_t*) flash_associations + addr, size);
+}
+
+uint8_t crc_verify (uint32_t start, uint32_t size, uint32_t crc, uint32_t pos) {
+
+	return CRC_MISSING;
+}
+
+void compat_convert_associations (uint16_t count) {
+}
+
+char eib_G_DATA_request (uint16_t address, uint8_t *data, uint8_t len) {
+
+	return 1;
+}
+
+// group address n has index n
+int get_group_adress_index (uint16_t address) {
+
+	return (address < ADDRESSES) ? address : -1;
+}
+
+uint16_t get_address_tab_length (void) {
+
+	return ADDRESSES;
+}
+
+uint16_t get_group_address (uint16_t index) {
+
+	return index;
+}
+
+void read_sweep_object_received (uint16_t object) {
+
+	CHECK (object < OBJECTS);
+	if (object < OBJECTS)
+		received[object]++;
+}
+
+void snapshot_object_changed (void) {
+}
+
+void xram_yield (void) {
+}
+
+
+int main (void) {
+
+uint16_t	objects[EIB_MAX_MSG_OBJECTS];
+uint8_t		data[1];
+uint8_t		*ps;
+
+	CHECK (move_association_table (0, sizeof (flash_associations)) == 0);
+	init_association_table ();
+	CHECK (get_object_count () == OBJECTS);
+
+	// one byte per object
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
+	ps = (uint8_t*) (XRAM_BASE_ADDRESS + EIB_OBJECT_SIZE_TABLE);
+	memset (ps, 1, OBJECTS);
+	object_size_count = OBJECTS;
+	eib_object_init ();
+
+	// the association to BAD_OBJECT is skipped
+	CHECK (get_associated_objects (0, objects, EIB_MAX_MSG_OBJECTS) == 1);
+	CHECK (objects[0] == 1);
+	CHECK (get_associated_objects (1, objects, EIB_MAX_MSG_OBJECTS) == 0);
+	CHECK (get_associated_objects (2, objects, EIB_MAX_MSG_OBJECTS) == 1);
+	CHECK (objects[0] == 2);
+	CHECK (get_associated_objects (3, objects, EIB_MAX_MSG_OBJECTS) == 1);
+	CHECK (objects[0] == 0);
+	CHECK (get_object_send_address (BAD_OBJECT) == 0);
+
+	// messages only update the objects of the project
+	data[0] = 0x55;
+	CHECK (eib_objects_process_msg (1, data, sizeof (data), APCI_VALUE_WRITE) == 0);
+	CHECK (eib_objects_process_msg (2, data, sizeof (data), APCI_VALUE_WRITE) == 1);
+	CHECK (eib_object_addressed (2));
+	CHECK (eib_object_changed (2));
+	CHECK (eib_get_object_8_value (2) == 0x55);
+	CHECK (received[2] == 1);
+	CHECK (eib_objects_process_msg (1, data, sizeof (data), APCI_VALUE_WRITE) == 0);
+	CHECK (!eib_object_changed (2));
+
+	printf ("test_assoc: %s\n", test_failed ? "FAILED" : "ok");
+	return test_failed ? 1 : 0;
+}
@@ -0,0 +1,314 @@
+/** \file test_dpt.c
+ *  \brief Host test of the datapoint type codec
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Checks encoding and decoding of DPT 5, 5.001, 7, 9 and 14 at their
+ *	edge values, round trips over the value range and the string format
+ *	of the value element.
+ *
+ *	Benchmarks the DPT 9 value path of the value element and the sending of
+ *	DPT 9 values against the float code the codec replaced. The times are
+ *	measured on the host, which has a float unit; the soft-float code of the
+ *	AVR is slower in relation.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include <time.h>
+#include "host.h"
+#include "dpt.h"
+#include "dpt.c"
+
+// runs of the benchmark over all DPT 9 values
+#define BENCH_RUNS			20
+#define MAX_EIS5_MANTISSA	20.47
+#define MIN_EIS5_MANTISSA	-20.48
+
+int test_failed;
+
+// encodes value and checks the data on the bus
+static void check_encode (uint8_t dpt, int32_t value, uint32_t expected) {
+
+uint8_t		data[DPT_MAX_SIZE];
+uint8_t		len;
+uint32_t	raw;
+
+	len = dpt_encode (dpt, value, data);
+	raw = dpt_get_int (data, len);
+	if (raw != expected) {
+		printf ("dpt %u: %ld encoded as %#lx, expected %#lx\n", dpt, (long) value, (unsigned long) raw, (unsigned long) expected);
+		test_failed++;
+	}
+}
+
+// decodes data on the bus and checks the value
+static void check_decode (uint8_t dpt, uint32_t raw, int32_t expected) {
+
+uint8_t	data[DPT_MAX_SIZE];
+int32_t	value;
+
+	dpt_put_int (data, raw, dpt_codec[dpt].length);
+	value = dpt_decode (dpt, data);
+	if (value != expected) {
+		printf ("dpt %u: %#lx decoded as %ld, expected %ld\n", dpt, (unsigned long) raw, (long) value, (long) expected);
+		test_failed++;
+	}
+}
+
+static void check_format (uint8_t dpt, int32_t value, uint8_t integers, uint8_t decimals, const char *expected) {
+
+uint8_t	data[DPT_MAX_SIZE];
+char	str[32];
+
+	dpt_encode (dpt, value, data);
+	dpt_format (str, dpt, data, integers, decimals);
+	if (strcmp (str, expected)) {
+		printf ("dpt %u: %ld formatted as \"%s\", expected \"%s\"\n", dpt, (long) value, str, expected);
+		test_failed++;
+	}
+}
+
+// float decoder of EIBObjects.c before the codec
+static float legacy_eis5_decode (uint8_t *data) {
+
+uint16_t val;
+int16_t	x;
+uint8_t	exp;
+
+	val = (data[0] << 8) | data[1];
+	x = val & 0x7ff;
+	if (val & 0x8000) {
+		x |= 0xf800;
+	}
+	exp = (val >> 11) & 0x0f;
+	return ldexp (x, exp) / 100;
+}
+
+// float encoder of EIBObjects.c before the codec
+static void legacy_eis5_encode (float fval, uint8_t *eib_value) {
+
+uint8_t	exp;
+int16_t ival;
+
+	if (fval >= 0)
+		eib_value [0] = 0x00;
+	else eib_value [0] = 0x80;
+
+	exp = 0;
+	while ((fval > MAX_EIS5_MANTISSA) || (fval < MIN_EIS5_MANTISSA)) {
+		exp++;
+		fval /= 2;
+	}
+	eib_value[0] |= (exp << 3) & 0x78;
+	ival = round (100*fval);
+	eib_value[1] = ival & 0xff;
+	eib_value[0] |= (ival >> 8) & 0x07;
+}
+
+// time since start [ns]
+static double bench_time (struct timespec *start) {
+
+struct timespec	now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e9 + (now.tv_nsec - start->tv_nsec);
+}
+
+// compares the DPT 9 value paths of the value element and the sending of values
+static void benchmark (void) {
+
+struct timespec	start;
+uint8_t		data[DPT_MAX_SIZE];
+char		str[32];
+double		t_float, t_codec;
+uint32_t	raw;
+uint32_t	n;
+int32_t		v;
+uint8_t		run;
+volatile uint32_t	sink = 0;
+
+	// both decoders return the same value within the float precision
+	for (raw = 0; raw <= 0xffff; raw++) {
+		dpt_put_int (data, raw, 2);
+		v = dpt_decode (DPT_9, data);
+		if (labs (lround ((double) legacy_eis5_decode (data) * DPT_CENTI_SCALE) - v) > labs (v) / 8000000 +1) {
+			printf ("dpt 9: %#lx decoded differently by the float code\n", (unsigned long) raw);
+			test_failed++;
+			break;
+		}
+	}
+
+	// decode and format like draw_value_element(), 3 integers and 1 decimal
+	n = 0;
+	clock_gettime (CLOCK_MONOTONIC, &start);
+	for (run = 0; run < BENCH_RUNS; run++)
+		for (raw = 0; raw <= 0xffff; raw++, n++) {
+			dpt_put_int (data, raw, 2);
+			sprintf (str, "% *.*f", 3+1+2, 1, legacy_eis5_decode (data));
+			sink += str[0];
+		}
+	t_float = bench_time (&start) / n;
+	clock_gettime (CLOCK_MONOTONIC, &start);
+	for (run = 0; run < BENCH_RUNS; run++)
+		for (raw = 0; raw <= 0xffff; raw++) {
+			dpt_put_int (data, raw, 2);
+			dpt_format (str, DPT_9, data, 3, 1);
+			sink += str[0];
+		}
+	t_codec = bench_time (&start) / n;
+	printf ("  DPT 9 format: float %.1f ns, codec %.1f ns\n", t_float, t_codec);
+
+	// encode values in 1/100 like the sending elements
+	n = 0;
+	clock_gettime (CLOCK_MONOTONIC, &start);
+	for (run = 0; run < BENCH_RUNS; run++)
+		for (raw = 0; raw <= 0xffff; raw++, n++) {
+			legacy_eis5_encode (((int32_t) raw - 0x8000) / 4.0, data);
+			sink += data[0];
+		}
+	t_float = bench_time (&start) / n;
+	clock_gettime (CLOCK_MONOTONIC, &start);
+	for (run = 0; run < BENCH_RUNS; run++)
+		for (raw = 0; raw <= 0xffff; raw++) {
+			dpt_encode (DPT_9, ((int32_t) raw - 0x8000) * 25, data);
+			sink += data[0];
+		}
+	t_codec = bench_time (&start) / n;
+	printf ("  DPT 9 encode: float %.1f ns, codec %.1f ns\n", t_float, t_codec);
+}
+
+// decodes IEEE 754 data into 1/100 by the host float arithmetic
+static double float32_centi (uint8_t *data) {
+
+uint32_t	raw;
+float		f;
+
+	raw = dpt_get_int (data, 4);
+	memcpy (&f, &raw, sizeof (f));
+	return (double) f * DPT_CENTI_SCALE;
+}
+
+
+int main (void) {
+
+uint8_t		data[DPT_MAX_SIZE];
+int32_t		v, r;
+uint8_t		exp;
+double		f;
+
+	// DPT 5: 8 bit unsigned
+	check_encode (DPT_5, 0, 0x00);
+	check_encode (DPT_5, 1, 0x01);
+	check_encode (DPT_5, 254, 0xfe);
+	check_encode (DPT_5, 255, 0xff);
+	check_decode (DPT_5, 0xff, 255);
+	for (v = 0; v <= 255; v++) {
+		dpt_encode (DPT_5, v, data);
+		CHECK (dpt_decode (DPT_5, data) == v);
+	}
+
+	// DPT 5.001: 0..100% scaled to 0..255
+	check_encode (DPT_5_001, 0, 0x00);
+	check_encode (DPT_5_001, 50, 0x80);
+	check_encode (DPT_5_001, 100, 0xff);
+	check_encode (DPT_5_001, -1, 0x00);
+	check_encode (DPT_5_001, 101, 0xff);
+	check_decode (DPT_5_001, 0x00, 0);
+	check_decode (DPT_5_001, 0x01, 0);
+	check_decode (DPT_5_001, 0x80, 50);
+	check_decode (DPT_5_001, 0xfe, 100);
+	check_decode (DPT_5_001, 0xff, 100);
+	for (v = 0; v <= 100; v++) {
+		dpt_encode (DPT_5_001, v, data);
+		CHECK (dpt_decode (DPT_5_001, data) == v);
+	}
+
+	// DPT 7: 16 bit unsigned, big endian
+	check_encode (DPT_7, 0, 0x0000);
+	check_encode (DPT_7, 0x1234, 0x1234);
+	check_encode (DPT_7, 0x7fff, 0x7fff);
+	check_encode (DPT_7, 0x8000, 0x8000);
+	check_encode (DPT_7, 0xffff, 0xffff);
+	check_decode (DPT_7, 0x8000, 0x8000);
+	check_decode (DPT_7, 0xffff, 0xffff);
+	for (v = 0; v <= 0xffff; v++) {
+		dpt_encode (DPT_7, v, data);
+		CHECK (dpt_decode (DPT_7, data) == v);
+	}
+
+	// DPT 9: 16 bit float in 1/100
+	check_encode (DPT_9, 0, 0x0000);
+	check_encode (DPT_9, 2150, 0x0c33);
+	check_encode (DPT_9, -1, 0x87ff);
+	check_encode (DPT_9, 2047, 0x07ff);
+	check_encode (DPT_9, -2048, 0x8000);
+	check_encode (DPT_9, 2048, 0x0c00);
+	check_encode (DPT_9, DPT_9_MAX, 0x7ffe);
+	check_encode (DPT_9, DPT_9_MIN, 0xf800);
+	check_encode (DPT_9, DPT_9_MAX +1000, 0x7ffe);
+	check_encode (DPT_9, DPT_9_MIN -1000, 0xf800);
+	check_decode (DPT_9, 0x0c33, 2150);
+	check_decode (DPT_9, 0x87ff, -1);
+	check_decode (DPT_9, 0x7ffe, DPT_9_MAX);
+	check_decode (DPT_9, 0xf800, DPT_9_MIN);
+	// round trip error is at most half a step of the exponent
+	for (v = DPT_9_MIN; v <= DPT_9_MAX; v += (labs (v) < 100000) ? 1 : 997) {
+		dpt_encode (DPT_9, v, data);
+		r = dpt_decode (DPT_9, data);
+		exp = (data[0] >> 3) & 0x0f;
+		if (labs (r - v) > ((1L << exp) >> 1)) {
+			printf ("dpt 9: %ld decoded as %ld\n", (long) v, (long) r);
+			test_failed++;
+			break;
+		}
+	}
+
+	// DPT 14: IEEE 754 float in 1/100
+	check_encode (DPT_14, 0, 0x00000000);
+	check_encode (DPT_14, 100, 0x3f800000);
+	check_encode (DPT_14, -100, 0xbf800000);
+	check_encode (DPT_14, 2150, 0x41ac0000);
+	check_encode (DPT_14, 1, 0x3c23d70a);
+	check_decode (DPT_14, 0x3f800000, 100);
+	check_decode (DPT_14, 0xbf800000, -100);
+	check_decode (DPT_14, 0x41ac0000, 2150);
+	check_decode (DPT_14, 0x3c23d70a, 1);
+	// values out of the fixed point range saturate, tiny values are 0
+	check_decode (DPT_14, 0x7f7fffff, 0x7fffffffL);
+	check_decode (DPT_14, 0xff7fffff, -0x7fffffffL);
+	check_decode (DPT_14, 0x3727c5ac, 0);
+	check_decode (DPT_14, 0x00000001, 0);
+	// the encoder rounds like the host float conversion, the decoder returns the value again
+	for (v = -2147483647L; v < 2147483647L - 9973; v += (labs (v) < 100000) ? 1 : 9973) {
+		dpt_encode (DPT_14, v, data);
+		f = float32_centi (data);
+		r = dpt_decode (DPT_14, data);
+		if ((fabs (f - v) > fabs ((double) v) * 6e-8 + 1e-9) || (labs (r - v) > labs (v) / 8000000 +1)) {
+			printf ("dpt 14: %ld encoded as %f, decoded as %ld\n", (long) v, f, (long) r);
+			test_failed++;
+			break;
+		}
+	}
+	// 21474836.47 is rounded to the float 21474836
+	check_encode (DPT_14, 0x7fffffffL, 0x4ba3d70a);
+	check_decode (DPT_14, 0x4ba3d70a, 2147483600L);
+
+	// value element formats
+	check_format (DPT_9, 2150, 3, 1, "  21.5");
+	check_format (DPT_9, -500, 2, 2, " -5.00");
+	check_format (DPT_9, 2150, 2, 3, " 21.500");
+	check_format (DPT_5, 7, 3, 3, "007");
+	check_format (DPT_5_001, 100, 4, 0, " 100");
+	check_format (DPT_7, 1234, 6, DPT_DIGITS_ANY, "  1234");
+	check_format (DPT_7, 0, 3, DPT_DIGITS_ANY, "  0");
+	check_format (DPT_13, -1234, 6, DPT_DIGITS_ANY, " -1234");
+
+	benchmark ();
+
+	printf ("test_dpt: %s\n", test_failed ? "FAILED" : "ok");
+	return test_failed ? 1 : 0;
+}
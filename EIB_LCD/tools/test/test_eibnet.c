@@ -0,0 +1,327 @@
+/** \file test_eibnet.c
+ *  \brief Host loopback test of the KNXnet/IP tunneling server
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	EIBNet.c is compiled with fake UDP sockets and a fake TPUART Link Layer.
+ *	The test plays the tunnel client: it connects, sends cEMI frames, confirms
+ *	them by the Link Layer and checks the frames sent back by the server.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#define EIBNET_SUPPORT
+#include "host.h"
+#include "EIBLayers.h"
+#include "EIBNet.h"
+#include "EIBNet.c"
+
+#define CLIENT_ADDR		0x0201a8c0UL
+#define CLIENT_PORT		50000
+
+int test_failed;
+
+NUTDEVICE DEV_ETHER;
+static IFNET eth_if = { 0x0a01a8c0UL };
+
+// fake Link Layer
+static uint16_t		device_address[2];
+static t_eib_frame	bus_frame;		// last frame sent to the bus
+static int			bus_count;		// number of frames sent to the bus
+static uint8_t		bus_full;		// TX queue of the Link Layer is full
+
+// fake UDP socket
+static uint8_t		udp_frame[EIBNET_FRAME_SIZE];	// last datagram sent
+static int			udp_len;
+static int			udp_count;
+
+// the client acknowledges each TUNNELLING_REQUEST of the server
+static uint8_t		client_acks;
+
+
+void NutEventPost (HANDLE *h) {
+}
+
+// the server waits for the ACK of the client
+int NutEventWait (HANDLE *h, uint32_t timeout) {
+
+uint8_t	ack[EIBNET_HEADER_SIZE + EIBNET_CONNECTION_HEADER_SIZE];
+
+	if ((h == &eibnet_ack_event) && client_acks) {
+		eibnet_set_header (ack, EIBNET_TUNNELLING_ACK, sizeof (ack));
+		ack[6] = EIBNET_CONNECTION_HEADER_SIZE;
+		ack[7] = EIBNET_CHANNEL_ID;
+		ack[8] = udp_frame[8];
+		ack[9] = EIBNET_E_NO_ERROR;
+		eibnet_process_frame (ack, sizeof (ack), CLIENT_ADDR, CLIENT_PORT);
+	}
+	return 0;
+}
+
+void NutThreadSetPriority (uint8_t prio) {
+}
+
+void NutThreadExit (void) {
+}
+
+uint32_t NutGetSeconds (void) {
+
+	return 100;
+}
+
+HANDLE sysmon_thread_create (char *name, void (*fn)(void*), void *arg, size_t stack) {
+
+	return 0;
+}
+
+// the server threads are not run by the test
+int NutRegisterDevice (NUTDEVICE *dev, uintptr_t base, uint8_t irq) {
+
+	return -1;
+}
+
+int NutDhcpIfConfig (const char *name, uint8_t *mac, uint32_t timeout) {
+
+	return -1;
+}
+
+UDPSOCKET* NutUdpCreateSocket (uint16_t port) {
+
+	return NULL;
+}
+
+int NutUdpReceiveFrom (UDPSOCKET *sock, uint32_t *addr, uint16_t *port, void *data, uint16_t size, uint32_t timeout) {
+
+	return 0;
+}
+
+int NutUdpSendTo (UDPSOCKET *sock, uint32_t addr, uint16_t port, void *data, uint16_t len) {
+
+	memcpy (udp_frame, data, len);
+	udp_len = len;
+	udp_count++;
+	return 0;
+}
+
+char eib_L_DATA_request (t_eib_frame *msg, uint8_t channel) {
+
+	if (bus_full)
+		return 0;
+	memcpy (&bus_frame, msg, sizeof (t_eib_frame));
+	bus_frame.frame[EIB_SRC_ADDRESS_HIGH] = device_address[channel] & 0xff;
+	bus_frame.frame[EIB_SRC_ADDRESS_LOW] = device_address[channel] >> 8;
+	bus_count++;
+	return 1;
+}
+
+uint8_t eib_set_device_address (uint8_t channel, uint16_t address) {
+
+	device_address[channel] = address;
+	return 1;
+}
+
+uint16_t eib_get_device_address (uint8_t channel) {
+
+	return device_address[channel];
+}
+
+
+// sends a service to the server, which consists of channel ID and HPAI
+static void client_send_channel_request (uint16_t service) {
+
+uint8_t	p[EIBNET_HEADER_SIZE + 2 + EIBNET_HPAI_SIZE];
+
+	eibnet_set_header (p, service, sizeof (p));
+	p[6] = EIBNET_CHANNEL_ID;
+	p[7] = 0;
+	memset (&p[8], 0, EIBNET_HPAI_SIZE);
+	p[8] = EIBNET_HPAI_SIZE;
+	p[9] = EIBNET_HPAI_UDP;
+	eibnet_process_frame (p, sizeof (p), CLIENT_ADDR, CLIENT_PORT);
+}
+
+static void client_connect (void) {
+
+uint8_t	p[EIBNET_HEADER_SIZE + 2*EIBNET_HPAI_SIZE + 4];
+
+	eibnet_set_header (p, EIBNET_CONNECT_REQUEST, sizeof (p));
+	// NAT mode: empty HPAI for control and data endpoint
+	memset (&p[6], 0, 2*EIBNET_HPAI_SIZE);
+	p[6] = p[14] = EIBNET_HPAI_SIZE;
+	p[7] = p[15] = EIBNET_HPAI_UDP;
+	p[22] = 4;
+	p[23] = EIBNET_TUNNEL_CONNECTION;
+	p[24] = EIBNET_TUNNEL_LINKLAYER;
+	p[25] = 0;
+	eibnet_process_frame (p, sizeof (p), CLIENT_ADDR, CLIENT_PORT);
+}
+
+// sends a GroupValueWrite of a 1 bit value to the group address 1/2/3
+static void client_send_write (uint8_t sequence, uint8_t value) {
+
+uint8_t	p[EIBNET_HEADER_SIZE + EIBNET_CONNECTION_HEADER_SIZE + 11];
+
+	eibnet_set_header (p, EIBNET_TUNNELLING_REQUEST, sizeof (p));
+	p[6] = EIBNET_CONNECTION_HEADER_SIZE;
+	p[7] = EIBNET_CHANNEL_ID;
+	p[8] = sequence;
+	p[9] = 0;
+	p[10] = CEMI_L_DATA_REQ;
+	p[11] = 0;
+	p[12] = 0xBC;
+	p[13] = 0xE0;
+	p[14] = 0;
+	p[15] = 0;
+	p[16] = 0x0a;
+	p[17] = 0x03;
+	p[18] = 1;
+	p[19] = 0x00;
+	p[20] = 0x80 | value;
+	eibnet_process_frame (p, sizeof (p), CLIENT_ADDR, CLIENT_PORT);
+}
+
+// checks the last datagram of the server for a TUNNELLING_REQUEST with the cEMI code
+static void check_tunnelling_request (uint8_t code, uint8_t sequence) {
+
+	CHECK (((udp_frame[2] << 8) | udp_frame[3]) == EIBNET_TUNNELLING_REQUEST);
+	CHECK (udp_frame[7] == EIBNET_CHANNEL_ID);
+	CHECK (udp_frame[8] == sequence);
+	CHECK (udp_frame[10] == code);
+}
+
+static uint8_t queued (void) {
+
+	return (eibnet_queue_in + EIBNET_IND_BUFFERS - eibnet_queue_out) % EIBNET_IND_BUFFERS;
+}
+
+
+int main (void) {
+
+t_eib_frame	msg;
+int			n;
+
+	DEV_ETHER.dev_icb = &eth_if;
+
+	// tunnel address in the line of the panel, device number 0 is skipped
+	CHECK (eibnet_tunnel_address (0x0511) == 0x0611);
+	CHECK (eibnet_tunnel_address (0xfe11) == 0xff11);
+	CHECK (eibnet_tunnel_address (0xff11) == 0x0111);
+
+	eib_set_device_address (EIB_DEVICE_CHANNEL, 0x0511);
+	eib_set_device_address (EIB_EIBNET_CHANNEL, eibnet_tunnel_address (0x0511));
+	eibnet_init ();
+	client_acks = 1;
+
+	// connect
+	client_connect ();
+	CHECK (eibnet_connected);
+	CHECK (((udp_frame[2] << 8) | udp_frame[3]) == EIBNET_CONNECT_RESPONSE);
+	CHECK (udp_frame[6] == EIBNET_CHANNEL_ID);
+	CHECK (udp_frame[7] == EIBNET_E_NO_ERROR);
+	CHECK ((udp_frame[18] == 0x11) && (udp_frame[19] == 0x06));
+	// a second client is rejected
+	client_connect ();
+	CHECK (udp_frame[7] == EIBNET_E_NO_MORE_CONNECTIONS);
+
+	// the request is acknowledged and sent to the bus, but not yet confirmed
+	client_send_write (0, 1);
+	CHECK (((udp_frame[2] << 8) | udp_frame[3]) == EIBNET_TUNNELLING_ACK);
+	CHECK ((udp_frame[8] == 0) && (udp_frame[9] == EIBNET_E_NO_ERROR));
+	CHECK (bus_count == 1);
+	CHECK ((bus_frame.frame[EIB_DEST_ADDRESS_HIGH] == 0x0a) && (bus_frame.frame[EIB_DEST_ADDRESS_LOW] == 0x03));
+	CHECK ((bus_frame.frame[EIB_SRC_ADDRESS_HIGH] == 0x11) && (bus_frame.frame[EIB_SRC_ADDRESS_LOW] == 0x06));
+	CHECK (bus_frame.frame[7] == 0x81);
+	CHECK (queued () == 0);
+
+	// negative confirm of the TPUART
+	eibnet_L_DATA_confirm (0);
+	CHECK (queued () == 1);
+	eibnet_send_queued ();
+	check_tunnelling_request (CEMI_L_DATA_CON, 0);
+	CHECK (udp_frame[12] & CEMI_CTRL1_CONFIRM_ERROR);
+	CHECK ((udp_frame[14] == 0x11) && (udp_frame[15] == 0x06));
+	CHECK ((udp_frame[16] == 0x0a) && (udp_frame[17] == 0x03));
+
+	// positive confirm
+	client_send_write (1, 0);
+	CHECK (bus_count == 2);
+	eibnet_L_DATA_confirm (1);
+	eibnet_send_queued ();
+	check_tunnelling_request (CEMI_L_DATA_CON, 1);
+	CHECK (!(udp_frame[12] & CEMI_CTRL1_CONFIRM_ERROR));
+
+	// repeated request is acknowledged again, but not sent to the bus
+	n = udp_count;
+	client_send_write (1, 0);
+	CHECK (udp_count == n +1);
+	CHECK (((udp_frame[2] << 8) | udp_frame[3]) == EIBNET_TUNNELLING_ACK);
+	CHECK (bus_count == 2);
+	// out of sequence request is discarded
+	client_send_write (5, 0);
+	CHECK (udp_count == n +1);
+	CHECK (bus_count == 2);
+
+	// full TX queue of the Link Layer: negative confirm at once
+	bus_full = 1;
+	client_send_write (2, 1);
+	bus_full = 0;
+	CHECK (bus_count == 2);
+	CHECK (queued () == 1);
+	eibnet_send_queued ();
+	check_tunnelling_request (CEMI_L_DATA_CON, 2);
+	CHECK (udp_frame[12] & CEMI_CTRL1_CONFIRM_ERROR);
+	// no confirm is pending for this frame
+	eibnet_L_DATA_confirm (1);
+	CHECK (queued () == 0);
+
+	// bus messages are indicated, the echo of frames of the tunnel is not
+	memset (&msg, 0, sizeof (msg));
+	msg.frame[0] = 0xBC;
+	msg.frame[EIB_SRC_ADDRESS_HIGH] = 0x11;
+	msg.frame[EIB_SRC_ADDRESS_LOW] = 0x20;
+	msg.frame[EIB_DEST_ADDRESS_HIGH] = 0x0a;
+	msg.frame[EIB_DEST_ADDRESS_LOW] = 0x03;
+	msg.frame[5] = 0xE1;
+	msg.frame[7] = 0x80;
+	msg.len = 8;
+	eibnet_L_DATA_indication (&msg);
+	CHECK (queued () == 1);
+	eibnet_send_queued ();
+	check_tunnelling_request (CEMI_L_DATA_IND, 3);
+	CHECK ((udp_frame[14] == 0x11) && (udp_frame[15] == 0x20));
+	memcpy (&msg, &bus_frame, sizeof (msg));
+	eibnet_L_DATA_indication (&msg);
+	CHECK (queued () == 0);
+
+	// a frame of a closed connection is not confirmed to the next client
+	client_send_write (3, 1);
+	CHECK (bus_count == 3);
+	client_send_channel_request (EIBNET_DISCONNECT_REQUEST);
+	CHECK (!eibnet_connected);
+	client_connect ();
+	CHECK (eibnet_connected);
+	eibnet_L_DATA_confirm (1);
+	CHECK (queued () == 0);
+	CHECK (eibnet_con_in == eibnet_con_out);
+
+	// heartbeat
+	client_send_channel_request (EIBNET_CONNECTIONSTATE_REQUEST);
+	CHECK (((udp_frame[2] << 8) | udp_frame[3]) == EIBNET_CONNECTIONSTATE_RESPONSE);
+	CHECK (udp_frame[7] == EIBNET_E_NO_ERROR);
+
+	// the client does not acknowledge: the request is repeated once, then the tunnel is closed
+	client_acks = 0;
+	client_send_write (0, 1);
+	eibnet_L_DATA_confirm (1);
+	n = udp_count;
+	eibnet_send_queued ();
+	CHECK (udp_count == n +3);
+	CHECK (((udp_frame[2] << 8) | udp_frame[3]) == EIBNET_DISCONNECT_REQUEST);
+	CHECK (!eibnet_connected);
+
+	printf ("test_eibnet: %s\n", test_failed ? "FAILED" : "ok");
+	return test_failed ? 1 : 0;
+}
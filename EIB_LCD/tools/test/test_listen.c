@@ -0,0 +1,313 @@
+/** \file test_listen.c
+ *  \brief Host benchmark of the group message dispatch to listen elements
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	listen.c and xram.c are compiled with an emulated XRAM: the window at
+ *	XRAM_BASE_ADDRESS is copied, when another bank is selected. The test loads
+ *	500 listen elements and sends a group message to every object. It checks,
+ *	that the registry calls the same elements as the walk over all elements
+ *	before the registry, and prints the element checks and the CPLD bank writes
+ *	of both. These are the costs of the dispatch on the target.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "host.h"
+#include "MemoryMap.h"
+#include "xram.h"
+#include "crc.h"
+#include "NandFlash.h"
+#include "compat.h"
+#include "EIBObjects.h"
+#include "listen.h"
+#include "o_backlight.h"
+#include "o_led.h"
+#include "o_warning.h"
+#include "o_timeout.h"
+
+#define LISTEN_ELEMENTS		500
+#define XRAM_BANKS			64
+
+// emulated XRAM, the window holds the selected bank
+static uint8_t	host_xram_window[XRAM_BANK_SIZE];
+static uint8_t	host_xram_banks[XRAM_BANKS][XRAM_BANK_SIZE];
+
+#undef XRAM_BASE_ADDRESS
+#define XRAM_BASE_ADDRESS	((uintptr_t) host_xram_window)
+#define	XRAM_SELECT_BLOCK(blk)		host_xram_select (blk)
+#define	XRAM_GET_SELECTED_BLOCK		xram_bank
+
+uint8_t	xram_bank;
+uint16_t xram_bank_writes;
+
+static void host_xram_select (uint8_t bank) {
+
+	if (bank == xram_bank)
+		return;
+	if (xram_bank < XRAM_BANKS)
+		memcpy (host_xram_banks[xram_bank], host_xram_window, XRAM_BANK_SIZE);
+	memcpy (host_xram_window, host_xram_banks[bank], XRAM_BANK_SIZE);
+	xram_bank = bank;
+	xram_bank_writes++;
+}
+
+// see System.h
+#define LCD_VERSION_COMPAT	0x1E
+void copy_Flash_to_XRAM_check (uint8_t, uint16_t, uint8_t, uint16_t, uint16_t, uint32_t*, uint8_t*);
+
+uint8_t flash_content_bad;
+uint8_t lcd_file_version;
+
+#include "xram.c"
+#include "listen.c"
+
+int test_failed;
+
+// elements called by the dispatch, counted by element
+static uint8_t	called[LISTEN_ELEMENTS];
+// calls of check functions
+static uint32_t	checks;
+
+// objects addressed by the group message
+static uint16_t	msg_objects[EIB_MAX_MSG_OBJECTS];
+static uint8_t	msg_object_count;
+
+// listen elements of the project, their object and position
+static uint16_t	element_object[LISTEN_ELEMENTS];
+static uint8_t	element_type[LISTEN_ELEMENTS];
+static xram_far_t	element_pos[LISTEN_ELEMENTS];
+
+
+void NutThreadYield (void) {
+}
+
+void NutSleep (uint32_t ms) {
+}
+
+uint32_t NutGetSeconds (void) {
+
+	return 0;
+}
+
+uint16_t read_flash (uint8_t sector, uint16_t addr) {
+
+	return 0xffff;
+}
+
+void copy_Flash_to_XRAM_check (uint8_t sector, uint16_t addr, uint8_t bank, uint16_t dst, uint16_t size, uint32_t *crc, uint8_t *checksum) {
+}
+
+uint8_t crc_verify (uint32_t start, uint32_t size, uint32_t crc, uint32_t pos) {
+
+	return CRC_MISSING;
+}
+
+uint8_t compat_convert_listen (uint32_t flash_offset, uint32_t size, uint8_t bank, uint8_t banks) {
+
+	return 1;
+}
+
+uint8_t eib_object_addressed (uint16_t object) {
+
+uint8_t	i;
+
+	for (i = 0; i < msg_object_count; i++)
+		if (msg_objects[i] == object)
+			return 1;
+	return 0;
+}
+
+uint8_t eib_get_msg_objects (uint16_t **objects) {
+
+	*objects = msg_objects;
+	return msg_object_count;
+}
+
+// counts the call of the element at p, if the message addresses its object
+static void element_called (char *p, uint16_t object) {
+
+xram_far_t	pos;
+uint16_t	n;
+
+	checks++;
+	if (!eib_object_addressed (object))
+		return;
+	pos = XRAM_FAR(xram_bank, (uint16_t) (p - (char*) XRAM_BASE_ADDRESS));
+	for (n = 0; n < LISTEN_ELEMENTS; n++)
+		if (element_pos[n] == pos)
+			called[n]++;
+}
+
+void check_backlight_object (char *p) {
+
+	element_called (p, ((_O_BACKLIGHT_t*) p)->eib_object_listen);
+}
+
+void check_warning_object (char *p) {
+
+	element_called (p, ((_O_WARNING_t*) p)->warning_object_id);
+}
+
+void check_timeout_object (char *p) {
+
+	element_called (p, ((_O_TIMEOUT_t*) p)->eib_object_listen);
+}
+
+void init_backlight_object (char *p) {
+}
+
+void init_led_object (char *p) {
+}
+
+void init_timeout_object (char *p) {
+}
+
+void check_led_object (char *p, uint8_t flags) {
+}
+
+void tick_timeout_object (char *p) {
+}
+
+uint8_t get_timeout_object_counter (char *p, uint16_t object, uint16_t *val) {
+
+	return 0;
+}
+
+
+// puts an element behind pos like the XRAM loader, returns its address
+static char* put_element (xram_far_t *pos, uint8_t size) {
+
+char	*p;
+
+	if (XRAM_FAR_OFFSET(*pos) + size > XRAM_BANK_USABLE) {
+		*xram_far_select (*pos) = 0;
+		*pos = XRAM_FAR_NEXT_BANK(*pos);
+	}
+	p = xram_far_select (*pos);
+	memset (p, 0, size);
+	p[0] = size;
+	*pos += size;
+	return p;
+}
+
+// builds the listen elements: backlight, warning, timeout and LED elements in turn.
+// Most objects have one element, every 25th element listens to object 1.
+static void build_listen_elements (void) {
+
+xram_far_t	pos;
+char	*p;
+uint16_t	n;
+uint16_t	object;
+
+	xram_init ();
+	listen_descriptions = XRAM_FAR(xram_alloc (1), 0);
+	pos = listen_descriptions + sizeof (_LISTEN_DESCRIPTOR_t);
+
+	for (n = 0; n < LISTEN_ELEMENTS; n++) {
+		object = (n % 25) ? (n * 7) % EIB_MAX_OBJECTS : 1;
+		element_object[n] = object;
+		switch (n % 4) {
+			case 0:
+				p = put_element (&pos, sizeof (_O_BACKLIGHT_t));
+				((_O_BACKLIGHT_t*) p)->element_type = LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE;
+				((_O_BACKLIGHT_t*) p)->eib_object_listen = object;
+			break;
+			case 1:
+				p = put_element (&pos, sizeof (_O_WARNING_t));
+				((_O_WARNING_t*) p)->element_type = LISTEN_ELEMENT_TYPE_WARNING;
+				((_O_WARNING_t*) p)->warning_object_id = object;
+			break;
+			case 2:
+				p = put_element (&pos, sizeof (_O_TIMEOUT_t));
+				((_O_TIMEOUT_t*) p)->element_type = LISTEN_ELEMENT_TIMEOUT;
+				((_O_TIMEOUT_t*) p)->eib_object_listen = object;
+			break;
+			default:
+				p = put_element (&pos, sizeof (_O_LED_t));
+				((_O_LED_t*) p)->element_type = LISTEN_ELEMENT_TYPE_LED;
+				((_O_LED_t*) p)->eib_object_listen = object;
+			break;
+		}
+		element_type[n] = ((_LISTEN_ELEMENT_t*) p)->element_type;
+		element_pos[n] = XRAM_FAR(xram_bank, (uint16_t) (p - (char*) XRAM_BASE_ADDRESS));
+	}
+	((_LISTEN_DESCRIPTOR_t*) xram_far_select (listen_descriptions))->element_count = LISTEN_ELEMENTS;
+	listen_descriptions_validated = 1;
+}
+
+// dispatch of the firmware before the registry: every element checks the message
+static void listen_process_msg_walk (void) {
+
+_XRAM_ITERATOR_t	it;
+char	*p;
+
+	listen_iterator_init (&it);
+	while ((p = xram_iterator_next (&it))) {
+		switch (((_LISTEN_ELEMENT_t*) p)->element_type) {
+			case LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE:
+			case LISTEN_ELEMENT_TYPE_BACKLIGHT_ACTIVE:
+				check_backlight_object (p);
+			break;
+			case LISTEN_ELEMENT_TYPE_WARNING:
+				check_warning_object (p);
+			break;
+			case LISTEN_ELEMENT_TIMEOUT:
+				check_timeout_object (p);
+			break;
+		}
+	}
+}
+
+// sends one group message to each object and checks the called elements
+// dispatch: 0 walk over all elements, 1 registry
+static void run (uint8_t dispatch, uint32_t *check_count, uint32_t *bank_writes) {
+
+uint16_t	object;
+uint16_t	n;
+uint8_t		expected;
+
+	checks = 0;
+	xram_bank_writes = 0;
+	for (object = 0; object < EIB_MAX_OBJECTS; object++) {
+		memset (called, 0, sizeof (called));
+		msg_objects[0] = object;
+		msg_object_count = 1;
+		if (dispatch)
+			lcd_listen_process_msg ();
+		else listen_process_msg_walk ();
+		for (n = 0; n < LISTEN_ELEMENTS; n++) {
+			expected = (element_type[n] != LISTEN_ELEMENT_TYPE_LED) && (element_object[n] == object);
+			if (called[n] != expected) {
+				printf ("dispatch %u: object %u, element %u called %u times\n", dispatch, object, n, called[n]);
+				test_failed++;
+				return;
+			}
+		}
+	}
+	*check_count = checks;
+	*bank_writes = xram_bank_writes;
+}
+
+int main (void) {
+
+uint32_t	walk_checks, walk_writes;
+uint32_t	registry_checks, registry_writes;
+
+	xram_bank = 0xff;
+	build_listen_elements ();
+	lcd_init_listen_objects ();
+
+	run (0, &walk_checks, &walk_writes);
+	run (1, &registry_checks, &registry_writes);
+	CHECK (registry_checks < walk_checks);
+
+	printf ("test_listen: %u elements, %u messages\n", LISTEN_ELEMENTS, EIB_MAX_OBJECTS);
+	printf ("  walk:     %lu element checks, %lu bank writes\n", (unsigned long) walk_checks, (unsigned long) walk_writes);
+	printf ("  registry: %lu element checks, %lu bank writes\n", (unsigned long) registry_checks, (unsigned long) registry_writes);
+	printf ("test_listen: %s\n", test_failed ? "FAILED" : "ok");
+	return test_failed ? 1 : 0;
+}
@@ -0,0 +1,196 @@
+/** \file test_objects.c
+ *  \brief Host stress test of the consistent object value reads
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	EIBObjects.c is compiled with an emulated XRAM, in which each thread
+ *	selects its own bank. A writer thread updates 4 byte objects by
+ *	eib_objects_process_msg(), all bytes of a value are equal. Reader threads
+ *	run preemptively at the same time and read the values by
+ *	eib_get_object_data(), which must never return a value of mixed writes.
+ *	For comparison, a reader copies the values without the sequence counter
+ *	and counts the mixed values it gets.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include <pthread.h>
+#include <sched.h>
+#include "host.h"
+#include "MemoryMap.h"
+#include "crc.h"
+#include "EIBLayers.h"
+#include "dpt.h"
+#include "assoc_tab.h"
+#include "EIBObjects.h"
+
+#define OBJECTS			64
+#define WRITES			2000000L
+#define READERS			2
+#define XRAM_BANKS		16
+
+// emulated XRAM, the selected bank is part of the thread context
+static uint8_t	host_xram_banks[XRAM_BANKS][XRAM_BANK_SIZE];
+static __thread uint8_t	host_xram_bank;
+
+#undef XRAM_BASE_ADDRESS
+#define XRAM_BASE_ADDRESS	((uintptr_t) host_xram_banks[host_xram_bank])
+#define	XRAM_SELECT_BLOCK(blk)		(host_xram_bank = (blk))
+#define	XRAM_GET_SELECTED_BLOCK		host_xram_bank
+
+#define min(a,b)  ( (a)<(b) ? (a) : (b) )
+#define max(a,b)  ( (a)>(b) ? (a) : (b) )
+
+void copy_Flash_to_XRAM_check (uint8_t, uint16_t, uint8_t, uint16_t, uint16_t, uint32_t*, uint8_t*);
+void xram_yield (void);
+void read_sweep_object_received (uint16_t);
+void snapshot_object_changed (void);
+
+#include "dpt.c"
+#include "EIBObjects.c"
+
+int test_failed;
+
+// writer state
+static volatile int	writer_done;
+// reader results
+static long	reader_reads[READERS +1];
+static long	reader_mixed[READERS +1];
+static long	reader_yields;
+
+
+void copy_Flash_to_XRAM_check (uint8_t sector, uint16_t addr, uint8_t bank, uint16_t dst, uint16_t size, uint32_t *crc, uint8_t *checksum) {
+}
+
+uint8_t crc_verify (uint32_t start, uint32_t size, uint32_t crc, uint32_t pos) {
+
+	return CRC_MISSING;
+}
+
+char eib_G_DATA_request (uint16_t address, uint8_t *data, uint8_t len) {
+
+	return 1;
+}
+
+uint16_t get_object_count (void) {
+
+	return OBJECTS;
+}
+
+// group address n is associated with object n
+uint8_t get_associated_objects (uint16_t address, uint16_t *objects, uint8_t max) {
+
+	objects[0] = address % OBJECTS;
+	return 1;
+}
+
+void read_sweep_object_received (uint16_t object) {
+}
+
+void snapshot_object_changed (void) {
+}
+
+// the readers wait for the writer
+void xram_yield (void) {
+
+uint8_t	bank;
+
+	bank = host_xram_bank;
+	__sync_fetch_and_add (&reader_yields, 1);
+	sched_yield ();
+	XRAM_SELECT_BLOCK(bank);
+}
+
+
+// checks, if all bytes of a value are equal
+static uint8_t value_mixed (uint8_t *data) {
+
+	return (data[1] != data[0]) || (data[2] != data[0]) || (data[3] != data[0]);
+}
+
+static void* writer (void *arg) {
+
+uint8_t	data[4];
+long	i;
+
+	host_xram_bank = 0;
+	for (i = 0; i < WRITES; i++) {
+		memset (data, (i / OBJECTS) & 0xff, sizeof (data));
+		eib_objects_process_msg (i, data, sizeof (data), APCI_VALUE_WRITE);
+	}
+	writer_done = 1;
+	return NULL;
+}
+
+// reads the values by eib_get_object_data()
+static void* reader (void *arg) {
+
+long	n = (long) arg;
+uint8_t	data[4];
+uint16_t	object;
+
+	host_xram_bank = 0;
+	for (object = 0; !writer_done; object = (object +1) % OBJECTS) {
+		eib_get_object_data (object, data, sizeof (data));
+		reader_reads[n]++;
+		if (value_mixed (data))
+			reader_mixed[n]++;
+	}
+	return NULL;
+}
+
+// copies the values without the sequence counter
+static void* reader_unguarded (void *arg) {
+
+long	n = (long) arg;
+uint8_t	data[4];
+uint8_t	*p;
+uint8_t	size;
+uint16_t	object;
+
+	host_xram_bank = 0;
+	for (object = 0; !writer_done; object = (object +1) % OBJECTS) {
+		p = eib_object_data_ptr (object, &size);
+		memcpy (data, (void*) p, sizeof (data));
+		reader_reads[n]++;
+		if (value_mixed (data))
+			reader_mixed[n]++;
+	}
+	return NULL;
+}
+
+int main (void) {
+
+pthread_t	threads[READERS +2];
+uint8_t		*ps;
+long		n;
+
+	// all objects have 4 bytes
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
+	ps = (uint8_t*) (XRAM_BASE_ADDRESS + EIB_OBJECT_SIZE_TABLE);
+	memset (ps, 4, OBJECTS);
+	object_size_count = OBJECTS;
+	eib_object_init ();
+	CHECK (eib_object_count == OBJECTS);
+
+	for (n = 0; n < READERS; n++)
+		pthread_create (&threads[n], NULL, reader, (void*) n);
+	pthread_create (&threads[READERS], NULL, reader_unguarded, (void*) (long) READERS);
+	pthread_create (&threads[READERS +1], NULL, writer, NULL);
+	for (n = 0; n < READERS +2; n++)
+		pthread_join (threads[n], NULL);
+
+	printf ("test_objects: %ld writes\n", WRITES);
+	for (n = 0; n < READERS; n++) {
+		printf ("  reader %ld:    %ld reads, %ld mixed values\n", n, reader_reads[n], reader_mixed[n]);
+		CHECK (reader_reads[n] > 0);
+		CHECK (reader_mixed[n] == 0);
+	}
+	printf ("  readers waited %ld times for the writer\n", reader_yields);
+	printf ("  without sequence counter: %ld reads, %ld mixed values\n", reader_reads[READERS], reader_mixed[READERS]);
+	printf ("test_objects: %s\n", test_failed ? "FAILED" : "ok");
+	return test_failed ? 1 : 0;
+}
@@ -0,0 +1,286 @@
+/** \file xram.c
+ *  \brief Functions for the XRAM bank allocator
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- allocate consecutive XRAM banks for sections, caches and buffers
+ *	- load sections from Flash into several banks
+ *	- iterate elements of sections spanning several banks
+ *	- keep the selected bank of a thread across thread switches
+ *
+ *	Only one 8 kB bank is visible at XRAM_BASE_ADDRESS. Elements are
+ *	accessed by near pointers while their bank is selected, so the loader
+ *	never lets an element cross a bank border.
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "System.h"
+#include "xram.h"
+
+// allocated banks, one bit per bank
+uint8_t xram_bank_used[(XRAM_DYNAMIC_LAST_PAGE +8) / 8];
+
+// shadow of the CPLD bank register, the CPLD state after reset is unknown
+uint8_t xram_bank = 0xff;
+// bank write statistics
+uint16_t xram_bank_writes;
+uint16_t xram_bank_writes_per_s;
+uint32_t xram_statistics_second;
+
+static uint8_t xram_is_used (uint8_t bank) {
+
+	return xram_bank_used[bank >> 3] & (1 << (bank & 0x07));
+}
+
+static void xram_set_used (uint8_t bank, uint8_t used) {
+
+	if (used)
+		xram_bank_used[bank >> 3] |= 1 << (bank & 0x07);
+	else xram_bank_used[bank >> 3] &= ~(1 << (bank & 0x07));
+}
+
+// mark all dynamic banks free, called before a project is loaded
+void xram_init (void) {
+
+	memset (xram_bank_used, 0, sizeof (xram_bank_used));
+}
+
+// allocate consecutive banks
+// returns the first bank, 0 if there are not enough free banks
+uint8_t xram_alloc (uint8_t banks) {
+
+uint8_t	first;
+uint8_t	i;
+
+	if (!banks)
+		return 0;
+
+	for (first = XRAM_DYNAMIC_FIRST_PAGE; first + banks -1 <= XRAM_DYNAMIC_LAST_PAGE; first++) {
+		for (i = 0; i < banks; i++)
+			if (xram_is_used (first + i))
+				break;
+		if (i == banks) {
+			for (i = 0; i < banks; i++)
+				xram_set_used (first + i, 1);
+			return first;
+		}
+		// continue behind the used bank
+		first += i;
+	}
+#ifdef LCD_DEBUG
+	printf_P (PSTR("\nXRAM: no %d free banks"), banks);
+#endif
+	return 0;
+}
+
+// free banks allocated by xram_alloc()
+void xram_free (uint8_t bank, uint8_t banks) {
+
+	for (; banks; banks--, bank++)
+		if ((bank >= XRAM_DYNAMIC_FIRST_PAGE) && (bank <= XRAM_DYNAMIC_LAST_PAGE))
+			xram_set_used (bank, 0);
+}
+
+// number of free dynamic banks
+uint8_t xram_get_free_banks (void) {
+
+uint8_t	bank;
+uint8_t	n;
+
+	n = 0;
+	for (bank = XRAM_DYNAMIC_FIRST_PAGE; bank <= XRAM_DYNAMIC_LAST_PAGE; bank++)
+		if (!xram_is_used (bank))
+			n++;
+	return n;
+}
+
+// number of banks required for a section of size Bytes, including the padding
+// returns 0, if the section is too big
+uint8_t xram_section_banks (uint32_t size) {
+
+uint32_t banks;
+
+	banks = (size + XRAM_BANK_USABLE -1) / XRAM_BANK_USABLE;
+	if (banks > XRAM_SECTION_MAX_BANKS)
+		return 0;
+	return banks ? banks : 1;
+}
+
+// select bank of far pointer and return its address
+char* xram_far_select (xram_far_t f) {
+
+	XRAM_SELECT_BLOCK(XRAM_FAR_BANK(f));
+	return (char*) XRAM_BASE_ADDRESS + XRAM_FAR_OFFSET(f);
+}
+
+// get byte from Flash position
+static uint8_t xram_flash_byte (uint32_t pos) {
+
+uint16_t fdata;
+
+	fdata = read_flash ((pos >> 16) & 0xff, (pos >> 1) & 0x7fff);
+	return (pos & 0x01) ? (fdata >> 8) & 0xff : fdata & 0xff;
+}
+
+// start loading a section
+// bank, banks: banks allocated for the section
+// flash_offset: start of the section in Flash, d23-d16: sector, d15-d0: byte offset
+void xram_loader_init (_XRAM_LOADER_t *ld, uint8_t bank, uint8_t banks, uint32_t flash_offset) {
+
+	ld->dst = XRAM_FAR(bank, 0);
+	ld->end = XRAM_FAR(bank + banks, 0);
+	ld->block = ld->dst;
+	ld->flash = flash_offset;
+	ld->checksum = 0;
+	ld->start = flash_offset;
+	ld->crc = CRC32_INIT;
+	ld->crc_pos = flash_offset;
+	ld->crc_linear = 1;
+}
+
+// load a block from Flash, the block does not cross a bank border
+// size: size of the block, max. XRAM_BANK_SIZE
+// returns 0 if ok, 2 if the block does not fit into the section
+uint8_t xram_load_block (_XRAM_LOADER_t *ld, uint16_t size) {
+
+	// move block to the next bank and mark the gap
+	if (XRAM_FAR_OFFSET(ld->dst) + (uint32_t) size > XRAM_BANK_SIZE) {
+		*xram_far_select (ld->dst) = 0;
+		ld->dst = XRAM_FAR_NEXT_BANK(ld->dst);
+	}
+	if (ld->dst + size > ld->end)
+		return 2;
+	ld->block = ld->dst;
+
+	// the CRC is calculated while copying, as long as the blocks follow each other in Flash
+	if (ld->flash != ld->crc_pos)
+		ld->crc_linear = 0;
+	copy_Flash_to_XRAM_check ((ld->flash >> 16) & 0xff, ld->flash & 0xffff,
+							  XRAM_FAR_BANK(ld->block), XRAM_FAR_OFFSET(ld->block), size,
+							  ld->crc_linear ? &ld->crc : NULL, &ld->checksum);
+	ld->flash += size;
+	if (ld->crc_linear)
+		ld->crc_pos = ld->flash;
+	ld->dst += size;
+
+	return 0;
+}
+
+// load elements from Flash, the first byte of each element is its size
+// returns 0 if ok, 1 on an invalid element size, 2 if the elements do not fit into the section
+uint8_t xram_load_elements (_XRAM_LOADER_t *ld, uint16_t count) {
+
+uint8_t	size;
+uint8_t	result;
+
+	for (; count; count--) {
+		size = xram_flash_byte (ld->flash);
+		if (!size)
+			return 1;
+		result = xram_load_block (ld, size);
+		if (result)
+			return result;
+	}
+	return 0;
+}
+
+// verify a loaded section of size Bytes
+// The CRC-32 of the section is checked, if the project has a CRC table. The CRC of
+// the bytes not loaded in Flash order is calculated from Flash. Without a CRC table,
+// the XOR of all loaded bytes must be 0.
+// returns 0 if ok, 1 if invalid
+uint8_t xram_loader_verify (_XRAM_LOADER_t *ld, uint32_t size) {
+
+uint8_t	result;
+
+	result = crc_verify (ld->start, size, ld->crc_linear ? ld->crc : CRC32_INIT,
+						 ld->crc_linear ? ld->crc_pos : ld->start);
+	if (result == CRC_MISSING)
+		return ld->checksum ? 1 : 0;
+	return result;
+}
+
+// start iterating elements
+// bank: bank variable of the section, set to the bank of each element
+// first: position of the first element
+// count: number of elements
+void xram_iterator_init (_XRAM_ITERATOR_t *it, uint8_t *bank, xram_far_t first, uint16_t count) {
+
+	it->pos = first;
+	it->count = count;
+	it->bank = bank;
+}
+
+// get next element with its bank selected
+// returns NULL, if there are no more elements
+char* xram_iterator_next (_XRAM_ITERATOR_t *it) {
+
+char	*p;
+
+	if (!it->count)
+		return NULL;
+	it->count--;
+
+	p = xram_far_select (it->pos);
+	// element has been moved to the next bank
+	if (!*p) {
+		it->pos = XRAM_FAR_NEXT_BANK(it->pos);
+		p = xram_far_select (it->pos);
+	}
+	*it->bank = XRAM_FAR_BANK(it->pos);
+	it->pos += *(uint8_t*) p;
+
+	return p;
+}
+
+// Nut/OS switches threads only, when the running thread waits, sleeps or yields.
+// Any other thread may select other banks meanwhile, so the calling thread
+// keeps its bank on its own stack.
+
+// let other threads run, the bank of the calling thread is kept
+void xram_yield (void) {
+
+uint8_t	bank;
+
+	bank = xram_bank;
+	NutThreadYield ();
+	XRAM_SELECT_BLOCK(bank);
+}
+
+// sleep ms milliseconds, the bank of the calling thread is kept
+void xram_sleep (uint32_t ms) {
+
+uint8_t	bank;
+
+	bank = xram_bank;
+	NutSleep (ms);
+	XRAM_SELECT_BLOCK(bank);
+}
+
+// latch the bank writes of the last second, call from the main loop
+void xram_statistics (void) {
+
+uint32_t	now;
+
+	now = NutGetSeconds ();
+	if (now == xram_statistics_second)
+		return;
+	xram_bank_writes_per_s = xram_bank_writes / (now - xram_statistics_second);
+	xram_bank_writes = 0;
+	xram_statistics_second = now;
+#ifdef LCD_DEBUG
+	if (xram_bank_writes_per_s > XRAM_BANK_WRITES_WARNING)
+		printf_P (PSTR("\nXRAM: %u bank writes/s"), xram_bank_writes_per_s);
+#endif
+}
+
+// get CPLD bank writes in the last second
+uint16_t xram_get_bank_writes (void) {
+
+	return xram_bank_writes_per_s;
+}
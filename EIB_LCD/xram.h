@@ -0,0 +1,127 @@
+/** \file xram.h
+ *  \brief Constants and definitions for the XRAM bank allocator
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _XRAM_H_
+#define _XRAM_H_
+
+#include <stdint.h>
+#include "MemoryMap.h"
+
+/**
+* @brief far pointer into the banked XRAM
+*
+* d20-d13: bank, d12-d0: offset in the bank. Adding to a far pointer
+* moves into the following banks.
+*/
+typedef uint32_t xram_far_t;
+
+#define XRAM_FAR(bank, offset)		(((xram_far_t) (bank) << 13) | (offset))
+#define XRAM_FAR_BANK(f)			((uint8_t) ((f) >> 13))
+#define XRAM_FAR_OFFSET(f)			((uint16_t) (f) & (XRAM_BANK_SIZE -1))
+// start of the bank following the bank of f
+#define XRAM_FAR_NEXT_BANK(f)		(((f) | (XRAM_BANK_SIZE -1)) +1)
+
+// max. number of banks of a section, offsets in sections are 16 bit
+#define XRAM_SECTION_MAX_BANKS		8
+// bytes of a bank used for elements, the rest is reserved for padding
+#define XRAM_BANK_USABLE			(XRAM_BANK_SIZE - 0x100)
+// debug builds report more bank writes per second
+#define XRAM_BANK_WRITES_WARNING	5000
+
+/**
+* @brief state of a section loaded from Flash into XRAM
+*
+* Blocks and elements never cross a bank border. A block which does not fit
+* into the rest of a bank is moved to the next bank, the gap is marked
+* with an element size of 0.
+*/
+typedef struct {
+xram_far_t	dst;		// next free XRAM position
+xram_far_t	end;		// end of the allocated banks
+xram_far_t	block;		// XRAM position of the last loaded block
+uint32_t	flash;		// next Flash position, d23-d16: sector, d15-d0: byte offset
+uint8_t		checksum;	// XOR of all loaded bytes
+uint32_t	start;		// start of the section in Flash
+uint32_t	crc;		// CRC-32 of the section from start up to crc_pos
+uint32_t	crc_pos;	// end of the bytes in crc
+uint8_t		crc_linear;	// blocks have been loaded in Flash order, crc is valid
+} _XRAM_LOADER_t;
+
+/**
+* @brief iterator over the elements of a section
+*
+* The iterator selects the bank of each element and stores it in the bank
+* variable of the section, so element functions can select it again.
+*/
+typedef struct {
+xram_far_t	pos;		// next element
+uint16_t	count;		// number of elements left
+uint8_t		*bank;		// bank variable of the section
+} _XRAM_ITERATOR_t;
+
+// bank selected in the CPLD, 0xff until the first selection
+extern uint8_t xram_bank;
+// number of CPLD bank writes
+extern uint16_t xram_bank_writes;
+
+/**
+* @brief select a bank in the CPLD
+*
+* The CPLD register is only written, if another bank is selected. The bank
+* is part of the thread context: a thread saves it before it may give up
+* the CPU and selects it again, when it continues (see xram_yield()).
+*/
+static inline void xram_select_block (uint8_t bank) {
+
+	if (bank != xram_bank) {
+		xram_bank = bank;
+		*((volatile uint8_t*) (CPLD_BASE_ADDR + RAM_BANK_ADDR)) = bank;
+		xram_bank_writes++;
+	}
+}
+
+// mark all dynamic banks free
+void xram_init (void);
+// allocate consecutive banks, returns the first bank or 0
+uint8_t xram_alloc (uint8_t);
+// free banks allocated by xram_alloc()
+void xram_free (uint8_t, uint8_t);
+// number of free dynamic banks
+uint8_t xram_get_free_banks (void);
+// number of banks required for a section of size Bytes
+uint8_t xram_section_banks (uint32_t);
+
+// select bank of far pointer and return its address
+char* xram_far_select (xram_far_t);
+
+// start loading a section into banks
+void xram_loader_init (_XRAM_LOADER_t*, uint8_t, uint8_t, uint32_t);
+// load a block of size Bytes, returns 0 if ok, 2 if it does not fit
+uint8_t xram_load_block (_XRAM_LOADER_t*, uint16_t);
+// load count elements, returns 0 if ok, 1 if invalid, 2 if they do not fit
+uint8_t xram_load_elements (_XRAM_LOADER_t*, uint16_t);
+// verify the section of size Bytes, returns 0 if ok, 1 if invalid
+uint8_t xram_loader_verify (_XRAM_LOADER_t*, uint32_t);
+
+// start iterating count elements at position
+void xram_iterator_init (_XRAM_ITERATOR_t*, uint8_t*, xram_far_t, uint16_t);
+// get next element with its bank selected, NULL if there is none
+char* xram_iterator_next (_XRAM_ITERATOR_t*);
+
+// give up the CPU, the bank of the calling thread is kept
+void xram_yield (void);
+void xram_sleep (uint32_t);
+// update the bank write statistics, call from the main loop
+void xram_statistics (void);
+// CPLD bank writes in the last second
+uint16_t xram_get_bank_writes (void);
+
+#endif // _XRAM_H_